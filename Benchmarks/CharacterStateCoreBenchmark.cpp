@@ -0,0 +1,419 @@
+
+#include "CharacterStateManagement/CharacterStateBatch.h"
+#include "CharacterStateManagement/CharacterStateDispatch.h"
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateRequestChannel.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Headless micro-benchmarks of the state machine core: transitions per second and ticks per second for 1 to 100k
+// simulated characters with FCharacterStateMachine and with TCharacterStateMachine<>, then spawns and despawns per second
+// with the heap allocations they make, then the batched decision pass at 1 to N chunks (N = hardware threads) over the
+// largest size, then posts per second into one request channel from 1 to 16 producer threads.
+// Usage: CharacterStateCoreBenchmark [--quick] [MaxCharacters]
+
+// ---- Allocation counting ----
+// Every operator new in this process goes through here, so the spawn benchmark can count what construction, Start() and
+// Stop() allocate.
+static std::atomic<uint64> GNumAllocations{ 0 };
+
+void* operator new(std::size_t Size)
+{
+	GNumAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* Memory = std::malloc(Size > 0 ? Size : 1))
+	{
+		return Memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t Size)
+{
+	return operator new(Size);
+}
+
+void operator delete(void* Memory) noexcept
+{
+	std::free(Memory);
+}
+
+void operator delete[](void* Memory) noexcept
+{
+	std::free(Memory);
+}
+
+void operator delete(void* Memory, std::size_t) noexcept
+{
+	std::free(Memory);
+}
+
+void operator delete[](void* Memory, std::size_t) noexcept
+{
+	std::free(Memory);
+}
+
+namespace
+{
+	/** A character with nothing but its movement inputs and its state machine (FCharacterStateMachine or TCharacterStateMachine). */
+	template <typename TMachine>
+	class TBenchCharacter final : public ICharacterStateEnvironment
+	{
+	public:
+		TBenchCharacter()
+			: Machine(*this)
+		{
+		}
+
+		virtual bool IsGrounded() const override { return bGrounded; }
+		virtual FCharacterStateVector GetLinearVelocity() const override { return Velocity; }
+		virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+		virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool) override { CapsuleHalfHeight = NewHalfHeight; }
+		virtual void OnStateChanged(ECharacterState, ECharacterState) override { ++NumTransitions; }
+		virtual const TCHAR* GetDebugName() const override { return TEXT("Bench"); }
+
+		bool bGrounded = true;
+		FCharacterStateVector Velocity;
+		float CapsuleHalfHeight = 0.f;
+		uint64 NumTransitions = 0;
+
+		TMachine Machine;
+	};
+
+	using FBenchCharacter = TBenchCharacter<FCharacterStateMachine>;
+	using FStaticBenchCharacter = TBenchCharacter<TCharacterStateMachine<>>;
+
+	struct FBenchResult
+	{
+		uint64 NumOperations = 0;
+		double Seconds = 0.0;
+
+		double PerSecond() const { return Seconds > 0.0 ? static_cast<double>(NumOperations) / Seconds : 0.0; }
+	};
+
+	double SecondsSince(uint64 StartCycles)
+	{
+		return static_cast<double>(FCharacterStateStats::Cycles() - StartCycles) * FCharacterStateStats::SecondsPerCycle();
+	}
+
+	/** Rounds so that every size does about OperationsPerRun operations in total. */
+	int32 RoundsFor(int32 NumCharacters, int32 OperationsPerCharacterRound, int64 OperationsPerRun)
+	{
+		const int64 Rounds = OperationsPerRun / (static_cast<int64>(NumCharacters) * OperationsPerCharacterRound);
+		return Rounds > 0 ? static_cast<int32>(Rounds) : 1;
+	}
+
+	/** SwitchStateByEnum() around a legal cycle, one Exit/Enter pair per call; Crouch touches the capsule. */
+	template <typename TCharacter>
+	FBenchResult RunTransitions(TCharacter* Characters, int32 NumCharacters, int64 OperationsPerRun)
+	{
+		static const ECharacterState Cycle[] = { ECharacterState::Walking, ECharacterState::Sprinting, ECharacterState::Walking, ECharacterState::Crouch, ECharacterState::Idle };
+		constexpr int32 CycleLength = sizeof(Cycle) / sizeof(Cycle[0]);
+
+		const int32 Rounds = RoundsFor(NumCharacters, CycleLength, OperationsPerRun);
+		uint64 NumBefore = 0;
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			NumBefore += Characters[Index].NumTransitions;
+		}
+
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		for (int32 Round = 0; Round < Rounds; ++Round)
+		{
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				auto& Machine = Characters[Index].Machine;
+				for (ECharacterState State : Cycle)
+				{
+					Machine.SwitchStateByEnum(State);
+				}
+			}
+		}
+
+		FBenchResult Result;
+		Result.Seconds = SecondsSince(StartCycles);
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			Result.NumOperations += Characters[Index].NumTransitions;
+		}
+		Result.NumOperations -= NumBefore;
+		return Result;
+	}
+
+	/** Tick() with scripted movement: leaving the ground, landing and speed changes, out of phase between characters. */
+	template <typename TCharacter>
+	FBenchResult RunTicks(TCharacter* Characters, int32 NumCharacters, int64 OperationsPerRun)
+	{
+		constexpr float DeltaTime = 1.f / 60.f;
+		const int32 Frames = RoundsFor(NumCharacters, 1, OperationsPerRun);
+
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		for (int32 Frame = 0; Frame < Frames; ++Frame)
+		{
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				TCharacter& Character = Characters[Index];
+				const uint32 Phase = static_cast<uint32>(Frame) + static_cast<uint32>(Index) * 7u;
+				Character.bGrounded = Phase % 40u >= 6u;
+				Character.Velocity.X = Phase % 24u < 12u ? 750.0 : 250.0;
+				if (Phase % 13u == 0u)
+				{
+					Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting);
+				}
+				Character.Machine.Tick(DeltaTime);
+			}
+		}
+
+		FBenchResult Result;
+		Result.Seconds = SecondsSince(StartCycles);
+		Result.NumOperations = static_cast<uint64>(Frames) * static_cast<uint64>(NumCharacters);
+		return Result;
+	}
+
+	struct FSpawnResult
+	{
+		FBenchResult Spawns;
+		FBenchResult Despawns;
+
+		/** Heap allocations made by one round of spawning (construction and Start()) and despawning (Stop()) all characters. */
+		uint64 NumAllocations = 0;
+	};
+
+	/**
+	 * Spawns NumCharacters characters as a streaming level or pool would (one block, then Start() on each machine) and despawns
+	 * them again (Stop(), then the block goes). The rules are interned before timing, so a round should allocate the block and
+	 * nothing per character.
+	 */
+	FSpawnResult RunSpawns(const FCharacterStateRuleSetRef& Rules, int32 NumCharacters, int64 OperationsPerRun)
+	{
+		const int32 Rounds = RoundsFor(NumCharacters, 1, OperationsPerRun);
+		FSpawnResult Result;
+		uint64 SpawnCycles = 0;
+		uint64 DespawnCycles = 0;
+		for (int32 Round = 0; Round < Rounds; ++Round)
+		{
+			const uint64 AllocationsBefore = GNumAllocations.load(std::memory_order_relaxed);
+			uint64 StartCycles = FCharacterStateStats::Cycles();
+			FBenchCharacter* Characters = new FBenchCharacter[NumCharacters];
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				Characters[Index].Machine.Start(Rules);
+			}
+			SpawnCycles += FCharacterStateStats::Cycles() - StartCycles;
+
+			StartCycles = FCharacterStateStats::Cycles();
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				Characters[Index].Machine.Stop();
+			}
+			delete[] Characters;
+			DespawnCycles += FCharacterStateStats::Cycles() - StartCycles;
+
+			const uint64 NumAllocations = GNumAllocations.load(std::memory_order_relaxed) - AllocationsBefore;
+			Result.NumAllocations = NumAllocations > Result.NumAllocations ? NumAllocations : Result.NumAllocations;
+		}
+
+		Result.Spawns.NumOperations = Result.Despawns.NumOperations = static_cast<uint64>(Rounds) * static_cast<uint64>(NumCharacters);
+		Result.Spawns.Seconds = static_cast<double>(SpawnCycles) * FCharacterStateStats::SecondsPerCycle();
+		Result.Despawns.Seconds = static_cast<double>(DespawnCycles) * FCharacterStateStats::SecondsPerCycle();
+		return Result;
+	}
+
+	struct FPostResult
+	{
+		/** Accepted posts, timed from the producers' start until the consumer has drained the last one. */
+		FBenchResult Posts;
+
+		/** Posts refused because the channel was full, each retried by its producer. */
+		uint64 NumFull = 0;
+
+		/** Drained requests that arrived out of sequence order; must be 0. */
+		uint64 NumOutOfOrder = 0;
+	};
+
+	/**
+	 * NumProducers threads post into one FCharacterStateRequestChannel, as behaviour tree services and async tasks do,
+	 * while this thread drains it as the game thread would. Measures the channel under contention.
+	 */
+	FPostResult RunPosts(int32 NumProducers, int64 OperationsPerRun)
+	{
+		const int64 PostsPerProducer = OperationsPerRun / NumProducers > 0 ? OperationsPerRun / NumProducers : 1;
+		FCharacterStateRequestChannel Channel;
+		std::atomic<uint64> NumFull{ 0 };
+		std::atomic<int32> NumProducersDone{ 0 };
+		uint64 NumDrained = 0;
+		uint32 LastSequence = 0;
+		FPostResult Result;
+
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		std::vector<std::thread> Producers;
+		for (int32 Producer = 0; Producer < NumProducers; ++Producer)
+		{
+			Producers.emplace_back([&Channel, &NumFull, &NumProducersDone, PostsPerProducer]()
+			{
+				uint64 NumProducerFull = 0;
+				for (int64 Post = 0; Post < PostsPerProducer; ++Post)
+				{
+					while (Channel.Post(static_cast<ECharacterState>(Post % NumCharacterStates)) == 0)
+					{
+						++NumProducerFull;
+						std::this_thread::yield();
+					}
+				}
+				NumFull.fetch_add(NumProducerFull, std::memory_order_relaxed);
+				NumProducersDone.fetch_add(1, std::memory_order_release);
+			});
+		}
+
+		const auto Drain = [&Channel, &NumDrained, &LastSequence, &Result]()
+		{
+			return Channel.Drain([&NumDrained, &LastSequence, &Result](ECharacterState, uint32 Sequence)
+			{
+				Result.NumOutOfOrder += Sequence == LastSequence + 1 ? 0 : 1;
+				LastSequence = Sequence;
+				++NumDrained;
+			});
+		};
+		while (NumProducersDone.load(std::memory_order_acquire) < NumProducers || !Channel.IsEmpty())
+		{
+			if (Drain() == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		Result.Posts.Seconds = SecondsSince(StartCycles);
+		for (std::thread& Producer : Producers)
+		{
+			Producer.join();
+		}
+
+		Result.Posts.NumOperations = NumDrained;
+		Result.NumFull = NumFull.load(std::memory_order_relaxed);
+		Result.NumOutOfOrder += NumDrained == static_cast<uint64>(PostsPerProducer) * NumProducers ? 0 : 1;
+		return Result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool bQuick = false;
+	int32 MaxCharacters = 100000;
+	for (int32 Arg = 1; Arg < argc; ++Arg)
+	{
+		if (std::strcmp(argv[Arg], "--quick") == 0)
+		{
+			bQuick = true;
+		}
+		else if (std::atoi(argv[Arg]) > 0)
+		{
+			MaxCharacters = std::atoi(argv[Arg]);
+		}
+	}
+	if (bQuick && MaxCharacters > 1000)
+	{
+		MaxCharacters = 1000;
+	}
+	const int64 OperationsPerRun = bQuick ? 20000 : 2000000;
+
+	FCharacterStateMachineSettings Settings;
+	Settings.DefaultCapsuleHalfHeight = 88.f;
+	const FCharacterStateRuleSetRef Rules = FCharacterStateRuleSet::Intern(CharacterStateRules::Default, Settings);
+
+	// Both machines run the same scripts from Idle, so they must end in the same states; the run fails if they do not.
+	bool bDispatchMatches = true;
+	std::printf("%10s %18s %18s %18s %18s\n", "Characters", "Transitions/s", "Ticks/s", "Static trans./s", "Static ticks/s");
+	for (int32 NumCharacters = 1; NumCharacters <= MaxCharacters; NumCharacters *= 10)
+	{
+		FBenchCharacter* Characters = new FBenchCharacter[NumCharacters];
+		FStaticBenchCharacter* StaticCharacters = new FStaticBenchCharacter[NumCharacters];
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			Characters[Index].CapsuleHalfHeight = Settings.DefaultCapsuleHalfHeight;
+			Characters[Index].Machine.Start(Rules);
+			StaticCharacters[Index].CapsuleHalfHeight = Settings.DefaultCapsuleHalfHeight;
+			StaticCharacters[Index].Machine.Start(Rules);
+		}
+
+		const FBenchResult Transitions = RunTransitions(Characters, NumCharacters, OperationsPerRun);
+		const FBenchResult Ticks = RunTicks(Characters, NumCharacters, OperationsPerRun);
+		const FBenchResult StaticTransitions = RunTransitions(StaticCharacters, NumCharacters, OperationsPerRun);
+		const FBenchResult StaticTicks = RunTicks(StaticCharacters, NumCharacters, OperationsPerRun);
+		std::printf("%10d %18.0f %18.0f %18.0f %18.0f\n", NumCharacters, Transitions.PerSecond(), Ticks.PerSecond(),
+			StaticTransitions.PerSecond(), StaticTicks.PerSecond());
+
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			bDispatchMatches &= Characters[Index].Machine.GetCurrentStateEnum() == StaticCharacters[Index].Machine.GetCurrentStateEnum()
+				&& Characters[Index].NumTransitions == StaticCharacters[Index].NumTransitions;
+		}
+
+		delete[] StaticCharacters;
+		delete[] Characters;
+	}
+	if (!bDispatchMatches)
+	{
+		std::printf("TCharacterStateMachine disagreed with FCharacterStateMachine\n");
+		return 1;
+	}
+
+	// Fails the run if spawning allocates per character, so the quick run under ctest keeps it that way.
+	constexpr uint64 MaxAllocationsPerRound = 1;
+	bool bAllocationsBounded = true;
+	std::printf("\n%10s %18s %18s %14s\n", "Characters", "Spawns/s", "Despawns/s", "Allocations");
+	for (int32 NumCharacters = 1; NumCharacters <= MaxCharacters; NumCharacters *= 10)
+	{
+		const FSpawnResult Spawns = RunSpawns(Rules, NumCharacters, OperationsPerRun / 10);
+		std::printf("%10d %18.0f %18.0f %14llu\n", NumCharacters, Spawns.Spawns.PerSecond(), Spawns.Despawns.PerSecond(),
+			static_cast<unsigned long long>(Spawns.NumAllocations));
+		bAllocationsBounded &= Spawns.NumAllocations <= MaxAllocationsPerRound;
+	}
+	// Batched evaluation scaling: decisions per second for the parallel decide step alone.
+	const int32 MaxChunks = std::thread::hardware_concurrency() > 1 ? static_cast<int32>(std::thread::hardware_concurrency()) : 1;
+	const int32 BatchFrames = RoundsFor(MaxCharacters, 1, OperationsPerRun);
+	bool bBatchMatches = true;
+	std::printf("\n%10s %10s %18s\n", "Characters", "Chunks", "Decisions/s");
+	for (int32 NumChunks = 1; ; NumChunks = NumChunks * 2 < MaxChunks ? NumChunks * 2 : MaxChunks)
+	{
+		const FCharacterStateBatchBenchmarkReport Batch = FCharacterStateBatchBenchmark::Run(MaxCharacters, BatchFrames, NumChunks);
+		const double Decisions = static_cast<double>(Batch.NumCharacters) * Batch.NumFrames;
+		std::printf("%10d %10d %18.0f\n", Batch.NumCharacters, Batch.NumChunks, Batch.DecideSeconds > 0.0 ? Decisions / Batch.DecideSeconds : 0.0);
+		bBatchMatches &= Batch.NumMismatches == 0;
+		if (NumChunks == MaxChunks)
+		{
+			break;
+		}
+	}
+	if (!bBatchMatches)
+	{
+		std::printf("The batched pass disagreed with Tick()\n");
+		return 1;
+	}
+
+	// Request channel contention: one consumer, more and more producers.
+	bool bPostsInOrder = true;
+	std::printf("\n%10s %18s %14s\n", "Producers", "Posts/s", "Full");
+	for (int32 NumProducers = 1; NumProducers <= 16; NumProducers *= 2)
+	{
+		const FPostResult Posts = RunPosts(NumProducers, OperationsPerRun);
+		std::printf("%10d %18.0f %14llu\n", NumProducers, Posts.Posts.PerSecond(), static_cast<unsigned long long>(Posts.NumFull));
+		bPostsInOrder &= Posts.NumOutOfOrder == 0;
+	}
+	if (!bPostsInOrder)
+	{
+		std::printf("The request channel lost, repeated or reordered posts\n");
+		return 1;
+	}
+
+	if (!bAllocationsBounded)
+	{
+		std::printf("Spawning made more than %llu allocation(s) per round\n", static_cast<unsigned long long>(MaxAllocationsPerRound));
+		return 1;
+	}
+	return 0;
+}
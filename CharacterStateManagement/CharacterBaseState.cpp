@@ -1,9 +1,26 @@
 
 #include "CharacterStateManagement/CharacterBaseState.h"
-#include "CharacterStateManagement/CharacterStateManagerComponent.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateLogic.h"
 
-FCharacterBaseState::FCharacterBaseState(UCharacterStateManagerComponent* InOwner, ECharacterState InState)
+FCharacterBaseState::FCharacterBaseState(FCharacterStateMachine* InOwner, ECharacterState InState)
 	: StateManager(InOwner)
 	, State(InState)
 {
 }
+
+void FCharacterBaseState::Timeout()
+{
+	if (StateManager)
+	{
+		StateManager->LeaveStateOnTimeout();
+	}
+}
+
+void FCharacterBaseState::Reconcile()
+{
+	if (StateManager)
+	{
+		CharacterStateLogic::ReconcileCapsule(*StateManager, State);
+	}
+}
@@ -1,18 +1,18 @@
 #pragma once
 
-#include "CoreMinimal.h"
-#include "CharacterStateManagement/CharacterStateEnum.h"
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
 
-class UCharacterStateManagerComponent;
+class FCharacterStateMachine;
 
 /**
  * Base class for character states. Mirrors Unity CharacterBaseState:
  * Enter() on state entry, Tick() each frame, Exit() on state exit.
+ * Engine-independent; states reach the character through their FCharacterStateMachine.
  */
 class CD_TEMP_API FCharacterBaseState
 {
 public:
-	explicit FCharacterBaseState(UCharacterStateManagerComponent* InOwner, ECharacterState InState);
+	explicit FCharacterBaseState(FCharacterStateMachine* InOwner, ECharacterState InState);
 	virtual ~FCharacterBaseState() = default;
 
 	ECharacterState GetState() const { return State; }
@@ -21,7 +21,25 @@ public:
 	virtual void Tick(float DeltaTime) {}
 	virtual void Exit() {}
 
+	/**
+	 * Continues a latent state once the condition it awaited (FCharacterStateMachine::AwaitGrounded() etc.) holds; Linkage is
+	 * the resume point it passed. A suspended state's Tick() is not called, and a switch cancels its await before Exit().
+	 */
+	virtual void Resume(int32 Linkage) {}
+
+	/**
+	 * Called once the timeout set with FCharacterStateMachine::SetStateTimeout() (or the state's MaxTimeInState) runs out.
+	 * By default leaves the state through FCharacterStateMachine::LeaveStateOnTimeout().
+	 */
+	virtual void Timeout();
+
+	/**
+	 * Reapplies this state's persistent side effects after a rollback restored it without Enter()
+	 * (FCharacterStateMachine::ReconcileSideEffects()). By default sets the capsule height the built-in states expect.
+	 */
+	virtual void Reconcile();
+
 protected:
-	UCharacterStateManagerComponent* StateManager = nullptr;
+	FCharacterStateMachine* StateManager = nullptr;
 	ECharacterState State;
 };
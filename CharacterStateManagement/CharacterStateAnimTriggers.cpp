@@ -0,0 +1,89 @@
+
+#include "CharacterStateManagement/CharacterStateAnimTriggers.h"
+#include "Animation/AnimInstance.h"
+#include "UObject/UnrealType.h"
+
+void FCharacterStateAnimTriggerBuffer::Resolve(const UAnimInstance* InAnimInstance)
+{
+	ResolvedClass = InAnimInstance ? InAnimInstance->GetClass() : nullptr;
+	for (FSlot& Slot : Slots)
+	{
+		Slot.Property = ResolvedClass ? FindFProperty<FBoolProperty>(ResolvedClass, Slot.Name) : nullptr;
+		Slot.Value.Forget();
+	}
+}
+
+FCharacterStateAnimTriggerBuffer::FSlot& FCharacterStateAnimTriggerBuffer::FindOrAddSlot(FName Trigger)
+{
+	for (FSlot& Slot : Slots)
+	{
+		if (Slot.Name == Trigger)
+		{
+			return Slot;
+		}
+	}
+
+	FSlot& Slot = Slots.Emplace_GetRef();
+	Slot.Name = Trigger;
+	Slot.Property = ResolvedClass ? FindFProperty<FBoolProperty>(ResolvedClass, Trigger) : nullptr;
+	return Slot;
+}
+
+void FCharacterStateAnimTriggerBuffer::Queue(FName Trigger, bool bValue)
+{
+	FindOrAddSlot(Trigger).Value.Queue(bValue);
+	++NumQueued;
+}
+
+void FCharacterStateAnimTriggerBuffer::Queue(const TCHAR* Trigger, bool bValue)
+{
+	for (FSlot& Slot : Slots)
+	{
+		if (Slot.Literal == Trigger)
+		{
+			Slot.Value.Queue(bValue);
+			++NumQueued;
+			return;
+		}
+	}
+
+	FSlot& Slot = FindOrAddSlot(FName(Trigger));
+	if (!Slot.Literal)
+	{
+		Slot.Literal = Trigger;
+	}
+	Slot.Value.Queue(bValue);
+	++NumQueued;
+}
+
+int32 FCharacterStateAnimTriggerBuffer::Flush(UAnimInstance* AnimInstance, TFunctionRef<void(FName Trigger, bool bValue)> Fallback, int32& OutNumApplied)
+{
+	OutNumApplied = 0;
+	if (NumQueued == 0)
+	{
+		return 0;
+	}
+
+	for (FSlot& Slot : Slots)
+	{
+		bool bValue = false;
+		if (!Slot.Value.Take(bValue))
+		{
+			continue;
+		}
+
+		if (Slot.Property && AnimInstance)
+		{
+			Slot.Property->SetPropertyValue_InContainer(AnimInstance, bValue);
+		}
+		else
+		{
+			Fallback(Slot.Name, bValue);
+		}
+		++OutNumApplied;
+	}
+
+	const int32 NumCancelled = NumQueued - OutNumApplied;
+	NumQueued = 0;
+	return NumCancelled;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/**
+ * One trigger's value across a frame: the last value queued wins, and Take() only dispatches it if it differs from the
+ * last value applied. Engine-free, so the cancelling rules build and test without the AnimInstance.
+ */
+struct FCharacterStateAnimTriggerValue
+{
+	/** Last value applied and value to apply: -1 unknown/none, 0 reset, 1 set. */
+	int8 Applied = -1;
+	int8 Pending = -1;
+
+	void Queue(bool bValue)
+	{
+		Pending = bValue ? 1 : 0;
+	}
+
+	/** Consumes the pending value; returns true, with bOutValue set, if it must be dispatched. */
+	bool Take(bool& bOutValue)
+	{
+		const bool bDispatch = Pending >= 0 && Pending != Applied;
+		if (bDispatch)
+		{
+			bOutValue = Pending != 0;
+			Applied = Pending;
+		}
+		Pending = -1;
+		return bDispatch;
+	}
+
+	/** The receiving AnimInstance changed, so the value it holds is unknown and the next queued one is dispatched. */
+	void Forget()
+	{
+		Applied = -1;
+	}
+};
+
+#if defined(WITH_ENGINE)
+
+class UAnimInstance;
+class UClass;
+class FBoolProperty;
+
+/**
+ * Per-character buffer between the state machine and the AnimInstance. Triggers set or reset during a frame are recorded,
+ * last value wins, and applied by one Flush() before the anim update; a trigger that ends the frame where it started (a set
+ * and reset pair, e.g. Idle -> Walking -> Idle) is never dispatched. Each trigger name is resolved once per AnimInstance
+ * class to a bool property that Flush() writes directly; triggers without a matching property go to a fallback instead.
+ */
+class CD_TEMP_API FCharacterStateAnimTriggerBuffer
+{
+public:
+	/** Resolves every known trigger against InAnimInstance's class and forgets the values applied to the previous instance. */
+	void Resolve(const UAnimInstance* InAnimInstance);
+
+	/** Records a set (bValue = true) or reset of a trigger. */
+	void Queue(FName Trigger, bool bValue);
+
+	/** Same, for the TCHAR literals of the state objects; the literal's address is cached so the FName is built once. */
+	void Queue(const TCHAR* Trigger, bool bValue);
+
+	bool HasPending() const { return NumQueued > 0; }
+
+	/**
+	 * Applies the triggers whose value differs from the last one applied: writes the resolved property of AnimInstance, or
+	 * calls Fallback when there is none. Returns the number of queued set/reset calls that did not need to be dispatched.
+	 */
+	int32 Flush(UAnimInstance* AnimInstance, TFunctionRef<void(FName Trigger, bool bValue)> Fallback, int32& OutNumApplied);
+
+private:
+	struct FSlot
+	{
+		FName Name;
+
+		/** First TCHAR literal queued for this trigger, if any. */
+		const TCHAR* Literal = nullptr;
+
+		/** Bool property of ResolvedClass named like the trigger, or nullptr. */
+		FBoolProperty* Property = nullptr;
+
+		FCharacterStateAnimTriggerValue Value;
+	};
+
+	FSlot& FindOrAddSlot(FName Trigger);
+
+	/** A handful of triggers per character; searched linearly. */
+	TArray<FSlot, TInlineAllocator<8>> Slots;
+
+	/** Class properties were resolved against; kept alive by the AnimInstance that uses it. */
+	const UClass* ResolvedClass = nullptr;
+
+	/** Set/reset calls since the last Flush(). */
+	int32 NumQueued = 0;
+};
+
+#endif
@@ -0,0 +1,243 @@
+
+#include "CharacterStateManagement/CharacterStateBatch.h"
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+#include <atomic>
+#include <thread>
+
+namespace
+{
+	/** A character with nothing but its scripted movement inputs. */
+	class FBatchBenchCharacter final : public ICharacterStateEnvironment
+	{
+	public:
+		FBatchBenchCharacter()
+			: Machine(*this)
+		{
+		}
+
+		virtual bool IsGrounded() const override { return bGrounded; }
+		virtual FCharacterStateVector GetLinearVelocity() const override { return Velocity; }
+		virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+		virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool) override { CapsuleHalfHeight = NewHalfHeight; }
+		virtual const TCHAR* GetDebugName() const override { return TEXT("BatchBench"); }
+
+		/** Leaving the ground, landing, speed changes and sprint requests, out of phase between characters. */
+		void Script(int32 Index, int32 Frame)
+		{
+			const uint32 Phase = static_cast<uint32>(Frame) + static_cast<uint32>(Index) * 7u;
+			bGrounded = Phase % 40u >= 6u;
+			Velocity = FCharacterStateVector();
+			Velocity.X = Phase % 24u < 12u ? 750.0 : 250.0;
+			if (Phase % 13u == 0u)
+			{
+				Machine.SwitchStateByEnum(ECharacterState::Sprinting);
+			}
+		}
+
+		bool bGrounded = true;
+		FCharacterStateVector Velocity;
+		float CapsuleHalfHeight = 0.f;
+
+		FCharacterStateMachine Machine;
+	};
+
+	struct FBatchPendingSwitch
+	{
+		int32 Index;
+		ECharacterState Target;
+	};
+
+	/** Gathered inputs, one array per field like the subsystem's, and two output lists per chunk. */
+	struct FBatchFrame
+	{
+		ECharacterState* States = nullptr;
+		float* StateTimes = nullptr;
+		bool* Grounded = nullptr;
+		float* HorizontalSpeedsSquared = nullptr;
+		const FCharacterStateRuleSet* Rules = nullptr;
+
+		int32 NumCharacters = 0;
+		int32 ChunkSize = 0;
+		FBatchPendingSwitch* Switches = nullptr;
+		int32* NumChunkSwitches = nullptr;
+		int32* Suppressed = nullptr;
+		int32* NumChunkSuppressed = nullptr;
+
+		/**
+		 * Chunk Chunk's switches go to Switches[Chunk * ChunkSize ..] and the characters whose switch was held back to
+		 * Suppressed[Chunk * ChunkSize ..], at most one entry per character in either.
+		 */
+		void Decide(int32 Chunk)
+		{
+			const int32 Begin = Chunk * ChunkSize;
+			const int32 End = Begin + ChunkSize < NumCharacters ? Begin + ChunkSize : NumCharacters;
+			FBatchPendingSwitch* Out = Switches + Begin;
+			int32* OutSuppressed = Suppressed + Begin;
+			int32 Count = 0;
+			int32 NumSuppressed = 0;
+			for (int32 Index = Begin; Index < End; ++Index)
+			{
+				bool bSuppressed = false;
+				const ECharacterState Target = FCharacterStateMachine::EvaluateTransition(States[Index], Grounded[Index], HorizontalSpeedsSquared[Index],
+					StateTimes[Index], Rules->Table, Rules->Settings, bSuppressed);
+				if (Target != States[Index])
+				{
+					Out[Count++] = { Index, Target };
+				}
+				else if (bSuppressed)
+				{
+					OutSuppressed[NumSuppressed++] = Index;
+				}
+			}
+			NumChunkSwitches[Chunk] = Count;
+			NumChunkSuppressed[Chunk] = NumSuppressed;
+		}
+	};
+}
+
+FCharacterStateBatchBenchmarkReport FCharacterStateBatchBenchmark::Run(int32 NumCharacters, int32 NumFrames, int32 NumChunks)
+{
+	constexpr float DeltaTime = 1.f / 60.f;
+
+	FCharacterStateBatchBenchmarkReport Report;
+	Report.NumCharacters = NumCharacters > 0 ? NumCharacters : 1;
+	Report.NumFrames = NumFrames > 0 ? NumFrames : 1;
+	Report.NumChunks = NumChunks < 1 ? 1 : (NumChunks > Report.NumCharacters ? Report.NumCharacters : NumChunks);
+
+	FCharacterStateMachineSettings Settings;
+	Settings.DefaultCapsuleHalfHeight = 88.f;
+	Settings.SprintingHysteresis = 40.f;
+	Settings.MinDwellTime[static_cast<uint8>(ECharacterState::Sprinting)] = 0.1f;
+	const FCharacterStateRuleSetRef Rules = FCharacterStateRuleSet::Intern(CharacterStateRules::Default, Settings);
+
+	FBatchBenchCharacter* Batched = new FBatchBenchCharacter[Report.NumCharacters];
+	FBatchBenchCharacter* Serial = new FBatchBenchCharacter[Report.NumCharacters];
+	for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+	{
+		Batched[Index].Machine.Start(Rules);
+		Serial[Index].Machine.Start(Rules);
+	}
+
+	FBatchFrame Frame;
+	Frame.States = new ECharacterState[Report.NumCharacters];
+	Frame.StateTimes = new float[Report.NumCharacters];
+	Frame.Grounded = new bool[Report.NumCharacters];
+	Frame.HorizontalSpeedsSquared = new float[Report.NumCharacters];
+	Frame.Rules = &Batched[0].Machine.GetRuleSet();
+	Frame.NumCharacters = Report.NumCharacters;
+	Frame.ChunkSize = (Report.NumCharacters + Report.NumChunks - 1) / Report.NumChunks;
+	Frame.Switches = new FBatchPendingSwitch[Report.NumCharacters];
+	Frame.NumChunkSwitches = new int32[Report.NumChunks];
+	Frame.Suppressed = new int32[Report.NumCharacters];
+	Frame.NumChunkSuppressed = new int32[Report.NumChunks];
+
+	// Chunks 1..N-1 run on workers that stay up for the whole run; each frame is one generation, and Done counts the
+	// workers that finished it.
+	std::atomic<int32> Generation{ 0 };
+	std::atomic<int32> NumDone{ 0 };
+	std::atomic<bool> bQuit{ false };
+	std::thread* Workers = Report.NumChunks > 1 ? new std::thread[Report.NumChunks - 1] : nullptr;
+	for (int32 Chunk = 1; Chunk < Report.NumChunks; ++Chunk)
+	{
+		Workers[Chunk - 1] = std::thread([&Frame, &Generation, &NumDone, &bQuit, Chunk]()
+		{
+			int32 Seen = 0;
+			for (;;)
+			{
+				int32 Current = Generation.load(std::memory_order_acquire);
+				while (Current == Seen && !bQuit.load(std::memory_order_relaxed))
+				{
+					std::this_thread::yield();
+					Current = Generation.load(std::memory_order_acquire);
+				}
+				if (Current == Seen)
+				{
+					return;
+				}
+				Seen = Current;
+				Frame.Decide(Chunk);
+				NumDone.fetch_add(1, std::memory_order_release);
+			}
+		});
+	}
+
+	uint64 DecideCycles = 0;
+	for (int32 FrameIndex = 0; FrameIndex < Report.NumFrames; ++FrameIndex)
+	{
+		// Gather, on this thread: the only reads of the characters.
+		for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+		{
+			FBatchBenchCharacter& Character = Batched[Index];
+			Character.Script(Index, FrameIndex);
+			Character.Machine.AdvanceStateTime(DeltaTime);
+			Frame.States[Index] = Character.Machine.GetCurrentStateEnum();
+			Frame.StateTimes[Index] = Character.Machine.GetTimeInState();
+			Frame.Grounded[Index] = Character.bGrounded;
+			Frame.HorizontalSpeedsSquared[Index] = static_cast<float>(Character.Velocity.SizeSquared2D());
+		}
+
+		// Decide, in parallel.
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		NumDone.store(0, std::memory_order_relaxed);
+		Generation.fetch_add(1, std::memory_order_release);
+		Frame.Decide(0);
+		while (NumDone.load(std::memory_order_acquire) < Report.NumChunks - 1)
+		{
+			std::this_thread::yield();
+		}
+		DecideCycles += FCharacterStateStats::Cycles() - StartCycles;
+
+		// Apply, on this thread, chunk by chunk: ascending character order whatever the number of chunks.
+		for (int32 Chunk = 0; Chunk < Report.NumChunks; ++Chunk)
+		{
+			const FBatchPendingSwitch* Switches = Frame.Switches + Chunk * Frame.ChunkSize;
+			for (int32 Pending = 0; Pending < Frame.NumChunkSwitches[Chunk]; ++Pending)
+			{
+				Batched[Switches[Pending].Index].Machine.SwitchStateByEnum(Switches[Pending].Target);
+				Report.SwitchHash = (Report.SwitchHash ^ (static_cast<uint64>(Switches[Pending].Index) * NumCharacterStates
+					+ static_cast<uint8>(Switches[Pending].Target))) * 1099511628211ull;
+				++Report.NumSwitches;
+			}
+			for (int32 Pending = 0; Pending < Frame.NumChunkSuppressed[Chunk]; ++Pending)
+			{
+				Batched[Frame.Suppressed[Chunk * Frame.ChunkSize + Pending]].Machine.NoteSuppressedTransition();
+			}
+		}
+
+		for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+		{
+			Serial[Index].Script(Index, FrameIndex);
+			Serial[Index].Machine.Tick(DeltaTime);
+			if (Serial[Index].Machine.GetCurrentStateEnum() != Batched[Index].Machine.GetCurrentStateEnum())
+			{
+				++Report.NumMismatches;
+			}
+		}
+	}
+	Report.DecideSeconds = static_cast<double>(DecideCycles) * FCharacterStateStats::SecondsPerCycle();
+	for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+	{
+		Report.NumSuppressed += Batched[Index].Machine.GetNumSuppressedTransitions();
+		Report.NumSerialSuppressed += Serial[Index].Machine.GetNumSuppressedTransitions();
+	}
+
+	bQuit.store(true, std::memory_order_relaxed);
+	for (int32 Worker = 0; Worker < Report.NumChunks - 1; ++Worker)
+	{
+		Workers[Worker].join();
+	}
+	delete[] Workers;
+	delete[] Frame.NumChunkSuppressed;
+	delete[] Frame.Suppressed;
+	delete[] Frame.NumChunkSwitches;
+	delete[] Frame.Switches;
+	delete[] Frame.HorizontalSpeedsSquared;
+	delete[] Frame.Grounded;
+	delete[] Frame.StateTimes;
+	delete[] Frame.States;
+	delete[] Serial;
+	delete[] Batched;
+	return Report;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/** Results of FCharacterStateBatchBenchmark::Run(). */
+struct FCharacterStateBatchBenchmarkReport
+{
+	int32 NumCharacters = 0;
+	int32 NumFrames = 0;
+	int32 NumChunks = 0;
+
+	/** Seconds spent deciding transitions in NumChunks parallel ranges, all frames together; gather and apply are not included. */
+	double DecideSeconds = 0.0;
+
+	/** Switches applied, and a hash of their (character, target) sequence; equal hashes mean the same switches in the same order. */
+	uint64 NumSwitches = 0;
+	uint64 SwitchHash = 0;
+
+	/** Character frames whose state after the batched pass differs from the same character ticked serially with Tick(). */
+	uint32 NumMismatches = 0;
+
+	/**
+	 * Transitions held back by hysteresis or dwell times, as counted by the batched machines (noted on the calling thread
+	 * after the decide step) and by the serial ones. Equal when every suppression is counted once.
+	 */
+	uint64 NumSuppressed = 0;
+	uint64 NumSerialSuppressed = 0;
+};
+
+/**
+ * Headless model of UCharacterStateManagerSubsystem's batched pass, without the engine: every frame, the calling thread
+ * gathers each character's state, time in state, grounded flag and horizontal speed into contiguous arrays; NumChunks
+ * ranges then decide transitions with FCharacterStateMachine::EvaluateTransition() (chunk 0 on the calling thread, the rest
+ * on their own threads), each into its own lists of switches and suppressed transitions; the calling thread applies the
+ * lists in ascending character order.
+ * A second population runs the same scripted inputs through Tick() one character at a time for comparison.
+ */
+class CD_TEMP_API FCharacterStateBatchBenchmark
+{
+public:
+	static FCharacterStateBatchBenchmarkReport Run(int32 NumCharacters, int32 NumFrames, int32 NumChunks);
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/**
+ * One character's pending capsule half-height change, applied by a batched pass once per frame (see
+ * UCharacterStateManagerComponent::UpdateCapsuleHalfHeight). Only decides what to do; the owner resizes the capsule and
+ * runs the overlap query. Never allocates.
+ */
+struct FCharacterStateCapsuleUpdate
+{
+	/** Height the capsule is moving to. */
+	float TargetHalfHeight = 0.f;
+
+	/** Half-height at the last overlap refresh; overlaps are not refreshed again for the same height. */
+	float OverlapsHalfHeight = 0.f;
+
+	/** True from the first request that changes the height until the flush that reaches the target. */
+	bool bPending = false;
+
+	/** True if any request since the last refresh asked for overlaps. */
+	bool bOverlapsPending = false;
+
+	/** Forgets any pending change; the capsule is at HalfHeight with its overlaps up to date. */
+	void Reset(float HalfHeight)
+	{
+		TargetHalfHeight = HalfHeight;
+		OverlapsHalfHeight = HalfHeight;
+		bPending = false;
+		bOverlapsPending = false;
+	}
+
+	/**
+	 * Records a request while the capsule is at CurrentHalfHeight. Requests matching the current height are dropped unless
+	 * a change is already pending. bOutResizeNow is set when the shape should change at once (InterpSpeed 0), without an
+	 * overlap query. Returns true if the owner must queue itself for the flush.
+	 */
+	bool Request(float CurrentHalfHeight, float NewHalfHeight, bool bUpdateOverlaps, float InterpSpeed, bool& bOutResizeNow)
+	{
+		const bool bAtTarget = IsNearlyEqual(CurrentHalfHeight, NewHalfHeight);
+		TargetHalfHeight = NewHalfHeight;
+		bOutResizeNow = InterpSpeed <= 0.f && !bAtTarget;
+		if (bPending)
+		{
+			bOverlapsPending |= bUpdateOverlaps;
+			return false;
+		}
+		if (bAtTarget)
+		{
+			return false;
+		}
+		bOverlapsPending |= bUpdateOverlaps;
+		bPending = true;
+		return true;
+	}
+
+	/**
+	 * One flush step: moves InOutHalfHeight towards the target at InterpSpeed (or straight to it for 0) and returns true
+	 * while it has not arrived. Once it has, bOutRefreshOverlaps says whether to run the overlap query: only if a request
+	 * asked for one and the height differs from the last refresh, so crouching and standing in one frame costs none.
+	 */
+	bool Step(float& InOutHalfHeight, float DeltaTime, float InterpSpeed, bool& bOutRefreshOverlaps)
+	{
+		bOutRefreshOverlaps = false;
+		if (!IsNearlyEqual(InOutHalfHeight, TargetHalfHeight))
+		{
+			InOutHalfHeight = InterpSpeed > 0.f ? InterpConstantTo(InOutHalfHeight, TargetHalfHeight, DeltaTime, InterpSpeed) : TargetHalfHeight;
+			if (!IsNearlyEqual(InOutHalfHeight, TargetHalfHeight))
+			{
+				return true;
+			}
+		}
+
+		bPending = false;
+		if (bOverlapsPending && !IsNearlyEqual(InOutHalfHeight, OverlapsHalfHeight))
+		{
+			bOutRefreshOverlaps = true;
+			OverlapsHalfHeight = InOutHalfHeight;
+		}
+		bOverlapsPending = false;
+		return false;
+	}
+
+	/** FMath::IsNearlyEqual with its default tolerance. */
+	static bool IsNearlyEqual(float A, float B)
+	{
+		constexpr float Tolerance = 1.e-8f;
+		return A - B <= Tolerance && B - A <= Tolerance;
+	}
+
+	/** FMath::FInterpConstantTo. */
+	static float InterpConstantTo(float Current, float Target, float DeltaTime, float InterpSpeed)
+	{
+		const float Distance = Target - Current;
+		if (Distance * Distance < 1.e-8f)
+		{
+			return Target;
+		}
+		const float MaxStep = InterpSpeed * DeltaTime;
+		return Current + (Distance > MaxStep ? MaxStep : (Distance < -MaxStep ? -MaxStep : Distance));
+	}
+};
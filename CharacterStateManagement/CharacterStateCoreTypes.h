@@ -0,0 +1,129 @@
+#pragma once
+
+// Base types for the engine-independent state machine core (CharacterStateMachine, CharacterBaseState, CharacterStateLogic,
+// CharacterStateTransitionTable). Inside UBT builds WITH_ENGINE is defined and the core uses the reflected ECharacterState
+// and FVector directly; standalone builds only need the C++ standard library.
+
+#if defined(WITH_ENGINE)
+
+#include "CoreMinimal.h"
+#include "CharacterStateManagement/CharacterStateEnum.h"
+
+/** Velocity type used by the core. */
+using FCharacterStateVector = FVector;
+
+/** Compile-time switch for LogCharacterState output; off in shipping. */
+#ifndef CHARACTER_STATE_WITH_LOGGING
+#define CHARACTER_STATE_WITH_LOGGING (!UE_BUILD_SHIPPING)
+#endif
+
+/** Compile-time switch for the transition trace ring buffer (FCharacterStateTrace); off in shipping. */
+#ifndef CHARACTER_STATE_WITH_TRACE
+#define CHARACTER_STATE_WITH_TRACE (!UE_BUILD_SHIPPING)
+#endif
+
+/** Compile-time switch for per-machine time, transition and hook cost counters (FCharacterStateStats); off in shipping. */
+#ifndef CHARACTER_STATE_WITH_STATS
+#define CHARACTER_STATE_WITH_STATS (!UE_BUILD_SHIPPING)
+#endif
+
+/** Most verbose LogCharacterState level compiled in; e.g. define to Warning to strip per-transition Verbose logs entirely. */
+#ifndef CHARACTER_STATE_LOG_MAX_VERBOSITY
+#define CHARACTER_STATE_LOG_MAX_VERBOSITY All
+#endif
+
+#if CHARACTER_STATE_WITH_LOGGING
+CD_TEMP_API DECLARE_LOG_CATEGORY_EXTERN(LogCharacterState, Warning, CHARACTER_STATE_LOG_MAX_VERBOSITY);
+#define CHARACTER_STATE_LOG(Verbosity, Format, ...) UE_LOG(LogCharacterState, Verbosity, Format, ##__VA_ARGS__)
+#else
+#define CHARACTER_STATE_LOG(Verbosity, Format, ...) do {} while (0)
+#endif
+
+#else
+
+#include <cmath>
+#include <cstdint>
+
+using uint8 = std::uint8_t;
+using uint16 = std::uint16_t;
+using uint32 = std::uint32_t;
+using uint64 = std::uint64_t;
+using int8 = std::int8_t;
+using int32 = std::int32_t;
+using int64 = std::int64_t;
+using TCHAR = char;
+
+#ifndef TEXT
+#define TEXT(x) x
+#endif
+
+#ifndef CD_TEMP_API
+#define CD_TEMP_API
+#endif
+
+#ifndef INDEX_NONE
+#define INDEX_NONE (-1)
+#endif
+
+/** Standalone copy of the UENUM in CharacterStateEnum.h; keep both in sync. */
+enum class ECharacterState : uint8
+{
+	Idle,
+	Walking,
+	Sliding,
+	MidAir,
+	WallRun,
+	Sprinting,
+	Crouch,
+	Grapple
+};
+
+/** Standalone copy of ECharacterActionState in CharacterStateEnum.h; keep both in sync. */
+enum class ECharacterActionState : uint8
+{
+	None,
+	Aiming,
+	Reloading,
+	Melee
+};
+
+/** Minimal stand-in for FVector. */
+struct FCharacterStateVector
+{
+	double X = 0.0;
+	double Y = 0.0;
+	double Z = 0.0;
+
+	double Size2D() const { return std::sqrt(X * X + Y * Y); }
+	double SizeSquared2D() const { return X * X + Y * Y; }
+};
+
+#ifndef CHARACTER_STATE_WITH_LOGGING
+#define CHARACTER_STATE_WITH_LOGGING 0
+#endif
+
+#ifndef CHARACTER_STATE_WITH_TRACE
+#define CHARACTER_STATE_WITH_TRACE 1
+#endif
+
+#ifndef CHARACTER_STATE_WITH_STATS
+#define CHARACTER_STATE_WITH_STATS 1
+#endif
+
+#define CHARACTER_STATE_LOG(Verbosity, Format, ...) do {} while (0)
+
+#endif
+
+/** Display name of a state, without allocating. */
+inline const TCHAR* GetCharacterStateName(ECharacterState State)
+{
+	static const TCHAR* const StateNames[] = { TEXT("Idle"), TEXT("Walking"), TEXT("Sliding"), TEXT("MidAir"), TEXT("WallRun"), TEXT("Sprinting"), TEXT("Crouch"), TEXT("Grapple") };
+	return StateNames[static_cast<uint8>(State)];
+}
+
+/** Display name of an action state, without allocating. */
+inline const TCHAR* GetCharacterActionStateName(ECharacterActionState State)
+{
+	static const TCHAR* const StateNames[] = { TEXT("None"), TEXT("Aiming"), TEXT("Reloading"), TEXT("Melee") };
+	return StateNames[static_cast<uint8>(State)];
+}
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateLogic.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateTrace.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+
+/**
+ * Compile-time list of stateless state types (see CharacterStateLogic). Enter/Tick/Exit are dispatched by comparing the
+ * runtime enum against each type's State, which compiles down to a switch; states with bHasTick == false are filtered out
+ * with one AND before any comparison.
+ */
+template <typename... TStates>
+struct TCharacterStateList
+{
+	/** States present in the list. */
+	static constexpr FCharacterStateMask StateMask = static_cast<FCharacterStateMask>((0u | ... | CharacterStateBit(TStates::State)));
+
+	/** States whose Tick does any work. */
+	static constexpr FCharacterStateMask TickingMask = static_cast<FCharacterStateMask>((0u | ... | (TStates::bHasTick ? CharacterStateBit(TStates::State) : 0u)));
+
+	/** Ticking states whose Tick does nothing until the character is grounded (TickAwait == Grounded). */
+	static constexpr FCharacterStateMask AwaitsGroundedMask = static_cast<FCharacterStateMask>((0u | ... | (TStates::bHasTick && TStates::TickAwait == ECharacterStateAwait::Grounded ? CharacterStateBit(TStates::State) : 0u)));
+
+	static constexpr bool Contains(ECharacterState State) { return (StateMask & CharacterStateBit(State)) != 0; }
+	static constexpr bool HasTick(ECharacterState State) { return (TickingMask & CharacterStateBit(State)) != 0; }
+	static constexpr bool AwaitsGrounded(ECharacterState State) { return (AwaitsGroundedMask & CharacterStateBit(State)) != 0; }
+
+	template <typename TMachine>
+	static void Enter(TMachine& Machine, ECharacterState State)
+	{
+		((TStates::State == State ? (TStates::Enter(Machine), true) : false) || ...);
+	}
+
+	template <typename TMachine>
+	static void Tick(TMachine& Machine, ECharacterState State, float DeltaTime)
+	{
+		if (!HasTick(State))
+		{
+			return;
+		}
+		((TStates::State == State ? (TickState<TStates>(Machine, DeltaTime), true) : false) || ...);
+	}
+
+	template <typename TMachine>
+	static void Exit(TMachine& Machine, ECharacterState State)
+	{
+		((TStates::State == State ? (TStates::Exit(Machine), true) : false) || ...);
+	}
+
+private:
+	template <typename TState, typename TMachine>
+	static void TickState(TMachine& Machine, float DeltaTime)
+	{
+		if constexpr (TState::bHasTick)
+		{
+			TState::Tick(Machine, DeltaTime);
+		}
+	}
+};
+
+/** The built-in states, in ECharacterState order. */
+using FDefaultCharacterStateList = TCharacterStateList<
+	CharacterStateLogic::FIdle,
+	CharacterStateLogic::FWalking,
+	CharacterStateLogic::FSliding,
+	CharacterStateLogic::FMidAir,
+	CharacterStateLogic::FWallRun,
+	CharacterStateLogic::FSprinting,
+	CharacterStateLogic::FCrouch,
+	CharacterStateLogic::FGrapple>;
+
+static_assert(FDefaultCharacterStateList::TickingMask == MakeCharacterStateMask(ECharacterState::MidAir, ECharacterState::Sprinting), "Only MidAir and Sprinting have per-frame logic.");
+static_assert(FDefaultCharacterStateList::AwaitsGroundedMask == CharacterStateBit(ECharacterState::MidAir), "Only MidAir waits for the ground.");
+
+/**
+ * Fully static alternative to FCharacterStateMachine for characters that never add states at runtime: no state objects,
+ * no virtual calls, no per-state allocations. Rules, helpers and transition semantics match FCharacterStateMachine,
+ * including queued mode, dwell times, cooldowns and state timeouts; timeouts are checked by Tick(), as FCharacterStateMachine
+ * does without a latent scheduler. Not supported: registered states, orthogonal regions (AddRegion()), RequestStateVia()
+ * routes, latent awaits, snapshots, recording and stats.
+ */
+template <typename TStateList = FDefaultCharacterStateList>
+class TCharacterStateMachine
+{
+public:
+	explicit TCharacterStateMachine(ICharacterStateEnvironment& InEnvironment)
+		: Environment(InEnvironment)
+	{
+	}
+
+	/** Enters Idle. */
+	void Start(const FCharacterStateRuleSetRef& InRules)
+	{
+		Rules = InRules;
+		CurrentStateEnum = ECharacterState::Idle;
+		TimeInState = 0.f;
+		bHasStateTimeout = false;
+		for (double& End : CooldownEnd)
+		{
+			End = 0.0;
+		}
+		EnterState(CurrentStateEnum);
+	}
+
+	/** Start() with the interned rule set for InTable and InSettings. */
+	void Start(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings)
+	{
+		Start(FCharacterStateRuleSet::Intern(InTable, InSettings));
+	}
+
+	/** Per-frame update: samples the frame snapshot, forced switch to MidAir when airborne, then the current state's Tick (skipped for states without one). */
+	void Tick(float DeltaTime)
+	{
+		FrameSnapshot = FCharacterStateFrameSnapshot::Capture(Environment);
+		bHasFrameSnapshot = true;
+		TimeInState += DeltaTime;
+		Clock += DeltaTime;
+
+		// If not in an air state and not grounded, switch to MidAir
+		if (!Rules->Table.IsAirState(CurrentStateEnum) && !IsGrounded())
+		{
+			SwitchOrRequest(ECharacterState::MidAir, ECharacterStateRequestPriority::Forced);
+		}
+		if (bHasStateTimeout && TimeInState >= StateTimeout)
+		{
+			ExpireStateTimeout();
+		}
+		TStateList::Tick(*this, CurrentStateEnum, DeltaTime);
+
+		if (!RequestQueue.IsEmpty())
+		{
+			ApplyQueuedTransitions();
+		}
+
+		bHasFrameSnapshot = false;
+	}
+
+	/** Switch without the same-state check; respects illegal transitions. Returns true if the switch was performed. */
+	bool SwitchState(ECharacterState NewState)
+	{
+		if (!TStateList::Contains(NewState))
+		{
+			return false;
+		}
+		if (Rules->Table.IsIllegal(CurrentStateEnum, NewState))
+		{
+			CHARACTER_STATE_LOG(Verbose, TEXT("%s: Invalid transition %s -> %s"), GetDebugName(), GetCharacterStateName(CurrentStateEnum), GetCharacterStateName(NewState));
+			return false;
+		}
+		if (IsCoolingDown(NewState))
+		{
+			CHARACTER_STATE_LOG(Verbose, TEXT("%s: %s is cooling down for %.2fs"), GetDebugName(), GetCharacterStateName(NewState), GetCooldownLeft(NewState));
+			return false;
+		}
+
+		CHARACTER_STATE_LOG(Verbose, TEXT("%s: Transitioning %s -> %s"), GetDebugName(), GetCharacterStateName(CurrentStateEnum), GetCharacterStateName(NewState));
+#if CHARACTER_STATE_WITH_TRACE
+		FCharacterStateTrace::Record(TraceOwnerId, CurrentStateEnum, NewState);
+#endif
+
+		const ECharacterState PreviousStateEnum = CurrentStateEnum;
+		TStateList::Exit(*this, PreviousStateEnum);
+		bHasStateTimeout = false;
+		const float Cooldown = Rules->Settings.Cooldown[static_cast<uint8>(PreviousStateEnum)];
+		if (Cooldown > 0.f)
+		{
+			CooldownEnd[static_cast<uint8>(PreviousStateEnum)] = Clock + Cooldown;
+		}
+		CurrentStateEnum = NewState;
+		TimeInState = 0.f;
+		EnterState(NewState);
+
+		Environment.OnStateChanged(PreviousStateEnum, NewState);
+		return true;
+	}
+
+	bool SwitchStateByEnum(ECharacterState NewState)
+	{
+		if (bQueueTransitions)
+		{
+			if (CurrentStateEnum == NewState && RequestQueue.IsEmpty())
+			{
+				return false;
+			}
+			RequestState(NewState);
+			return !Rules->Table.IsIllegal(CurrentStateEnum, NewState) && !IsCoolingDown(NewState);
+		}
+
+		if (CurrentStateEnum == NewState)
+		{
+			return false;
+		}
+		return SwitchState(NewState);
+	}
+
+	void SwitchToNormalState()
+	{
+		const FCharacterStateThresholdResult Result = Rules->Settings.EvaluateNormalState(CurrentStateEnum, GetHorizontalSpeedSquared(), TimeInState);
+		if (Result.bSuppressed)
+		{
+			++NumSuppressedTransitions;
+		}
+		if (Result.Target != CurrentStateEnum || bQueueTransitions)
+		{
+			SwitchOrRequest(Result.Target, ECharacterStateRequestPriority::Normal);
+		}
+	}
+
+	/** Time in state and suppressed threshold switches, as in FCharacterStateMachine. */
+	float GetTimeInState() const { return TimeInState; }
+	void AdvanceStateTime(float DeltaTime)
+	{
+		TimeInState += DeltaTime;
+		Clock += DeltaTime;
+	}
+	uint32 GetNumSuppressedTransitions() const { return NumSuppressedTransitions; }
+	void NoteSuppressedTransition() { ++NumSuppressedTransitions; }
+
+	/** Queued mode, as in FCharacterStateMachine. */
+	void SetQueueTransitions(bool bInQueueTransitions) { bQueueTransitions = bInQueueTransitions; }
+
+	void RequestState(ECharacterState NewState, ECharacterStateRequestPriority Priority = ECharacterStateRequestPriority::Normal)
+	{
+		NumCoalescedTransitions += RequestQueue.Push(NewState, Priority);
+	}
+
+	void ApplyQueuedTransitions()
+	{
+		FCharacterStateRequest Requests[FCharacterStateRequestQueue::Capacity];
+		const int32 NumRequests = RequestQueue.Drain(Requests);
+
+		int32 NumApplied = 0;
+		for (int32 Index = 0; Index < NumRequests; ++Index)
+		{
+			const ECharacterState Target = Requests[Index].Target;
+			if (Target == CurrentStateEnum)
+			{
+				break;
+			}
+			if (TStateList::Contains(Target) && !Rules->Table.IsIllegal(CurrentStateEnum, Target) && !IsCoolingDown(Target))
+			{
+				NumApplied = SwitchState(Target) ? 1 : 0;
+				break;
+			}
+		}
+		NumCoalescedTransitions += NumRequests - NumApplied;
+	}
+
+	bool HasQueuedTransitions() const { return !RequestQueue.IsEmpty(); }
+	uint32 GetNumCoalescedTransitions() const { return NumCoalescedTransitions; }
+
+	/** State timeouts from FCharacterStateMachineSettings::MaxTimeInState, as in FCharacterStateMachine; built-in states leave through LeaveStateOnTimeout(). */
+	void SetStateTimeout(float Seconds)
+	{
+		StateTimeout = TimeInState + (Seconds > 0.f ? Seconds : 0.f);
+		bHasStateTimeout = true;
+	}
+	void CancelStateTimeout() { bHasStateTimeout = false; }
+	bool HasStateTimeout() const { return bHasStateTimeout; }
+	float GetStateTimeoutLeft() const { return StateTimeout - TimeInState; }
+	uint32 GetNumTimeouts() const { return NumTimeouts; }
+
+	void LeaveStateOnTimeout()
+	{
+		if (IsGrounded())
+		{
+			SwitchToNormalState();
+		}
+		else if (CurrentStateEnum != ECharacterState::MidAir)
+		{
+			SwitchOrRequest(ECharacterState::MidAir, ECharacterStateRequestPriority::Normal);
+		}
+	}
+
+	/** Cooldowns from FCharacterStateMachineSettings::Cooldown, on the time advanced by Tick() and AdvanceStateTime(). */
+	bool IsCoolingDown(ECharacterState State) const { return Clock < CooldownEnd[static_cast<uint8>(State)]; }
+	float GetCooldownLeft(ECharacterState State) const
+	{
+		const double Left = CooldownEnd[static_cast<uint8>(State)] - Clock;
+		return Left > 0.0 ? static_cast<float>(Left) : 0.f;
+	}
+
+	ECharacterState GetCurrentStateEnum() const { return CurrentStateEnum; }
+	const FCharacterStateRuleSet& GetRuleSet() const { return *Rules; }
+	const FCharacterStateTransitionTable& GetTransitionTable() const { return Rules->Table; }
+	const FCharacterStateMachineSettings& GetSettings() const { return Rules->Settings; }
+
+	/** Helpers that states may call; answered from the frame snapshot during Tick(), otherwise forwarded to the environment. */
+	bool IsGrounded() const { return bHasFrameSnapshot ? FrameSnapshot.bGrounded : Environment.IsGrounded(); }
+	FCharacterStateVector GetLinearVelocity() const { return bHasFrameSnapshot ? FrameSnapshot.Velocity : Environment.GetLinearVelocity(); }
+	float GetHorizontalSpeedSquared() const { return bHasFrameSnapshot ? FrameSnapshot.HorizontalSpeedSquared : static_cast<float>(Environment.GetLinearVelocity().SizeSquared2D()); }
+	void SetLinearVelocity(const FCharacterStateVector& Velocity)
+	{
+		Environment.SetLinearVelocity(Velocity);
+		if (bHasFrameSnapshot)
+		{
+			FrameSnapshot.SetVelocity(Velocity);
+		}
+	}
+	void SetAnimTrigger(const TCHAR* TriggerName) { Environment.SetAnimTrigger(TriggerName); }
+	void ResetAnimTrigger(const TCHAR* TriggerName) { Environment.ResetAnimTrigger(TriggerName); }
+	void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps = true) { Environment.UpdateCapsuleHalfHeight(NewHalfHeight, bUpdateOverlaps); }
+	const TCHAR* GetDebugName() const { return Environment.GetDebugName(); }
+
+	void SetTraceOwnerId(uint32 InOwnerId) { TraceOwnerId = InOwnerId; }
+
+	float GetDefaultCapsuleHalfHeight() const { return Rules->Settings.DefaultCapsuleHalfHeight; }
+	float GetCrouchCapsuleHalfHeight() const { return Rules->Settings.CrouchCapsuleHalfHeight; }
+
+private:
+	void EnterState(ECharacterState State)
+	{
+		// Before Enter(), as in FCharacterStateMachine.
+		const float MaxTimeInState = Rules->Settings.MaxTimeInState[static_cast<uint8>(State)];
+		if (MaxTimeInState > 0.f)
+		{
+			SetStateTimeout(MaxTimeInState);
+		}
+		TStateList::Enter(*this, State);
+	}
+
+	void ExpireStateTimeout()
+	{
+		bHasStateTimeout = false;
+		++NumTimeouts;
+		CHARACTER_STATE_LOG(Verbose, TEXT("%s: %s timed out"), GetDebugName(), GetCharacterStateName(CurrentStateEnum));
+		LeaveStateOnTimeout();
+	}
+
+	bool SwitchOrRequest(ECharacterState NewState, ECharacterStateRequestPriority Priority)
+	{
+		if (bQueueTransitions)
+		{
+			RequestState(NewState, Priority);
+			return true;
+		}
+		return SwitchState(NewState);
+	}
+
+	ICharacterStateEnvironment& Environment;
+
+	FCharacterStateRuleSetRef Rules;
+	ECharacterState CurrentStateEnum = ECharacterState::Idle;
+	FCharacterStateFrameSnapshot FrameSnapshot;
+	bool bHasFrameSnapshot = false;
+	FCharacterStateRequestQueue RequestQueue;
+	uint32 NumCoalescedTransitions = 0;
+	bool bQueueTransitions = false;
+	float TimeInState = 0.f;
+	uint32 NumSuppressedTransitions = 0;
+	float StateTimeout = 0.f;
+	bool bHasStateTimeout = false;
+	uint32 NumTimeouts = 0;
+	double Clock = 0.0;
+	double CooldownEnd[NumCharacterStates] = {};
+	uint32 TraceOwnerId = 0;
+};
@@ -15,3 +15,13 @@ enum class ECharacterState : uint8
 	Crouch,
 	Grapple // when grappled to something
 };
+
+/** Upper-body action states, layered on top of ECharacterState in an orthogonal region (see CharacterStateRegions.h). */
+UENUM(BlueprintType)
+enum class ECharacterActionState : uint8
+{
+	None,
+	Aiming,
+	Reloading,
+	Melee
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/**
+ * Everything the state machine core needs from the character it drives.
+ * The UE component implements this over ACharacter/UCharacterMovementComponent; benchmarks and tests can use a plain struct.
+ */
+class CD_TEMP_API ICharacterStateEnvironment
+{
+public:
+	virtual ~ICharacterStateEnvironment() = default;
+
+	virtual bool IsGrounded() const = 0;
+	virtual FCharacterStateVector GetLinearVelocity() const = 0;
+	virtual void SetLinearVelocity(const FCharacterStateVector& Velocity) = 0;
+	virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps) = 0;
+
+	virtual void SetAnimTrigger(const TCHAR* TriggerName) {}
+	virtual void ResetAnimTrigger(const TCHAR* TriggerName) {}
+
+	/** Called after a successful switch, once the new state has been entered. */
+	virtual void OnStateChanged(ECharacterState PreviousState, ECharacterState NewState) {}
+
+	/**
+	 * Called by FCharacterStateMachine::ReconcileSideEffects() after a rollback with the state before the rollback and the
+	 * state it ended in; no Exit/Enter ran between them. PreviousState may equal NewState.
+	 */
+	virtual void OnStateRestored(ECharacterState PreviousState, ECharacterState NewState) {}
+
+	/**
+	 * Called after a latent state was resumed outside Tick(), by FCharacterStateMachine::SignalEvent() or the latent
+	 * scheduler, and after the scheduler expired a state timeout. State is the state afterwards; Resume() or Timeout() may
+	 * have switched or queued a switch.
+	 */
+	virtual void OnStateResumed(ECharacterState State) {}
+
+	/** Called after a region added with FCharacterStateMachine::AddRegion() changed state. */
+	virtual void OnRegionStateChanged(int32 Region, uint8 PreviousState, uint8 NewState) {}
+
+	/** Name used in log output. */
+	virtual const TCHAR* GetDebugName() const { return TEXT(""); }
+};
@@ -0,0 +1,54 @@
+
+#include "CharacterStateManagement/CharacterStateGraphAsset.h"
+
+const FCharacterStateCompiledGraph& UCharacterStateGraphAsset::GetCompiledGraph() const
+{
+	if (!bCompiled)
+	{
+		const_cast<UCharacterStateGraphAsset*>(this)->Compile();
+	}
+	return CompiledGraph;
+}
+
+void UCharacterStateGraphAsset::Compile()
+{
+	FCharacterStateCompiledGraph Graph;
+	for (const FCharacterStateDefinition& Definition : States)
+	{
+		const uint8 Index = static_cast<uint8>(Definition.State);
+		Graph.Table.DefineState(Definition.State, static_cast<FCharacterStateMask>(Definition.LegalTo), Definition.bNormalState, Definition.bAirState,
+			Definition.bGroundState);
+		Graph.Settings.MinDwellTime[Index] = Definition.MinDwellTime;
+		Graph.Settings.MaxTimeInState[Index] = Definition.MaxTimeInState;
+		Graph.Settings.Cooldown[Index] = Definition.Cooldown;
+		Graph.AnimTriggers[Index] = Definition.AnimTrigger;
+	}
+
+	Graph.Settings.NormalStateWalkThreshold = NormalStateWalkThreshold;
+	Graph.Settings.NormalStateWalkHysteresis = NormalStateWalkHysteresis;
+	Graph.Settings.SprintingMinSpeed = SprintingMinSpeed;
+	Graph.Settings.SprintingHysteresis = SprintingHysteresis;
+	Graph.Settings.CrouchCapsuleHalfHeight = CrouchCapsuleHalfHeight;
+
+	if (!CharacterStateRules::CanLandFromAllAirStates(Graph.Table))
+	{
+		CHARACTER_STATE_LOG(Warning, TEXT("%s: an air state cannot reach any normal state; landing will be rejected"), *GetName());
+	}
+
+	CompiledGraph = Graph;
+	bCompiled = true;
+}
+
+void UCharacterStateGraphAsset::PostLoad()
+{
+	Super::PostLoad();
+	Compile();
+}
+
+#if WITH_EDITOR
+void UCharacterStateGraphAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	Compile();
+}
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "CharacterStateManagement/CharacterStateEnum.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+#include "CharacterStateGraphAsset.generated.h"
+
+/** One state of a UCharacterStateGraphAsset. */
+USTRUCT(BlueprintType)
+struct FCharacterStateDefinition
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State")
+	ECharacterState State = ECharacterState::Idle;
+
+	/** Idle/Walking-like state that landing can end in. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State")
+	bool bNormalState = false;
+
+	/** Airborne state; outside of these the character is switched to MidAir when it leaves the ground. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State")
+	bool bAirState = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State")
+	bool bGroundState = false;
+
+	/** States that can be entered from this one. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterState"))
+	int32 LegalTo = 0;
+
+	/** Seconds this state must be held before a speed threshold may leave it. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State", meta = (ClampMin = "0"))
+	float MinDwellTime = 0.f;
+
+	/** Seconds after which the state is left on its own (FCharacterStateMachineSettings::MaxTimeInState); 0 for none. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State|Timers", meta = (ClampMin = "0"))
+	float MaxTimeInState = 0.f;
+
+	/** Seconds after leaving the state before it can be entered again (FCharacterStateMachineSettings::Cooldown); 0 for none. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State|Timers", meta = (ClampMin = "0"))
+	float Cooldown = 0.f;
+
+	/** Animation trigger set when the state is entered and reset when it is left; None for no trigger. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "State")
+	FName AnimTrigger;
+};
+
+/** Flat runtime form of a UCharacterStateGraphAsset, indexed by state. Built once per asset and shared by every character using it. */
+struct FCharacterStateCompiledGraph
+{
+	/** Adjacency (as illegal-transition bitsets) and category masks. */
+	FCharacterStateTransitionTable Table = CharacterStateRules::Default;
+
+	/** Speed guards, dwell times, timeouts, cooldowns and capsule size; DefaultCapsuleHalfHeight is filled in per character. */
+	FCharacterStateMachineSettings Settings;
+
+	/** Resolved once at compile time, so firing a trigger never hashes a string. */
+	FName AnimTriggers[NumCharacterStates];
+};
+
+/**
+ * Data-driven description of a character archetype's state graph: states and their categories, legal edges, speed guards,
+ * timeouts, cooldowns and animation triggers. Compiled into an FCharacterStateCompiledGraph when loaded or edited; components that reference
+ * the asset start from the compiled graph instead of building rules in BeginPlay. States without a definition keep their
+ * built-in row and categories.
+ */
+UCLASS(BlueprintType)
+class CD_TEMP_API UCharacterStateGraphAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "States")
+	TArray<FCharacterStateDefinition> States;
+
+	/** Horizontal speed above this threshold enters Walking; below enters Idle. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Speed Guards", meta = (ClampMin = "0"))
+	float NormalStateWalkThreshold = 10.f;
+
+	/** Half-width of the speed band around NormalStateWalkThreshold between Idle and Walking. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Speed Guards", meta = (ClampMin = "0"))
+	float NormalStateWalkHysteresis = 0.f;
+
+	/** Horizontal speed below this threshold exits Sprinting. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Speed Guards", meta = (ClampMin = "0"))
+	float SprintingMinSpeed = 600.f;
+
+	/** Sprinting is only left once horizontal speed is this far below SprintingMinSpeed. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Speed Guards", meta = (ClampMin = "0"))
+	float SprintingHysteresis = 0.f;
+
+	/** Target capsule half-height while crouched. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Capsule", meta = (ClampMin = "0"))
+	float CrouchCapsuleHalfHeight = 44.f;
+
+	/** The compiled graph; compiled on first use if the asset was created at runtime. */
+	const FCharacterStateCompiledGraph& GetCompiledGraph() const;
+
+	/** Rebuilds the compiled graph from the properties above. */
+	void Compile();
+
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	FCharacterStateCompiledGraph CompiledGraph;
+	bool bCompiled = false;
+};
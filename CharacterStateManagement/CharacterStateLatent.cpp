@@ -0,0 +1,348 @@
+
+#include "CharacterStateManagement/CharacterStateLatent.h"
+#include "CharacterStateManagement/CharacterBaseState.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+
+FCharacterStateLatentScheduler::~FCharacterStateLatentScheduler()
+{
+	while (FCharacterStateTimer* Timer = Wheel.PopAny())
+	{
+		FCharacterStateMachine* Machine = Timer->Machine;
+		if (Timer == &Machine->AwaitTimer)
+		{
+			Machine->Await.Value = static_cast<float>(Wheel.GetSecondsLeft(*Timer));
+			Machine->bLatentLinked = false;
+		}
+		else
+		{
+			// The timeout is kept in time in state and runs out in Tick() from here on.
+			Machine->StateTimeout = Machine->TimeInState + static_cast<float>(Wheel.GetSecondsLeft(*Timer));
+		}
+		Machine->LatentScheduler = nullptr;
+	}
+	for (FCharacterStateMachine* Machine = SpeedHead; Machine; )
+	{
+		FCharacterStateMachine* Next = Machine->LatentNext;
+		Machine->LatentPrev = Machine->LatentNext = nullptr;
+		Machine->bLatentLinked = false;
+		Machine->LatentScheduler = nullptr;
+		Machine = Next;
+	}
+}
+
+void FCharacterStateLatentScheduler::Link(FCharacterStateMachine& Machine)
+{
+	Machine.bLatentLinked = true;
+	++NumLinked;
+	if (Machine.Await.Condition == ECharacterStateAwait::Delay)
+	{
+		Wheel.Schedule(Machine.AwaitTimer, Machine.Await.Value);
+		return;
+	}
+
+	Machine.LatentPrev = nullptr;
+	Machine.LatentNext = SpeedHead;
+	if (SpeedHead)
+	{
+		SpeedHead->LatentPrev = &Machine;
+	}
+	SpeedHead = &Machine;
+}
+
+void FCharacterStateLatentScheduler::Unlink(FCharacterStateMachine& Machine)
+{
+	Machine.bLatentLinked = false;
+	--NumLinked;
+	if (Machine.Await.Condition == ECharacterStateAwait::Delay)
+	{
+		Wheel.Cancel(Machine.AwaitTimer);
+		return;
+	}
+
+	(Machine.LatentPrev ? Machine.LatentPrev->LatentNext : SpeedHead) = Machine.LatentNext;
+	if (Machine.LatentNext)
+	{
+		Machine.LatentNext->LatentPrev = Machine.LatentPrev;
+	}
+	Machine.LatentPrev = Machine.LatentNext = nullptr;
+}
+
+int32 FCharacterStateLatentScheduler::Update(float DeltaTime)
+{
+	int32 NumResumedNow = 0;
+
+	// Popped one at a time: a timeout's switch cancels the same machine's expired delay, and resumed states may link new
+	// timers. Those that are already due run next update rather than looping here.
+	Wheel.Advance(DeltaTime);
+	while (FCharacterStateTimer* Timer = Wheel.PopExpired())
+	{
+		FCharacterStateMachine* Machine = Timer->Machine;
+		if (Timer == &Machine->TimeoutTimer)
+		{
+			Machine->ExpireStateTimeoutFromOutside();
+			++NumTimedOut;
+			continue;
+		}
+		Machine->bLatentLinked = false;
+		--NumLinked;
+		Machine->ResumeAwaitFromOutside();
+		++NumResumedNow;
+	}
+
+	// Speed has no event source: one compare per awaiting machine. Machines that await again are pushed at the head,
+	// behind this walk.
+	for (FCharacterStateMachine* Machine = SpeedHead; Machine; )
+	{
+		FCharacterStateMachine* Next = Machine->LatentNext;
+		if (Machine->GetHorizontalSpeedSquared() < Machine->Await.Value)
+		{
+			Machine->ResumeAwaitFromOutside();
+			++NumResumedNow;
+		}
+		Machine = Next;
+	}
+
+	NumResumed += static_cast<uint32>(NumResumedNow);
+	return NumResumedNow;
+}
+
+namespace
+{
+	constexpr float BenchGrappleSeconds = 0.71f;
+	constexpr uint32 BenchScriptFrames = 240;
+
+	/** Lets go after BenchGrappleSeconds, checked every Tick(). */
+	class FPollingBenchGrappleState final : public FCharacterBaseState
+	{
+	public:
+		explicit FPollingBenchGrappleState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::Grapple)
+		{
+		}
+
+		virtual void Tick(float DeltaTime) override
+		{
+			if (StateManager->GetTimeInState() >= BenchGrappleSeconds)
+			{
+				StateManager->SwitchToNormalState();
+			}
+		}
+	};
+
+	/** Same grapple, awaiting the delay. */
+	class FLatentBenchGrappleState final : public FCharacterBaseState
+	{
+	public:
+		explicit FLatentBenchGrappleState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::Grapple)
+		{
+		}
+
+		virtual void Enter() override { StateManager->AwaitDelay(BenchGrappleSeconds, 0); }
+		virtual void Resume(int32 Linkage) override { StateManager->SwitchToNormalState(); }
+	};
+
+	/** Ends on landing, checked every Tick(). */
+	class FPollingBenchWallRunState final : public FCharacterBaseState
+	{
+	public:
+		explicit FPollingBenchWallRunState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::WallRun)
+		{
+		}
+
+		virtual void Tick(float DeltaTime) override
+		{
+			if (StateManager->IsGrounded())
+			{
+				StateManager->SwitchToNormalState();
+			}
+		}
+	};
+
+	/** Same wall run, awaiting the landing. */
+	class FLatentBenchWallRunState final : public FCharacterBaseState
+	{
+	public:
+		explicit FLatentBenchWallRunState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::WallRun)
+		{
+		}
+
+		virtual void Enter() override { StateManager->AwaitGrounded(0); }
+		virtual void Resume(int32 Linkage) override { StateManager->SwitchToNormalState(); }
+	};
+
+	/** A character with nothing but its state machine and the tick bookkeeping of an event-driven component. */
+	class FLatentBenchCharacter final : public ICharacterStateEnvironment
+	{
+	public:
+		FLatentBenchCharacter()
+			: Machine(*this)
+		{
+		}
+
+		virtual bool IsGrounded() const override { return bGrounded; }
+		virtual FCharacterStateVector GetLinearVelocity() const override { return Velocity; }
+		virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+		virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps) override {}
+		virtual void OnStateChanged(ECharacterState PreviousState, ECharacterState NewState) override { bAwake = Machine.NeedsTick(); }
+		virtual void OnStateResumed(ECharacterState State) override { bAwake = Machine.NeedsTick(); }
+		virtual const TCHAR* GetDebugName() const override { return TEXT("Latent"); }
+
+		/** Applies this frame's scripted inputs: leaving the ground and grappling, wall running, sprinting, or idling. */
+		void ApplyInputs(int32 Character, uint32 Frame)
+		{
+			const uint32 Phase = (Frame + static_cast<uint32>(Character) * 37u) % BenchScriptFrames;
+			switch (Character % 4)
+			{
+				case 0:
+					if (Phase == 0u)
+					{
+						bGrounded = false;
+						Machine.SwitchStateByEnum(ECharacterState::Grapple);
+					}
+					else if (Phase == 150u)
+					{
+						bGrounded = true;
+					}
+					break;
+				case 1:
+					if (Phase == 0u)
+					{
+						bGrounded = false;
+					}
+					else if (Phase == 20u)
+					{
+						Machine.SwitchStateByEnum(ECharacterState::WallRun);
+					}
+					else if (Phase == 120u)
+					{
+						bGrounded = true;
+					}
+					break;
+				case 2:
+					if (Phase == 0u)
+					{
+						Velocity.X = 800.0;
+						Machine.SwitchStateByEnum(ECharacterState::Sprinting);
+					}
+					else if (Phase == 90u)
+					{
+						Velocity.X = 100.0;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		bool bGrounded = true;
+		FCharacterStateVector Velocity;
+
+		/** Latent variant: ticking enabled, and time since the last tick. */
+		bool bAwake = false;
+		float AccumulatedDeltaTime = 0.f;
+
+		FCharacterStateMachine Machine;
+	};
+
+	/** Runs one variant; returns its seconds and fills OutStates with the final states. */
+	double RunLatentBenchVariant(bool bLatent, int32 NumCharacters, int32 NumFrames, ECharacterState* OutStates, FCharacterStateLatentBenchmarkReport& Report)
+	{
+		constexpr float DeltaTime = 1.f / 60.f;
+
+		FCharacterStateMachineSettings Settings;
+		const FCharacterStateRuleSetRef Rules = FCharacterStateRuleSet::Intern(CharacterStateRules::Default, Settings);
+
+		FCharacterStateLatentScheduler Scheduler;
+		FLatentBenchCharacter* Characters = new FLatentBenchCharacter[NumCharacters];
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			FCharacterStateMachine& Machine = Characters[Index].Machine;
+			Machine.Start(Rules);
+			if (bLatent)
+			{
+				Machine.SetLatentScheduler(&Scheduler);
+				Machine.RegisterState(new FLatentBenchGrappleState(&Machine));
+				Machine.RegisterState(new FLatentBenchWallRunState(&Machine));
+			}
+			else
+			{
+				Machine.RegisterState(new FPollingBenchGrappleState(&Machine));
+				Machine.RegisterState(new FPollingBenchWallRunState(&Machine));
+			}
+			Characters[Index].bAwake = Machine.NeedsTick();
+		}
+
+		uint64& NumTicks = bLatent ? Report.NumLatentTicks : Report.NumPollingTicks;
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		for (uint32 Frame = 0; Frame < static_cast<uint32>(NumFrames); ++Frame)
+		{
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				FLatentBenchCharacter& Character = Characters[Index];
+				const bool bWasGrounded = Character.bGrounded;
+				Character.ApplyInputs(Index, Frame);
+				if (!bLatent)
+				{
+					Character.Machine.Tick(DeltaTime);
+					++NumTicks;
+					continue;
+				}
+
+				// Asleep until something needs a tick or the movement mode changes.
+				Character.AccumulatedDeltaTime += DeltaTime;
+				if (Character.bAwake || Character.bGrounded != bWasGrounded)
+				{
+					Character.Machine.Tick(Character.AccumulatedDeltaTime);
+					Character.AccumulatedDeltaTime = 0.f;
+					Character.bAwake = Character.Machine.NeedsTick();
+					++NumTicks;
+				}
+			}
+			if (bLatent)
+			{
+				Scheduler.Update(DeltaTime);
+			}
+		}
+		const double Seconds = static_cast<double>(FCharacterStateStats::Cycles() - StartCycles) * FCharacterStateStats::SecondsPerCycle();
+
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			OutStates[Index] = Characters[Index].Machine.GetCurrentStateEnum();
+		}
+		if (bLatent)
+		{
+			Report.NumScheduledResumes = Scheduler.GetNumResumed();
+		}
+
+		// Before the scheduler goes out of scope: stopping a machine unlinks it.
+		delete[] Characters;
+		return Seconds;
+	}
+}
+
+FCharacterStateLatentBenchmarkReport FCharacterStateLatentBenchmark::Run(int32 NumCharacters, int32 NumFrames)
+{
+	FCharacterStateLatentBenchmarkReport Report;
+	Report.NumCharacters = NumCharacters > 0 ? NumCharacters : 1;
+	Report.NumFrames = NumFrames > 0 ? NumFrames : 1;
+
+	ECharacterState* PollingStates = new ECharacterState[Report.NumCharacters];
+	ECharacterState* LatentStates = new ECharacterState[Report.NumCharacters];
+	Report.PollingSeconds = RunLatentBenchVariant(false, Report.NumCharacters, Report.NumFrames, PollingStates, Report);
+	Report.LatentSeconds = RunLatentBenchVariant(true, Report.NumCharacters, Report.NumFrames, LatentStates, Report);
+	for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+	{
+		if (PollingStates[Index] != LatentStates[Index])
+		{
+			++Report.NumMismatches;
+		}
+	}
+
+	delete[] LatentStates;
+	delete[] PollingStates;
+	return Report;
+}
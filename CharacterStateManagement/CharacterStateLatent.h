@@ -0,0 +1,127 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateTimers.h"
+
+class FCharacterStateMachine;
+
+/** What a latent state is suspended on; see FCharacterStateMachine::AwaitGrounded() and its siblings. */
+enum class ECharacterStateAwait : uint8
+{
+	None,
+
+	/** IsGrounded() becomes true or false. Signalled by movement mode changes; never sampled by the scheduler. */
+	Grounded,
+	Airborne,
+
+	/** Horizontal speed drops below a threshold. Speed has no event source, so the scheduler samples it once per frame. */
+	SpeedBelow,
+
+	/** Some seconds pass. */
+	Delay,
+
+	/** FCharacterStateMachine::SignalEvent() with a matching id, e.g. a montage end or an async trace result. */
+	Event
+};
+
+/**
+ * A suspended state's pending await, and the resume point handed back to FCharacterBaseState::Resume() once it fires (the
+ * Linkage of a UE latent action). Plain data; part of FCharacterStateMachineSnapshot.
+ */
+struct FCharacterStateAwait
+{
+	ECharacterStateAwait Condition = ECharacterStateAwait::None;
+	int32 Linkage = 0;
+
+	/** SpeedBelow: squared horizontal speed. Delay: seconds left. */
+	float Value = 0.f;
+
+	/** Event: the id to wait for. */
+	uint32 EventId = 0;
+
+	bool IsSuspended() const { return Condition != ECharacterStateAwait::None; }
+
+	/** Delay and SpeedBelow need a clock or a sample every frame; the other conditions are signalled. */
+	bool IsScheduled() const { return Condition == ECharacterStateAwait::Delay || Condition == ECharacterStateAwait::SpeedBelow; }
+};
+
+/**
+ * World-level scheduler for suspended states and state timeouts (FCharacterStateMachine::SetLatentScheduler()). A machine
+ * links itself while it awaits a Delay or SpeedBelow and is resumed from Update(); signalled conditions are resumed where
+ * the signal happens and never visit the scheduler. Delays and timeouts share one FCharacterStateTimerWheel, so linking
+ * and cancelling them is O(1) and Update() only visits the ones that ran out; speed awaits are one loop over the linked
+ * machines, without state dispatch. Machines waiting here need no Tick() of their own. Game thread only.
+ */
+class CD_TEMP_API FCharacterStateLatentScheduler
+{
+public:
+	FCharacterStateLatentScheduler() = default;
+
+	/** Detaches every linked machine; their awaits and timeouts fall back to being checked by their own Tick(). */
+	~FCharacterStateLatentScheduler();
+
+	FCharacterStateLatentScheduler(const FCharacterStateLatentScheduler&) = delete;
+	FCharacterStateLatentScheduler& operator=(const FCharacterStateLatentScheduler&) = delete;
+
+	/**
+	 * Advances the clock, then in one batch expires every state timeout that ran out and resumes every machine whose delay
+	 * ran out or whose speed dropped below its threshold. Returns the number resumed.
+	 */
+	int32 Update(float DeltaTime);
+
+	double GetTime() const { return Wheel.GetTime(); }
+	int32 GetNumLinked() const { return NumLinked; }
+	uint32 GetNumResumed() const { return NumResumed; }
+	uint32 GetNumTimedOut() const { return NumTimedOut; }
+	const FCharacterStateTimerWheel& GetWheel() const { return Wheel; }
+
+private:
+	friend class FCharacterStateMachine;
+
+	/** Links Machine by its await: delays on the wheel, speed awaits at the head of their list. */
+	void Link(FCharacterStateMachine& Machine);
+	void Unlink(FCharacterStateMachine& Machine);
+
+	/** Delay awaits and state timeouts of every linked machine. */
+	FCharacterStateTimerWheel Wheel;
+
+	FCharacterStateMachine* SpeedHead = nullptr;
+
+	int32 NumLinked = 0;
+	uint32 NumResumed = 0;
+	uint32 NumTimedOut = 0;
+};
+
+/** Results of FCharacterStateLatentBenchmark::Run(). */
+struct FCharacterStateLatentBenchmarkReport
+{
+	int32 NumCharacters = 0;
+	int32 NumFrames = 0;
+
+	/** Seconds for all frames: every character ticked every frame with polling states, and latent states with a scheduler. */
+	double PollingSeconds = 0.0;
+	double LatentSeconds = 0.0;
+
+	/** Machine ticks run by each variant. */
+	uint64 NumPollingTicks = 0;
+	uint64 NumLatentTicks = 0;
+
+	/** Awaits resumed by the scheduler. */
+	uint32 NumScheduledResumes = 0;
+
+	/** Characters that ended in a different state in the two variants; nonzero means they do not behave alike. */
+	uint32 NumMismatches = 0;
+};
+
+/**
+ * Headless benchmark of latent versus polling states: NumCharacters characters split between a grapple that lets go after a
+ * delay, a wall run that ends on landing, sprinting that drops out when speed falls, and idling. Both variants run the same
+ * scripted inputs. The polling variant ticks everyone and checks the conditions in Tick(); the latent variant awaits them,
+ * ticks only characters whose NeedsTick() is true or whose movement mode changed (as event-driven components do) and lets
+ * the scheduler resume the rest.
+ */
+class CD_TEMP_API FCharacterStateLatentBenchmark
+{
+public:
+	static FCharacterStateLatentBenchmarkReport Run(int32 NumCharacters, int32 NumFrames);
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateLatent.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+
+/**
+ * Stateless Enter/Tick/Exit logic of the built-in states, dispatched from the current enum by FCharacterStateMachine and
+ * the statically dispatched TCharacterStateMachine. TMachine is FCharacterStateMachine or a TCharacterStateMachine; both expose
+ * the same helpers. bHasTick is false for states without per-frame logic, so dispatchers can skip them entirely.
+ * TickAwait names the condition a ticking state's Tick waits for before it acts (Grounded for MidAir), so callers that are
+ * told about movement changes can stop ticking until it holds.
+ */
+namespace CharacterStateLogic
+{
+	/** AnimBP trigger a built-in state sets on Enter and resets on Exit ("IdleTrigger", "WalkingTrigger", ...). */
+	inline const TCHAR* GetAnimTrigger(ECharacterState State)
+	{
+		static const TCHAR* const Triggers[] = { TEXT("IdleTrigger"), TEXT("WalkingTrigger"), TEXT("SlidingTrigger"), TEXT("MidAirTrigger"),
+			TEXT("WallRunTrigger"), TEXT("SprintingTrigger"), TEXT("CrouchTrigger"), TEXT("GrappleTrigger") };
+		const uint8 Index = static_cast<uint8>(State);
+		return Index < sizeof(Triggers) / sizeof(Triggers[0]) ? Triggers[Index] : TEXT("");
+	}
+
+	// ---- Idle ----
+	struct FIdle
+	{
+		static constexpr ECharacterState State = ECharacterState::Idle;
+		static constexpr bool bHasTick = false;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering Idle State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting Idle State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- Walking ----
+	struct FWalking
+	{
+		static constexpr ECharacterState State = ECharacterState::Walking;
+		static constexpr bool bHasTick = false;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering Walking State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting Walking State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- Sliding ----
+	struct FSliding
+	{
+		static constexpr ECharacterState State = ECharacterState::Sliding;
+		static constexpr bool bHasTick = false;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering Sliding State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting Sliding State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- MidAir ----
+	struct FMidAir
+	{
+		static constexpr ECharacterState State = ECharacterState::MidAir;
+		static constexpr bool bHasTick = true;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::Grounded;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering MidAir State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Tick(TMachine& Machine, float DeltaTime)
+		{
+			if (Machine.IsGrounded())
+			{
+				Machine.SwitchToNormalState();
+			}
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting MidAir State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- WallRun ----
+	struct FWallRun
+	{
+		static constexpr ECharacterState State = ECharacterState::WallRun;
+		static constexpr bool bHasTick = false;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering WallRun State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting WallRun State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- Sprinting ----
+	struct FSprinting
+	{
+		static constexpr ECharacterState State = ECharacterState::Sprinting;
+		static constexpr bool bHasTick = true;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering Sprinting State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Tick(TMachine& Machine, float DeltaTime)
+		{
+			const FCharacterStateThresholdResult Result = Machine.GetSettings().EvaluateSprintingExit(Machine.GetHorizontalSpeedSquared(), Machine.GetTimeInState());
+			if (Result.bSuppressed)
+			{
+				Machine.NoteSuppressedTransition();
+			}
+			else if (Result.Target != State)
+			{
+				Machine.SwitchStateByEnum(Result.Target);
+			}
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting Sprinting State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- Crouch ----
+	struct FCrouch
+	{
+		static constexpr ECharacterState State = ECharacterState::Crouch;
+		static constexpr bool bHasTick = false;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering Crouch State"), Machine.GetDebugName());
+			Machine.UpdateCapsuleHalfHeight(Machine.GetCrouchCapsuleHalfHeight());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting Crouch State"), Machine.GetDebugName());
+			const float DefaultHalfHeight = Machine.GetDefaultCapsuleHalfHeight();
+			if (DefaultHalfHeight > 0.f)
+			{
+				Machine.UpdateCapsuleHalfHeight(DefaultHalfHeight);
+			}
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- Grapple ----
+	struct FGrapple
+	{
+		static constexpr ECharacterState State = ECharacterState::Grapple;
+		static constexpr bool bHasTick = false;
+		static constexpr ECharacterStateAwait TickAwait = ECharacterStateAwait::None;
+
+		template <typename TMachine>
+		static void Enter(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Entering Grapple State"), Machine.GetDebugName());
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+
+		template <typename TMachine>
+		static void Exit(TMachine& Machine)
+		{
+			CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Exiting Grapple State"), Machine.GetDebugName());
+			Machine.ResetAnimTrigger(GetAnimTrigger(State));
+		}
+	};
+
+	// ---- Rollback ----
+	/**
+	 * Capsule height State expects once entered: crouched in Crouch, the default everywhere else (what Crouch's Exit
+	 * restores). Used to reconcile the capsule after a rollback restored State without Enter/Exit.
+	 */
+	template <typename TMachine>
+	void ReconcileCapsule(TMachine& Machine, ECharacterState State)
+	{
+		const float HalfHeight = State == ECharacterState::Crouch ? Machine.GetCrouchCapsuleHalfHeight() : Machine.GetDefaultCapsuleHalfHeight();
+		if (HalfHeight > 0.f)
+		{
+			Machine.UpdateCapsuleHalfHeight(HalfHeight);
+		}
+	}
+
+	/** Trigger changes of a switch from From to State, for a rollback that restored State without Exit/Enter. */
+	template <typename TMachine>
+	void ReconcileAnimTriggers(TMachine& Machine, ECharacterState From, ECharacterState State)
+	{
+		if (From != State)
+		{
+			Machine.ResetAnimTrigger(GetAnimTrigger(From));
+			Machine.SetAnimTrigger(GetAnimTrigger(State));
+		}
+	}
+}
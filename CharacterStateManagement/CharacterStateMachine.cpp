@@ -0,0 +1,1019 @@
+
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterBaseState.h"
+#include "CharacterStateManagement/CharacterStateDispatch.h"
+#include "CharacterStateManagement/CharacterStateRecording.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+#include "CharacterStateManagement/CharacterStateTrace.h"
+
+namespace
+{
+	/**
+	 * Process-wide handles for the built-in states: plain enum handles, not state objects. Their behaviour lives in
+	 * CharacterStateLogic and is dispatched from the machine's current enum, so the handles carry no owner, keep the base
+	 * no-op hooks and are shared by every machine: starting or stopping a machine allocates nothing.
+	 */
+	class FBuiltinCharacterState final : public FCharacterBaseState
+	{
+	public:
+		explicit FBuiltinCharacterState(ECharacterState InState)
+			: FCharacterBaseState(nullptr, InState)
+		{
+		}
+	};
+
+	FBuiltinCharacterState BuiltinStates[NumCharacterStates] =
+	{
+		FBuiltinCharacterState(ECharacterState::Idle),
+		FBuiltinCharacterState(ECharacterState::Walking),
+		FBuiltinCharacterState(ECharacterState::Sliding),
+		FBuiltinCharacterState(ECharacterState::MidAir),
+		FBuiltinCharacterState(ECharacterState::WallRun),
+		FBuiltinCharacterState(ECharacterState::Sprinting),
+		FBuiltinCharacterState(ECharacterState::Crouch),
+		FBuiltinCharacterState(ECharacterState::Grapple),
+	};
+}
+
+FCharacterStateMachine::FCharacterStateMachine(ICharacterStateEnvironment& InEnvironment)
+	: Environment(InEnvironment)
+{
+	AwaitTimer.Machine = this;
+	TimeoutTimer.Machine = this;
+}
+
+FCharacterStateMachine::~FCharacterStateMachine()
+{
+	Stop();
+#if CHARACTER_STATE_WITH_STATS
+	delete Stats;
+#endif
+}
+
+void FCharacterStateMachine::Start(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings)
+{
+	Start(FCharacterStateRuleSet::Intern(InTable, InSettings));
+}
+
+void FCharacterStateMachine::Start(const FCharacterStateRuleSetRef& InRules)
+{
+	Stop();
+
+	Rules = InRules;
+
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		States[Index] = &BuiltinStates[Index];
+	}
+
+	CurrentState = FindState(ECharacterState::Idle);
+	CurrentStateEnum = ECharacterState::Idle;
+	TimeInState = 0.f;
+	for (double& End : CooldownEnd)
+	{
+		End = 0.0;
+	}
+	if (CurrentState)
+	{
+		EnterState(CurrentState);
+	}
+}
+
+void FCharacterStateMachine::Stop()
+{
+	for (FCharacterBaseState*& State : States)
+	{
+		if (State && !IsBuiltinState(State))
+		{
+			delete State;
+		}
+		State = nullptr;
+	}
+	CancelAwait();
+	CancelStateTimeout();
+	CurrentState = nullptr;
+	RequestQueue.Reset();
+	NumRegions = 0;
+	bNeedsReconcile = false;
+	bHasRoute = false;
+}
+
+void FCharacterStateMachine::RegisterState(FCharacterBaseState* State)
+{
+	if (!State)
+	{
+		return;
+	}
+
+	FCharacterBaseState*& Slot = States[static_cast<uint8>(State->GetState())];
+	if (Slot == State)
+	{
+		return;
+	}
+	if (CurrentState == Slot)
+	{
+		CurrentState = State;
+	}
+	if (Slot && !IsBuiltinState(Slot))
+	{
+		delete Slot;
+	}
+	Slot = State;
+}
+
+bool FCharacterStateMachine::IsBuiltinState(const FCharacterBaseState* State) const
+{
+	return State == &BuiltinStates[static_cast<uint8>(State->GetState())];
+}
+
+void FCharacterStateMachine::EnterState(FCharacterBaseState* State)
+{
+	// Before Enter(), which may replace it with its own SetStateTimeout().
+	const float MaxTimeInState = Rules->Settings.MaxTimeInState[static_cast<uint8>(State->GetState())];
+	if (MaxTimeInState > 0.f)
+	{
+		SetStateTimeout(MaxTimeInState);
+	}
+
+	CHARACTER_STATE_SCOPED_HOOK_TIMER(GetActiveStats(), State->GetState(), ECharacterStateHook::Enter);
+	if (IsBuiltinState(State))
+	{
+		FDefaultCharacterStateList::Enter(*this, State->GetState());
+	}
+	else
+	{
+		State->Enter();
+	}
+}
+
+void FCharacterStateMachine::ExitState(FCharacterBaseState* State)
+{
+	CHARACTER_STATE_SCOPED_HOOK_TIMER(GetActiveStats(), State->GetState(), ECharacterStateHook::Exit);
+	if (IsBuiltinState(State))
+	{
+		FDefaultCharacterStateList::Exit(*this, State->GetState());
+	}
+	else
+	{
+		State->Exit();
+	}
+}
+
+void FCharacterStateMachine::Tick(float DeltaTime)
+{
+	FrameSnapshot = FCharacterStateFrameSnapshot::Capture(Environment);
+	bHasFrameSnapshot = true;
+	TimeInState += DeltaTime;
+	Clock += DeltaTime;
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		Regions[Region].TimeInState += DeltaTime;
+	}
+#if CHARACTER_STATE_WITH_STATS
+	if (FCharacterStateStats* ActiveStats = GetActiveStats())
+	{
+		ActiveStats->TimeInState[static_cast<uint8>(CurrentStateEnum)] += DeltaTime;
+	}
+#endif
+
+	FCharacterStateRecordEntry* RecordEntry = Recorder && !bInRecordedCall ? Recorder->Append() : nullptr;
+	if (RecordEntry)
+	{
+		RecordEntry->SetInputs(FrameSnapshot.bGrounded, FrameSnapshot.Velocity);
+		RecordEntry->DeltaTime = DeltaTime;
+	}
+
+	// If not in an air state and not grounded, switch to MidAir
+	if (!Rules->Table.IsAirState(CurrentStateEnum) && !IsGrounded())
+	{
+		SwitchOrRequest(ECharacterState::MidAir, ECharacterStateRequestPriority::Forced);
+	}
+
+	// Without a scheduler, a timeout runs out on the state's own clock.
+	if (bHasStateTimeout && !TimeoutTimer.IsScheduled() && TimeInState >= StateTimeout)
+	{
+		ExpireStateTimeout();
+	}
+
+	if (CurrentState)
+	{
+		CHARACTER_STATE_SCOPED_HOOK_TIMER(GetActiveStats(), CurrentStateEnum, ECharacterStateHook::Tick);
+
+		// A suspended latent state is not ticked; it continues in Resume() once its await holds.
+		if (Await.IsSuspended())
+		{
+			if (UpdateAwait(DeltaTime))
+			{
+				ResumeAwait();
+			}
+		}
+		// Built-in states without Tick logic (Idle, Walking, ...) cost one AND here instead of a virtual call.
+		else if (IsBuiltinState(CurrentState))
+		{
+			FDefaultCharacterStateList::Tick(*this, CurrentStateEnum, DeltaTime);
+		}
+		else
+		{
+			CurrentState->Tick(DeltaTime);
+		}
+		CurrentStateEnum = CurrentState->GetState();
+	}
+
+	// After the state's own logic, so a route continues from wherever this frame's switches left the machine.
+	if (bHasRoute)
+	{
+		TakeRouteHop(false);
+	}
+
+	if (!RequestQueue.IsEmpty())
+	{
+		ApplyQueuedTransitions();
+		if (CurrentStateEnum == RouteTarget)
+		{
+			bHasRoute = false;
+		}
+	}
+
+	// Regions run after locomotion has settled for the frame, against the same snapshot.
+	if (NumRegions > 0)
+	{
+		UpdateRegions();
+	}
+
+	if (RecordEntry)
+	{
+		RecordEntry->Result = CurrentStateEnum;
+	}
+	bHasFrameSnapshot = false;
+}
+
+bool FCharacterStateMachine::NeedsTick() const
+{
+	if (!CurrentState)
+	{
+		return false;
+	}
+	if (bHasRoute || !RequestQueue.IsEmpty() || (bHasStateTimeout && !TimeoutTimer.IsScheduled()))
+	{
+		return true;
+	}
+	if (Await.IsSuspended())
+	{
+		switch (Await.Condition)
+		{
+			case ECharacterStateAwait::Grounded:
+				if (IsGrounded())
+				{
+					return true;
+				}
+				break;
+			case ECharacterStateAwait::Airborne:
+				if (!IsGrounded())
+				{
+					return true;
+				}
+				break;
+			case ECharacterStateAwait::SpeedBelow:
+			case ECharacterStateAwait::Delay:
+				if (!bLatentLinked)
+				{
+					return true;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	else if (!IsBuiltinState(CurrentState))
+	{
+		return true;
+	}
+	else if (FDefaultCharacterStateList::HasTick(CurrentStateEnum))
+	{
+		// MidAir's Tick only acts once grounded, and landing changes the movement mode.
+		if (!FDefaultCharacterStateList::AwaitsGrounded(CurrentStateEnum) || IsGrounded())
+		{
+			return true;
+		}
+	}
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		if (Regions[Region].IsTimed())
+		{
+			return true;
+		}
+	}
+	return !Rules->Table.IsAirState(CurrentStateEnum) && !IsGrounded();
+}
+
+bool FCharacterStateMachine::SwitchState(FCharacterBaseState* NewState)
+{
+	if (!NewState) return false;
+
+	const ECharacterState NewStateEnum = NewState->GetState();
+	FScopedRecord Record(*this, ECharacterStateRecordType::SwitchState, NewStateEnum);
+	if (Rules->Table.IsIllegal(CurrentStateEnum, NewStateEnum))
+	{
+		CHARACTER_STATE_LOG(Verbose, TEXT("%s: Invalid transition %s -> %s"), GetDebugName(), GetCharacterStateName(CurrentStateEnum), GetCharacterStateName(NewStateEnum));
+#if CHARACTER_STATE_WITH_STATS
+		if (FCharacterStateStats* ActiveStats = GetActiveStats())
+		{
+			++ActiveStats->Rejected[static_cast<uint8>(CurrentStateEnum)][static_cast<uint8>(NewStateEnum)];
+		}
+#endif
+		return false;
+	}
+	if (IsCoolingDown(NewStateEnum))
+	{
+		CHARACTER_STATE_LOG(Verbose, TEXT("%s: %s is cooling down for %.2fs"), GetDebugName(), GetCharacterStateName(NewStateEnum), GetCooldownLeft(NewStateEnum));
+		return false;
+	}
+
+	PerformSwitch(NewState);
+	return true;
+}
+
+bool FCharacterStateMachine::SetStateFromAuthority(ECharacterState NewState)
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::SetStateFromAuthority, NewState);
+	FCharacterBaseState* State = FindState(NewState);
+	if (!State || CurrentStateEnum == NewState)
+	{
+		return false;
+	}
+	PerformSwitch(State);
+	return true;
+}
+
+void FCharacterStateMachine::PerformSwitch(FCharacterBaseState* NewState)
+{
+	const ECharacterState NewStateEnum = NewState->GetState();
+	CHARACTER_STATE_LOG(Verbose, TEXT("%s: Transitioning %s -> %s"), GetDebugName(), GetCharacterStateName(CurrentStateEnum), GetCharacterStateName(NewStateEnum));
+#if CHARACTER_STATE_WITH_TRACE
+	FCharacterStateTrace::Record(TraceOwnerId, CurrentStateEnum, NewStateEnum);
+#endif
+#if CHARACTER_STATE_WITH_STATS
+	if (FCharacterStateStats* ActiveStats = GetActiveStats())
+	{
+		++ActiveStats->Transitions[static_cast<uint8>(CurrentStateEnum)][static_cast<uint8>(NewStateEnum)];
+	}
+#endif
+
+	const ECharacterState PreviousStateEnum = CurrentStateEnum;
+	if (Await.IsSuspended())
+	{
+		CancelAwait();
+	}
+	if (CurrentState)
+	{
+		ExitState(CurrentState);
+	}
+	if (bHasStateTimeout)
+	{
+		CancelStateTimeout();
+	}
+	const float Cooldown = Rules->Settings.Cooldown[static_cast<uint8>(PreviousStateEnum)];
+	if (Cooldown > 0.f)
+	{
+		CooldownEnd[static_cast<uint8>(PreviousStateEnum)] = Clock + Cooldown;
+	}
+	CurrentState = NewState;
+	CurrentStateEnum = NewStateEnum;
+	TimeInState = 0.f;
+	EnterState(CurrentState);
+
+	Environment.OnStateChanged(PreviousStateEnum, NewStateEnum);
+
+	// Cross-region guards: e.g. entering WallRun ends a reload.
+	if (NumRegions > 0)
+	{
+		UpdateRegions();
+	}
+}
+
+bool FCharacterStateMachine::SwitchStateByEnum(ECharacterState NewState)
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::SwitchStateByEnum, NewState);
+	if (bQueueTransitions)
+	{
+		if (CurrentStateEnum == NewState && RequestQueue.IsEmpty())
+		{
+			return false;
+		}
+		RequestState(NewState);
+		return IsTransitionLegal(CurrentStateEnum, NewState) && !IsCoolingDown(NewState);
+	}
+
+	if (CurrentStateEnum == NewState)
+	{
+		return false;
+	}
+	return SwitchState(FindState(NewState));
+}
+
+void FCharacterStateMachine::SwitchToNormalState()
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::SwitchToNormalState, ECharacterState::Idle);
+	const FCharacterStateThresholdResult Result = Rules->Settings.EvaluateNormalState(CurrentStateEnum, GetHorizontalSpeedSquared(), TimeInState);
+	if (Result.bSuppressed)
+	{
+		++NumSuppressedTransitions;
+	}
+
+	// Already there: no Exit/Enter. In queued mode the request still cancels older ones, as any request for the current state does.
+	if (Result.Target != CurrentStateEnum || bQueueTransitions)
+	{
+		SwitchOrRequest(Result.Target, ECharacterStateRequestPriority::Normal);
+	}
+}
+
+bool FCharacterStateMachine::RequestStateVia(ECharacterState Target, bool bImmediate)
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::RequestStateVia, Target, bImmediate ? FCharacterStateRecordEntry::ImmediateFlag : 0);
+	bHasRoute = false;
+	if (CurrentStateEnum == Target || !Rules->Routes.HasRoute(CurrentStateEnum, Target))
+	{
+		return false;
+	}
+
+	RouteTarget = Target;
+	bHasRoute = true;
+	if (!bImmediate)
+	{
+		TakeRouteHop(false);
+		return true;
+	}
+
+	// A shortest route visits each state at most once.
+	for (int32 Hop = 0; Hop < NumCharacterStates && bHasRoute; ++Hop)
+	{
+		TakeRouteHop(true);
+	}
+	return CurrentStateEnum == Target;
+}
+
+void FCharacterStateMachine::AdvanceRoute()
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::AdvanceRoute, RouteTarget);
+	if (bHasRoute)
+	{
+		TakeRouteHop(false);
+	}
+}
+
+void FCharacterStateMachine::TakeRouteHop(bool bSwitchNow)
+{
+	if (CurrentStateEnum == RouteTarget || !Rules->Routes.HasRoute(CurrentStateEnum, RouteTarget))
+	{
+		bHasRoute = false;
+		return;
+	}
+
+	// Without a route, a caller retrying SwitchStateByEnum(RouteTarget) would have been refused here.
+	if (Rules->Table.IsIllegal(CurrentStateEnum, RouteTarget))
+	{
+		++NumAvoidedRetries;
+	}
+
+	const ECharacterState Next = Rules->Routes.GetNextHop(CurrentStateEnum, RouteTarget);
+	CHARACTER_STATE_LOG(Verbose, TEXT("%s: Routing to %s via %s"), GetDebugName(), GetCharacterStateName(RouteTarget), GetCharacterStateName(Next));
+	++NumRouteHops;
+	const bool bSwitched = bSwitchNow ? SwitchState(FindState(Next)) : SwitchOrRequest(Next, ECharacterStateRequestPriority::Normal);
+	if (!bSwitched || CurrentStateEnum == RouteTarget)
+	{
+		bHasRoute = false;
+	}
+}
+
+void FCharacterStateMachine::AwaitGrounded(int32 Linkage)
+{
+	SetAwait(ECharacterStateAwait::Grounded, 0.f, 0, Linkage);
+}
+
+void FCharacterStateMachine::AwaitAirborne(int32 Linkage)
+{
+	SetAwait(ECharacterStateAwait::Airborne, 0.f, 0, Linkage);
+}
+
+void FCharacterStateMachine::AwaitSpeedBelow(float Speed, int32 Linkage)
+{
+	SetAwait(ECharacterStateAwait::SpeedBelow, Speed * Speed, 0, Linkage);
+}
+
+void FCharacterStateMachine::AwaitDelay(float Seconds, int32 Linkage)
+{
+	SetAwait(ECharacterStateAwait::Delay, Seconds, 0, Linkage);
+}
+
+void FCharacterStateMachine::AwaitEvent(uint32 EventId, int32 Linkage)
+{
+	SetAwait(ECharacterStateAwait::Event, 0.f, EventId, Linkage);
+}
+
+void FCharacterStateMachine::SetAwait(ECharacterStateAwait Condition, float Value, uint32 EventId, int32 Linkage)
+{
+	CancelAwait();
+	Await.Condition = Condition;
+	Await.Linkage = Linkage;
+	Await.Value = Value;
+	Await.EventId = EventId;
+	if (LatentScheduler && Await.IsScheduled())
+	{
+		LatentScheduler->Link(*this);
+	}
+}
+
+void FCharacterStateMachine::CancelAwait()
+{
+	if (bLatentLinked)
+	{
+		LatentScheduler->Unlink(*this);
+	}
+	Await = FCharacterStateAwait();
+}
+
+bool FCharacterStateMachine::SignalEvent(uint32 EventId)
+{
+	if (Await.Condition != ECharacterStateAwait::Event || Await.EventId != EventId)
+	{
+		return false;
+	}
+	ResumeAwaitFromOutside();
+	return true;
+}
+
+void FCharacterStateMachine::SetLatentScheduler(FCharacterStateLatentScheduler* InScheduler)
+{
+	if (InScheduler == LatentScheduler)
+	{
+		return;
+	}
+
+	// Carry a running delay and timeout over to the new clock.
+	FCharacterStateAwait Pending = Await;
+	if (bLatentLinked && Await.Condition == ECharacterStateAwait::Delay)
+	{
+		Pending.Value = static_cast<float>(LatentScheduler->Wheel.GetSecondsLeft(AwaitTimer));
+	}
+	const bool bHadStateTimeout = bHasStateTimeout;
+	const float TimeoutLeft = GetStateTimeoutLeft();
+	CancelAwait();
+	CancelStateTimeout();
+	LatentScheduler = InScheduler;
+	SetAwait(Pending.Condition, Pending.Value, Pending.EventId, Pending.Linkage);
+	if (bHadStateTimeout)
+	{
+		SetStateTimeout(TimeoutLeft);
+	}
+}
+
+bool FCharacterStateMachine::UpdateAwait(float DeltaTime)
+{
+	switch (Await.Condition)
+	{
+		case ECharacterStateAwait::Grounded:
+			return IsGrounded();
+		case ECharacterStateAwait::Airborne:
+			return !IsGrounded();
+		case ECharacterStateAwait::SpeedBelow:
+			return GetHorizontalSpeedSquared() < Await.Value;
+		case ECharacterStateAwait::Delay:
+			// A linked delay runs on the scheduler's clock.
+			if (bLatentLinked)
+			{
+				return false;
+			}
+			Await.Value -= DeltaTime;
+			return Await.Value <= 0.f;
+		default:
+			return false;
+	}
+}
+
+void FCharacterStateMachine::ResumeAwait()
+{
+	const int32 Linkage = Await.Linkage;
+	CancelAwait();
+	++NumResumes;
+	CHARACTER_STATE_LOG(VeryVerbose, TEXT("%s: Resuming %s at %d"), GetDebugName(), GetCharacterStateName(CurrentStateEnum), Linkage);
+	CurrentState->Resume(Linkage);
+}
+
+void FCharacterStateMachine::ResumeAwaitFromOutside()
+{
+	ResumeAwait();
+	Environment.OnStateResumed(CurrentStateEnum);
+}
+
+void FCharacterStateMachine::SetStateTimeout(float Seconds)
+{
+	CancelStateTimeout();
+	if (Seconds < 0.f)
+	{
+		Seconds = 0.f;
+	}
+	StateTimeout = TimeInState + Seconds;
+	bHasStateTimeout = true;
+	if (LatentScheduler)
+	{
+		LatentScheduler->Wheel.Schedule(TimeoutTimer, Seconds);
+	}
+}
+
+void FCharacterStateMachine::CancelStateTimeout()
+{
+	if (TimeoutTimer.IsScheduled())
+	{
+		LatentScheduler->Wheel.Cancel(TimeoutTimer);
+	}
+	bHasStateTimeout = false;
+}
+
+float FCharacterStateMachine::GetStateTimeoutLeft() const
+{
+	// A sleeping component's time in state lags behind; the wheel's clock does not.
+	return TimeoutTimer.IsScheduled() ? static_cast<float>(LatentScheduler->Wheel.GetSecondsLeft(TimeoutTimer)) : StateTimeout - TimeInState;
+}
+
+void FCharacterStateMachine::ExpireStateTimeout()
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::ExpireStateTimeout, CurrentStateEnum);
+	if (!bHasStateTimeout || !CurrentState)
+	{
+		return;
+	}
+	CancelStateTimeout();
+	++NumTimeouts;
+	CHARACTER_STATE_LOG(Verbose, TEXT("%s: %s timed out"), GetDebugName(), GetCharacterStateName(CurrentStateEnum));
+	if (IsBuiltinState(CurrentState))
+	{
+		LeaveStateOnTimeout();
+	}
+	else
+	{
+		CurrentState->Timeout();
+	}
+}
+
+void FCharacterStateMachine::ExpireStateTimeoutFromOutside()
+{
+	ExpireStateTimeout();
+	Environment.OnStateResumed(CurrentStateEnum);
+}
+
+void FCharacterStateMachine::LeaveStateOnTimeout()
+{
+	if (IsGrounded())
+	{
+		SwitchToNormalState();
+	}
+	else if (CurrentStateEnum != ECharacterState::MidAir)
+	{
+		SwitchOrRequest(ECharacterState::MidAir, ECharacterStateRequestPriority::Normal);
+	}
+}
+
+float FCharacterStateMachine::GetCooldownLeft(ECharacterState State) const
+{
+	const double Left = CooldownEnd[static_cast<uint8>(State)] - Clock;
+	return Left > 0.0 ? static_cast<float>(Left) : 0.f;
+}
+
+void FCharacterStateMachine::SaveSnapshot(FCharacterStateMachineSnapshot& OutSnapshot) const
+{
+	OutSnapshot.RequestQueue = RequestQueue;
+	OutSnapshot.Await = Await;
+	if (bLatentLinked && Await.Condition == ECharacterStateAwait::Delay)
+	{
+		OutSnapshot.Await.Value = static_cast<float>(LatentScheduler->Wheel.GetSecondsLeft(AwaitTimer));
+	}
+	OutSnapshot.bHasStateTimeout = bHasStateTimeout;
+	OutSnapshot.StateTimeoutLeft = bHasStateTimeout ? GetStateTimeoutLeft() : 0.f;
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		OutSnapshot.CooldownLeft[Index] = GetCooldownLeft(static_cast<ECharacterState>(Index));
+	}
+	OutSnapshot.TimeInState = TimeInState;
+	OutSnapshot.State = CurrentStateEnum;
+	OutSnapshot.bHasRoute = bHasRoute;
+	OutSnapshot.RouteTarget = RouteTarget;
+	OutSnapshot.NumRegions = static_cast<uint8>(NumRegions);
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		OutSnapshot.RegionStates[Region] = Regions[Region].CurrentState;
+		OutSnapshot.RegionTimeInState[Region] = Regions[Region].TimeInState;
+	}
+}
+
+void FCharacterStateMachine::RestoreSnapshot(const FCharacterStateMachineSnapshot& Snapshot)
+{
+	if (!bNeedsReconcile)
+	{
+		ReconcileFromState = CurrentStateEnum;
+		for (int32 Region = 0; Region < NumRegions; ++Region)
+		{
+			ReconcileFromRegionStates[Region] = Regions[Region].CurrentState;
+		}
+		bNeedsReconcile = true;
+	}
+
+	CurrentStateEnum = Snapshot.State;
+	CurrentState = FindState(Snapshot.State);
+	TimeInState = Snapshot.TimeInState;
+	RequestQueue = Snapshot.RequestQueue;
+	bHasRoute = Snapshot.bHasRoute;
+	RouteTarget = Snapshot.RouteTarget;
+	SetAwait(Snapshot.Await.Condition, Snapshot.Await.Value, Snapshot.Await.EventId, Snapshot.Await.Linkage);
+	CancelStateTimeout();
+	if (Snapshot.bHasStateTimeout)
+	{
+		SetStateTimeout(Snapshot.StateTimeoutLeft);
+	}
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		CooldownEnd[Index] = Clock + Snapshot.CooldownLeft[Index];
+	}
+
+	// Regions belong to the machine's setup; a snapshot taken before AddRegion() leaves the newer ones alone.
+	const int32 NumRestoredRegions = Snapshot.NumRegions < NumRegions ? Snapshot.NumRegions : NumRegions;
+	for (int32 Region = 0; Region < NumRestoredRegions; ++Region)
+	{
+		Regions[Region].CurrentState = Snapshot.RegionStates[Region];
+		Regions[Region].TimeInState = Snapshot.RegionTimeInState[Region];
+	}
+}
+
+void FCharacterStateMachine::ReconcileSideEffects()
+{
+	if (!bNeedsReconcile)
+	{
+		return;
+	}
+	bNeedsReconcile = false;
+
+	CHARACTER_STATE_LOG(Verbose, TEXT("%s: Reconciling rollback %s -> %s"), GetDebugName(), GetCharacterStateName(ReconcileFromState), GetCharacterStateName(CurrentStateEnum));
+	if (CurrentState)
+	{
+		if (IsBuiltinState(CurrentState))
+		{
+			CharacterStateLogic::ReconcileCapsule(*this, CurrentStateEnum);
+			CharacterStateLogic::ReconcileAnimTriggers(*this, ReconcileFromState, CurrentStateEnum);
+		}
+		else
+		{
+			CurrentState->Reconcile();
+		}
+	}
+
+	Environment.OnStateRestored(ReconcileFromState, CurrentStateEnum);
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		if (Regions[Region].CurrentState != ReconcileFromRegionStates[Region])
+		{
+			Environment.OnRegionStateChanged(Region, ReconcileFromRegionStates[Region], Regions[Region].CurrentState);
+		}
+	}
+}
+
+void FCharacterStateMachine::AdvanceStateTime(float DeltaTime)
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::AdvanceStateTime, CurrentStateEnum);
+	if (Record.Entry)
+	{
+		Record.Entry->DeltaTime = DeltaTime;
+	}
+	TimeInState += DeltaTime;
+	Clock += DeltaTime;
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		Regions[Region].TimeInState += DeltaTime;
+	}
+#if CHARACTER_STATE_WITH_STATS
+	if (FCharacterStateStats* ActiveStats = GetActiveStats())
+	{
+		ActiveStats->TimeInState[static_cast<uint8>(CurrentStateEnum)] += DeltaTime;
+	}
+#endif
+}
+
+bool FCharacterStateMachine::SwitchOrRequest(ECharacterState NewState, ECharacterStateRequestPriority Priority)
+{
+	if (bQueueTransitions)
+	{
+		RequestState(NewState, Priority);
+		return true;
+	}
+	return SwitchState(FindState(NewState));
+}
+
+void FCharacterStateMachine::RequestState(ECharacterState NewState, ECharacterStateRequestPriority Priority)
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::RequestState, NewState,
+		Priority == ECharacterStateRequestPriority::Forced ? FCharacterStateRecordEntry::ForcedFlag : 0);
+	NumCoalescedTransitions += RequestQueue.Push(NewState, Priority);
+}
+
+void FCharacterStateMachine::ApplyQueuedTransitions()
+{
+	FScopedRecord Record(*this, ECharacterStateRecordType::ApplyQueuedTransitions, ECharacterState::Idle);
+
+	// Drained up front: requests made by the winner's Exit/Enter wait for the next application.
+	FCharacterStateRequest Requests[FCharacterStateRequestQueue::Capacity];
+	const int32 NumRequests = RequestQueue.Drain(Requests);
+
+	int32 NumApplied = 0;
+	for (int32 Index = 0; Index < NumRequests; ++Index)
+	{
+		const ECharacterState Target = Requests[Index].Target;
+		if (Target == CurrentStateEnum)
+		{
+			break;
+		}
+		if (IsTransitionLegal(CurrentStateEnum, Target) && !IsCoolingDown(Target) && FindState(Target))
+		{
+			NumApplied = SwitchState(FindState(Target)) ? 1 : 0;
+			break;
+		}
+#if CHARACTER_STATE_WITH_STATS
+		FCharacterStateStats* ActiveStats = GetActiveStats();
+		if (ActiveStats && !IsTransitionLegal(CurrentStateEnum, Target))
+		{
+			++ActiveStats->Rejected[static_cast<uint8>(CurrentStateEnum)][static_cast<uint8>(Target)];
+		}
+#endif
+	}
+	NumCoalescedTransitions += NumRequests - NumApplied;
+}
+
+void FCharacterStateMachine::SetRecorder(FCharacterStateRecorder* InRecorder)
+{
+	Recorder = InRecorder;
+	if (Recorder)
+	{
+		Recorder->Begin(*this);
+	}
+}
+
+int32 FCharacterStateMachine::AddRegion(const FCharacterStateRegionRules& InRules)
+{
+	if (NumRegions >= MaxCharacterStateRegions || InRules.NumStates == 0 || InRules.DefaultState >= InRules.NumStates)
+	{
+		return INDEX_NONE;
+	}
+
+	FCharacterStateRegion& Region = Regions[NumRegions];
+	Region.Rules = InRules;
+	Region.CurrentState = InRules.DefaultState;
+	Region.TimeInState = 0.f;
+	return NumRegions++;
+}
+
+bool FCharacterStateMachine::CanEnterRegionState(int32 Region, uint8 NewState) const
+{
+	const FCharacterStateRegion& Target = Regions[Region];
+	return NewState < Target.Rules.NumStates && !Target.Rules.IsIllegal(Target.CurrentState, NewState) && !Target.Rules.IsBlocked(NewState, CurrentStateEnum);
+}
+
+bool FCharacterStateMachine::SwitchRegionState(int32 Region, uint8 NewState)
+{
+	if (Region < 0 || Region >= NumRegions || Regions[Region].CurrentState == NewState || !CanEnterRegionState(Region, NewState))
+	{
+		return false;
+	}
+	PerformRegionSwitch(Region, NewState);
+	return true;
+}
+
+void FCharacterStateMachine::UpdateRegions()
+{
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		const FCharacterStateRegion& Current = Regions[Region];
+		if (Current.CurrentState != Current.Rules.DefaultState
+			&& (Current.Rules.IsBlocked(Current.CurrentState, CurrentStateEnum) || Current.HasExpired()))
+		{
+			PerformRegionSwitch(Region, Current.Rules.DefaultState);
+		}
+	}
+}
+
+bool FCharacterStateMachine::HasRegionUpdate() const
+{
+	for (int32 Region = 0; Region < NumRegions; ++Region)
+	{
+		if (Regions[Region].HasExpired())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FCharacterStateMachine::PerformRegionSwitch(int32 Region, uint8 NewState)
+{
+	FCharacterStateRegion& Target = Regions[Region];
+	const uint8 PreviousState = Target.CurrentState;
+	Target.CurrentState = NewState;
+	Target.TimeInState = 0.f;
+	Environment.OnRegionStateChanged(Region, PreviousState, NewState);
+}
+
+void FCharacterStateMachine::SetCollectStats(bool bInCollectStats)
+{
+#if CHARACTER_STATE_WITH_STATS
+	if (bInCollectStats && !Stats)
+	{
+		Stats = new FCharacterStateStats();
+	}
+	bCollectStats = bInCollectStats;
+#endif
+}
+
+bool FCharacterStateMachine::IsCollectingStats() const
+{
+#if CHARACTER_STATE_WITH_STATS
+	return bCollectStats;
+#else
+	return false;
+#endif
+}
+
+const FCharacterStateStats* FCharacterStateMachine::GetStats() const
+{
+#if CHARACTER_STATE_WITH_STATS
+	return Stats;
+#else
+	return nullptr;
+#endif
+}
+
+void FCharacterStateMachine::ResetStats()
+{
+#if CHARACTER_STATE_WITH_STATS
+	if (Stats)
+	{
+		Stats->Reset();
+	}
+#endif
+}
+
+FCharacterStateMachine::FScopedRecord::FScopedRecord(FCharacterStateMachine& InMachine, ECharacterStateRecordType Type, ECharacterState Argument, uint8 Flags)
+	: Machine(InMachine)
+{
+	if (!Machine.Recorder || Machine.bHasFrameSnapshot || Machine.bInRecordedCall)
+	{
+		return;
+	}
+	Entry = Machine.Recorder->Append();
+	if (Entry)
+	{
+		Entry->Type = Type;
+		Entry->Flags = Flags;
+		Entry->Argument = Argument;
+		Entry->SetInputs(Machine.Environment.IsGrounded(), Machine.Environment.GetLinearVelocity());
+		Machine.bInRecordedCall = true;
+	}
+}
+
+FCharacterStateMachine::FScopedRecord::~FScopedRecord()
+{
+	if (Entry)
+	{
+		Entry->Result = Machine.CurrentStateEnum;
+		Machine.bInRecordedCall = false;
+	}
+}
+
+ECharacterState FCharacterStateMachine::EvaluateTransition(ECharacterState State, bool bGrounded, float HorizontalSpeedSquared, float TimeInState,
+	const FCharacterStateTransitionTable& Table, const FCharacterStateMachineSettings& Settings, bool& bOutSuppressed)
+{
+	bOutSuppressed = false;
+
+	// Tick(): if not in an air state and not grounded, switch to MidAir.
+	// MidAir's own Tick then runs with bGrounded == false and does nothing this frame.
+	if (!Table.IsAirState(State) && !bGrounded && !Table.IsIllegal(State, ECharacterState::MidAir))
+	{
+		return ECharacterState::MidAir;
+	}
+
+	switch (State)
+	{
+		case ECharacterState::MidAir:
+			// FMidAirState::Tick -> SwitchToNormalState()
+			if (bGrounded)
+			{
+				return Settings.EvaluateNormalState(State, HorizontalSpeedSquared, TimeInState).Target;
+			}
+			break;
+		case ECharacterState::Sprinting:
+		{
+			// FSprintingState::Tick
+			const FCharacterStateThresholdResult Result = Settings.EvaluateSprintingExit(HorizontalSpeedSquared, TimeInState);
+			bOutSuppressed = Result.bSuppressed;
+			return Result.Target;
+		}
+		default:
+			break;
+	}
+	return State;
+}
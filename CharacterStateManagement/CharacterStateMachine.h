@@ -0,0 +1,431 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateLatent.h"
+#include "CharacterStateManagement/CharacterStateRegions.h"
+#include "CharacterStateManagement/CharacterStateRequestQueue.h"
+#include "CharacterStateManagement/CharacterStateRuleSet.h"
+#include "CharacterStateManagement/CharacterStateSnapshot.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+
+class FCharacterBaseState;
+class FCharacterStateRecorder;
+struct FCharacterStateRecordEntry;
+struct FCharacterStateStats;
+enum class ECharacterStateRecordType : uint8;
+
+/**
+ * Movement values sampled once at the start of a tick. While a tick is running the state machine's helpers answer from
+ * the snapshot instead of querying the environment again.
+ */
+struct FCharacterStateFrameSnapshot
+{
+	FCharacterStateVector Velocity;
+	float HorizontalSpeedSquared = 0.f;
+	bool bGrounded = false;
+
+	static FCharacterStateFrameSnapshot Capture(const ICharacterStateEnvironment& Environment)
+	{
+		FCharacterStateFrameSnapshot Snapshot;
+		Snapshot.bGrounded = Environment.IsGrounded();
+		Snapshot.SetVelocity(Environment.GetLinearVelocity());
+		return Snapshot;
+	}
+
+	void SetVelocity(const FCharacterStateVector& InVelocity)
+	{
+		Velocity = InVelocity;
+		HorizontalSpeedSquared = static_cast<float>(InVelocity.SizeSquared2D());
+	}
+};
+
+/**
+ * Engine-independent character state machine: state registry, transition rules and Enter/Exit sequencing.
+ * All queries and side effects on the character go through ICharacterStateEnvironment.
+ */
+class CD_TEMP_API FCharacterStateMachine
+{
+public:
+	explicit FCharacterStateMachine(ICharacterStateEnvironment& InEnvironment);
+	~FCharacterStateMachine();
+
+	FCharacterStateMachine(const FCharacterStateMachine&) = delete;
+	FCharacterStateMachine& operator=(const FCharacterStateMachine&) = delete;
+
+	/** Registers the built-in states (shared, allocation-free handles) and enters Idle. */
+	void Start(const FCharacterStateRuleSetRef& InRules);
+
+	/** Start() with the interned rule set for InTable and InSettings. */
+	void Start(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings);
+
+	/** Destroys all states; Exit() is not called. */
+	void Stop();
+
+	/**
+	 * Registers a state object for its enum, replacing (and deleting) any previous one. Takes ownership.
+	 * States registered here are always called through their virtual Enter/Tick/Exit; this is the only path that allocates.
+	 */
+	void RegisterState(FCharacterBaseState* State);
+
+	/** Per-frame update: samples the frame snapshot, forced switch to MidAir when airborne, then the current state's Tick. */
+	void Tick(float DeltaTime);
+
+	/**
+	 * False when Tick() would do nothing: the current state is built-in without per-frame logic, no forced switch to
+	 * MidAir is pending, no requests are queued and no timeout is left to Tick(). Lets callers stop ticking until the movement mode or the state changes.
+	 */
+	bool NeedsTick() const;
+
+	/** Switch to a new state by pointer; respects illegal transitions. Returns true if the switch was performed. */
+	bool SwitchState(FCharacterBaseState* NewState);
+
+	/**
+	 * Switch to a new state by enum. Returns false if already in that state, the transition is illegal or the state is not registered.
+	 * With queued transitions the request is deferred (see RequestState()) and the return value only says whether it is currently legal.
+	 */
+	bool SwitchStateByEnum(ECharacterState NewState);
+
+	/**
+	 * Queued mode: switch requests (SwitchStateByEnum, SwitchToNormalState, the forced MidAir switch in Tick) are collected and
+	 * coalesced, and only the winner's Exit/Enter pair runs in ApplyQueuedTransitions() at the end of Tick().
+	 */
+	void SetQueueTransitions(bool bInQueueTransitions) { bQueueTransitions = bInQueueTransitions; }
+	bool IsQueueingTransitions() const { return bQueueTransitions; }
+
+	/** Adds a request to the queue regardless of mode; the queue is applied by ApplyQueuedTransitions(). */
+	void RequestState(ECharacterState NewState, ECharacterStateRequestPriority Priority = ECharacterStateRequestPriority::Normal);
+
+	/**
+	 * Switches to the best queued request (higher priority, then newest) that is legal from the current state; a winning
+	 * request for the current state cancels the others. Called at the end of Tick().
+	 */
+	void ApplyQueuedTransitions();
+
+	bool HasQueuedTransitions() const { return !RequestQueue.IsEmpty(); }
+
+	/** Requests that were merged, displaced or outranked instead of producing their own transition. */
+	uint32 GetNumCoalescedTransitions() const { return NumCoalescedTransitions; }
+
+	/** Seconds since the current state was entered, advanced by Tick() and AdvanceStateTime(); read by the dwell times. */
+	float GetTimeInState() const { return TimeInState; }
+
+	/** Advances the time in state for periods without Tick(), e.g. the batched subsystem or an event-driven component asleep. */
+	void AdvanceStateTime(float DeltaTime);
+
+	/** Speed threshold switches held back by hysteresis bands or dwell times (FCharacterStateMachineSettings). */
+	uint32 GetNumSuppressedTransitions() const { return NumSuppressedTransitions; }
+	void NoteSuppressedTransition() { ++NumSuppressedTransitions; }
+
+	/**
+	 * Adds an orthogonal region (e.g. upper-body actions) that runs next to locomotion in its DefaultState, ticked in the
+	 * same Tick() over the same frame snapshot. Returns its index, or INDEX_NONE if MaxCharacterStateRegions are in use.
+	 * Regions are cleared by Stop(). They never change locomotion, so recordings and replays cover locomotion only.
+	 */
+	int32 AddRegion(const FCharacterStateRegionRules& InRules);
+	int32 GetNumRegions() const { return NumRegions; }
+
+	uint8 GetRegionState(int32 Region) const { return Regions[Region].CurrentState; }
+	float GetRegionTimeInState(int32 Region) const { return Regions[Region].TimeInState; }
+
+	/** True if the region's table allows the switch and no cross-region guard blocks NewState in the current locomotion state. */
+	bool CanEnterRegionState(int32 Region, uint8 NewState) const;
+
+	/** Switches a region; returns false if already there or CanEnterRegionState() is false. */
+	bool SwitchRegionState(int32 Region, uint8 NewState);
+
+	/**
+	 * Returns regions whose state is blocked by the current locomotion state or has run its duration to their default
+	 * state. Called by Tick() and after every locomotion switch; batched callers run it when HasRegionUpdate() is true.
+	 */
+	void UpdateRegions();
+	bool HasRegionUpdate() const;
+
+	/**
+	 * Switches to NewState without consulting the transition table, for states decided by a network authority that
+	 * already validated the path. Runs one Exit/Enter pair; does nothing if already in NewState.
+	 */
+	bool SetStateFromAuthority(ECharacterState NewState);
+
+	/** Switch to Idle or Walking based on current horizontal speed (e.g. when landing from MidAir). */
+	void SwitchToNormalState();
+
+	/**
+	 * Heads for Target along the shortest legal route (FCharacterStateRuleSet::Routes) instead of failing on an illegal
+	 * direct edge. Takes the first hop now and one more per Tick(), re-routing from wherever forced switches leave the
+	 * machine; with bImmediate, runs every hop now (one Exit/Enter pair each). Replaces any active route. Returns false if
+	 * already in Target or Target cannot be reached.
+	 */
+	bool RequestStateVia(ECharacterState Target, bool bImmediate = false);
+
+	/** Takes the next hop of the active route. Called by Tick(); batched callers run it when HasRoute() is true. */
+	void AdvanceRoute();
+
+	void CancelRoute() { bHasRoute = false; }
+	bool HasRoute() const { return bHasRoute; }
+	ECharacterState GetRouteTarget() const { return RouteTarget; }
+
+	/** Hops taken by routes, and ticks on which a route stood in for a direct switch that the table would have refused. */
+	uint32 GetNumRouteHops() const { return NumRouteHops; }
+	uint32 GetNumAvoidedRetries() const { return NumAvoidedRetries; }
+
+	/**
+	 * Latent states: called from a registered state's Enter(), Tick() or Resume() to suspend it until a condition holds, then
+	 * continue in FCharacterBaseState::Resume(Linkage). While suspended the state's Tick() is not called and, for signalled
+	 * conditions, NeedsTick() is false. Replaces any pending await; a switch cancels it. Without a latent scheduler, Delay
+	 * and SpeedBelow are checked by Tick().
+	 */
+	void AwaitGrounded(int32 Linkage);
+	void AwaitAirborne(int32 Linkage);
+	void AwaitSpeedBelow(float Speed, int32 Linkage);
+	void AwaitDelay(float Seconds, int32 Linkage);
+	void AwaitEvent(uint32 EventId, int32 Linkage);
+	void CancelAwait();
+
+	bool IsSuspended() const { return Await.IsSuspended(); }
+	const FCharacterStateAwait& GetAwait() const { return Await; }
+
+	/** Resumes the current state if it awaits EventId. Returns true if it did. */
+	bool SignalEvent(uint32 EventId);
+
+	/** World-level scheduler (not owned) that resumes Delay and SpeedBelow awaits; nullptr checks them in Tick(). */
+	void SetLatentScheduler(FCharacterStateLatentScheduler* InScheduler);
+	FCharacterStateLatentScheduler* GetLatentScheduler() const { return LatentScheduler; }
+
+	/** Awaits that fired and resumed their state. */
+	uint32 GetNumResumes() const { return NumResumes; }
+
+	/**
+	 * State timeouts: leaves the current state once it has been active for Seconds (a slide's maximum duration, a grapple's
+	 * maximum attach time). Meant for Enter(); the machine registers FCharacterStateMachineSettings::MaxTimeInState just
+	 * before it, and the state's exit cancels it. Replaces any timeout already set. On expiry the state's
+	 * FCharacterBaseState::Timeout() runs, LeaveStateOnTimeout() for built-in states. With a latent scheduler the timeout
+	 * waits on its timing wheel and needs no Tick(); without one, Tick() compares it with the time in state.
+	 */
+	void SetStateTimeout(float Seconds);
+	void CancelStateTimeout();
+	bool HasStateTimeout() const { return bHasStateTimeout; }
+
+	/** Seconds until the current state times out; only meaningful while HasStateTimeout(). */
+	float GetStateTimeoutLeft() const;
+
+	/** Runs the pending timeout now, as the scheduler does once it runs out. Recorded, so replays repeat scheduled timeouts. */
+	void ExpireStateTimeout();
+
+	/** Default reaction to a timeout: Idle or Walking when grounded (SwitchToNormalState()), MidAir otherwise. */
+	void LeaveStateOnTimeout();
+
+	/** Timeouts that expired. */
+	uint32 GetNumTimeouts() const { return NumTimeouts; }
+
+	/**
+	 * True while State's FCharacterStateMachineSettings::Cooldown since it was last left has not passed; switches into it
+	 * are refused (SetStateFromAuthority() is not). Measured on the time advanced by Tick() and AdvanceStateTime().
+	 */
+	bool IsCoolingDown(ECharacterState State) const { return Clock < CooldownEnd[static_cast<uint8>(State)]; }
+	float GetCooldownLeft(ECharacterState State) const;
+
+	/** Copies the simulated state into Snapshot; O(1), no allocation. */
+	void SaveSnapshot(FCharacterStateMachineSnapshot& OutSnapshot) const;
+
+	/**
+	 * Rewinds to Snapshot for resimulation in O(1): no Exit/Enter, no environment calls, nothing traced or recorded. The
+	 * character's side effects (capsule, animation, ...) are left as they were until ReconcileSideEffects(), so a rollback
+	 * may restore and resimulate any number of frames and reconcile once at the end.
+	 */
+	void RestoreSnapshot(const FCharacterStateMachineSnapshot& Snapshot);
+
+	/**
+	 * After RestoreSnapshot() and resimulation: reapplies the current state's persistent side effects (the capsule height for
+	 * built-in states, FCharacterBaseState::Reconcile() for registered ones) and reports the net change since the first
+	 * restore through ICharacterStateEnvironment::OnStateRestored() and OnRegionStateChanged(). Does nothing if nothing was restored.
+	 */
+	void ReconcileSideEffects();
+	bool NeedsReconcile() const { return bNeedsReconcile; }
+
+	/**
+	 * The state registered for State, or its built-in handle. Built-in handles only name the state: they have no owner and
+	 * their hooks do nothing, so pass them to SwitchState() or compare them, but do not call them.
+	 */
+	FCharacterBaseState* FindState(ECharacterState State) const { return States[static_cast<uint8>(State)]; }
+	FCharacterBaseState* GetCurrentState() const { return CurrentState; }
+	ECharacterState GetCurrentStateEnum() const { return CurrentStateEnum; }
+
+	const FCharacterStateRuleSet& GetRuleSet() const { return *Rules; }
+	const FCharacterStateTransitionTable& GetTransitionTable() const { return Rules->Table; }
+	const FCharacterStateMachineSettings& GetSettings() const { return Rules->Settings; }
+	bool IsTransitionLegal(ECharacterState From, ECharacterState To) const { return !Rules->Table.IsIllegal(From, To); }
+
+	/** Helpers that states may call; answered from the frame snapshot during Tick(), otherwise forwarded to the environment. */
+	bool IsGrounded() const { return bHasFrameSnapshot ? FrameSnapshot.bGrounded : Environment.IsGrounded(); }
+	FCharacterStateVector GetLinearVelocity() const { return bHasFrameSnapshot ? FrameSnapshot.Velocity : Environment.GetLinearVelocity(); }
+	float GetHorizontalSpeedSquared() const { return bHasFrameSnapshot ? FrameSnapshot.HorizontalSpeedSquared : static_cast<float>(Environment.GetLinearVelocity().SizeSquared2D()); }
+	void SetLinearVelocity(const FCharacterStateVector& Velocity)
+	{
+		Environment.SetLinearVelocity(Velocity);
+		if (bHasFrameSnapshot)
+		{
+			FrameSnapshot.SetVelocity(Velocity);
+		}
+	}
+	void SetAnimTrigger(const TCHAR* TriggerName) { Environment.SetAnimTrigger(TriggerName); }
+	void ResetAnimTrigger(const TCHAR* TriggerName) { Environment.ResetAnimTrigger(TriggerName); }
+	void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps = true) { Environment.UpdateCapsuleHalfHeight(NewHalfHeight, bUpdateOverlaps); }
+	const TCHAR* GetDebugName() const { return Environment.GetDebugName(); }
+
+	/** Id written to FCharacterStateTrace records (e.g. the owning object's unique id). */
+	void SetTraceOwnerId(uint32 InOwnerId) { TraceOwnerId = InOwnerId; }
+	uint32 GetTraceOwnerId() const { return TraceOwnerId; }
+
+	/**
+	 * Records every Tick() and every switch request made from outside a tick into Recorder (not owned), starting from the
+	 * current rules, settings and state; nullptr stops recording. See FCharacterStateReplayer.
+	 */
+	void SetRecorder(FCharacterStateRecorder* InRecorder);
+	FCharacterStateRecorder* GetRecorder() const { return Recorder; }
+
+	/**
+	 * Starts or pauses collecting time in state, transition and rejection counts and hook costs into this machine's
+	 * FCharacterStateStats, allocated on first use; paused stats are kept. Does nothing when CHARACTER_STATE_WITH_STATS is off.
+	 */
+	void SetCollectStats(bool bInCollectStats);
+	bool IsCollectingStats() const;
+
+	/** Stats collected so far, or nullptr if never enabled. */
+	const FCharacterStateStats* GetStats() const;
+	void ResetStats();
+
+	float GetDefaultCapsuleHalfHeight() const { return Rules->Settings.DefaultCapsuleHalfHeight; }
+	float GetCrouchCapsuleHalfHeight() const { return Rules->Settings.CrouchCapsuleHalfHeight; }
+
+	/**
+	 * The built-in per-frame decision for one character without side effects: returns the state Tick() would switch to
+	 * (forced MidAir, MidAir landing, Sprinting speed drop-out), or State if it would stay. bOutSuppressed is set when
+	 * hysteresis or dwell time kept the character in State.
+	 */
+	static ECharacterState EvaluateTransition(ECharacterState State, bool bGrounded, float HorizontalSpeedSquared, float TimeInState,
+		const FCharacterStateTransitionTable& Table, const FCharacterStateMachineSettings& Settings, bool& bOutSuppressed);
+
+private:
+	/** True if State is one of the shared built-in handles; its hooks are dispatched statically. */
+	bool IsBuiltinState(const FCharacterBaseState* State) const;
+
+	void EnterState(FCharacterBaseState* State);
+	void ExitState(FCharacterBaseState* State);
+
+	/** Exit/Enter sequencing shared by SwitchState() and SetStateFromAuthority(). */
+	void PerformSwitch(FCharacterBaseState* NewState);
+
+	/** Region switch without checks; notifies the environment. */
+	void PerformRegionSwitch(int32 Region, uint8 NewState);
+
+	/** Replaces the pending await; links the machine to the latent scheduler for scheduled conditions. */
+	void SetAwait(ECharacterStateAwait Condition, float Value, uint32 EventId, int32 Linkage);
+
+	/** Tick(): true if the pending await holds now; counts down unscheduled delays. */
+	bool UpdateAwait(float DeltaTime);
+
+	/** Clears the await and calls the current state's Resume(). */
+	void ResumeAwait();
+
+	/** ResumeAwait() from outside Tick(), reported to the environment. */
+	void ResumeAwaitFromOutside();
+
+	/** ExpireStateTimeout() from the latent scheduler, reported to the environment. */
+	void ExpireStateTimeoutFromOutside();
+
+	/** One hop towards RouteTarget: SwitchOrRequest(), or SwitchState() with bSwitchNow. Ends the route when it is reached or unreachable. */
+	void TakeRouteHop(bool bSwitchNow);
+
+	/** SwitchState() now, or RequestState() in queued mode. */
+	bool SwitchOrRequest(ECharacterState NewState, ECharacterStateRequestPriority Priority);
+
+	/**
+	 * Records a public call with its inputs, and the resulting state when it goes out of scope. Calls made from inside
+	 * Tick() or another recorded call are not recorded; replaying the outer one repeats them.
+	 */
+	struct FScopedRecord
+	{
+		FScopedRecord(FCharacterStateMachine& InMachine, ECharacterStateRecordType Type, ECharacterState Argument, uint8 Flags = 0);
+		~FScopedRecord();
+
+		FCharacterStateMachine& Machine;
+		FCharacterStateRecordEntry* Entry = nullptr;
+	};
+
+	ICharacterStateEnvironment& Environment;
+
+	/** Shared with every other machine started with the same rules. */
+	FCharacterStateRuleSetRef Rules;
+
+	FCharacterStateRegion Regions[MaxCharacterStateRegions];
+	int32 NumRegions = 0;
+
+	/** Registered states, indexed by ECharacterState. Owned unless they are built-in handles. */
+	FCharacterBaseState* States[NumCharacterStates] = {};
+
+	FCharacterBaseState* CurrentState = nullptr;
+	ECharacterState CurrentStateEnum = ECharacterState::Idle;
+
+	FCharacterStateRequestQueue RequestQueue;
+	uint32 NumCoalescedTransitions = 0;
+	bool bQueueTransitions = false;
+
+	float TimeInState = 0.f;
+	uint32 NumSuppressedTransitions = 0;
+
+	/** Active RequestStateVia() route. */
+	ECharacterState RouteTarget = ECharacterState::Idle;
+	bool bHasRoute = false;
+	uint32 NumRouteHops = 0;
+	uint32 NumAvoidedRetries = 0;
+
+	/** Pending await of the current state; see AwaitGrounded(). */
+	FCharacterStateAwait Await;
+	uint32 NumResumes = 0;
+
+	/**
+	 * Scheduler, valid while bLatentLinked or TimeoutTimer is scheduled. A Delay await is linked through AwaitTimer, a
+	 * SpeedBelow await through LatentPrev/LatentNext.
+	 */
+	FCharacterStateLatentScheduler* LatentScheduler = nullptr;
+	FCharacterStateMachine* LatentPrev = nullptr;
+	FCharacterStateMachine* LatentNext = nullptr;
+	FCharacterStateTimer AwaitTimer;
+	bool bLatentLinked = false;
+
+	/** Current state's timeout in time in state; see SetStateTimeout(). On the scheduler's wheel while TimeoutTimer is scheduled. */
+	FCharacterStateTimer TimeoutTimer;
+	float StateTimeout = 0.f;
+	bool bHasStateTimeout = false;
+	uint32 NumTimeouts = 0;
+
+	/** Seconds advanced by Tick() and AdvanceStateTime(); CooldownEnd is on this clock. */
+	double Clock = 0.0;
+	double CooldownEnd[NumCharacterStates] = {};
+
+	friend class FCharacterStateLatentScheduler;
+
+	/** Valid while bHasFrameSnapshot, i.e. for the duration of Tick(). */
+	FCharacterStateFrameSnapshot FrameSnapshot;
+	bool bHasFrameSnapshot = false;
+
+	uint32 TraceOwnerId = 0;
+
+	/** State and region states before the first RestoreSnapshot() since the last ReconcileSideEffects(). */
+	ECharacterState ReconcileFromState = ECharacterState::Idle;
+	uint8 ReconcileFromRegionStates[MaxCharacterStateRegions] = {};
+	bool bNeedsReconcile = false;
+
+	FCharacterStateRecorder* Recorder = nullptr;
+	bool bInRecordedCall = false;
+
+#if CHARACTER_STATE_WITH_STATS
+	/** Stats being collected, or nullptr; see SetCollectStats(). */
+	FCharacterStateStats* GetActiveStats() const { return bCollectStats ? Stats : nullptr; }
+
+	/** Owned; allocated by the first SetCollectStats(true). */
+	FCharacterStateStats* Stats = nullptr;
+	bool bCollectStats = false;
+#endif
+};
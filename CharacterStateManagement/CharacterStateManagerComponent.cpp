@@ -1,49 +1,255 @@
 
 #include "CharacterStateManagement/CharacterStateManagerComponent.h"
-#include "CharacterStateManagement/CharacterStates.h"
+#include "CharacterStateManagement/CharacterBaseState.h"
+#include "CharacterStateManagement/CharacterStateGraphAsset.h"
+#include "CharacterStateManagement/CharacterStateManagerSubsystem.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Animation/AnimInstance.h"
-#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Net/UnrealNetwork.h"
+
+static TAutoConsoleVariable<bool> CVarCharacterStateBatchedTick(
+	TEXT("CharacterState.BatchedTick"),
+	true,
+	TEXT("If true, components with bUseBatchedTick are ticked together by UCharacterStateManagerSubsystem. Read in BeginPlay."));
+
+static TAutoConsoleVariable<bool> CVarCharacterStateEventDrivenTick(
+	TEXT("CharacterState.EventDrivenTick"),
+	true,
+	TEXT("If true, components with bEventDrivenTick only tick while their state has per-frame logic. Read in BeginPlay."));
+
+// ---- FCharacterStateComponentEnvironment ----
+bool FCharacterStateComponentEnvironment::IsGrounded() const
+{
+	return Component.IsGrounded();
+}
+
+FCharacterStateVector FCharacterStateComponentEnvironment::GetLinearVelocity() const
+{
+	return Component.GetLinearVelocity();
+}
+
+void FCharacterStateComponentEnvironment::SetLinearVelocity(const FCharacterStateVector& Velocity)
+{
+	Component.SetLinearVelocity(Velocity);
+}
+
+void FCharacterStateComponentEnvironment::UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps)
+{
+	Component.UpdateCapsuleHalfHeight(NewHalfHeight, bUpdateOverlaps);
+}
+
+void FCharacterStateComponentEnvironment::SetAnimTrigger(const TCHAR* TriggerName)
+{
+	Component.QueueAnimTrigger(TriggerName, true);
+}
+
+void FCharacterStateComponentEnvironment::ResetAnimTrigger(const TCHAR* TriggerName)
+{
+	Component.QueueAnimTrigger(TriggerName, false);
+}
+
+void FCharacterStateComponentEnvironment::OnStateChanged(ECharacterState PreviousState, ECharacterState NewState)
+{
+	// On-screen output is read from FCharacterStateTrace by CharacterState.ShowTrace instead of being pushed from here.
+	Component.CurrentStateEnum = NewState;
+	if (Component.CompiledStateGraph)
+	{
+		Component.UpdateStateGraphAnimTriggers(PreviousState, NewState);
+	}
+	if (Component.bReplicateState && Component.GetOwnerRole() == ROLE_Authority)
+	{
+		Component.NetSync.NotifyAuthorityTransition(NewState);
+		Component.ReplicatedState.Packed = Component.NetSync.GetAuthoritativeState().Pack();
+	}
+	if (Component.bEventDrivenActive)
+	{
+		Component.UpdateEventDrivenTick();
+	}
+}
+
+void FCharacterStateComponentEnvironment::OnStateRestored(ECharacterState PreviousState, ECharacterState NewState)
+{
+	// Seen from outside the rollback, the character simply changed state once.
+	if (PreviousState != NewState)
+	{
+		OnStateChanged(PreviousState, NewState);
+	}
+	else if (Component.bEventDrivenActive)
+	{
+		Component.UpdateEventDrivenTick();
+	}
+}
+
+void FCharacterStateComponentEnvironment::OnStateResumed(ECharacterState State)
+{
+	// Resumed by an event or the subsystem's scheduler while the component may be asleep.
+	Component.CurrentStateEnum = State;
+	if (Component.bEventDrivenActive)
+	{
+		Component.UpdateEventDrivenTick();
+	}
+}
+
+void FCharacterStateComponentEnvironment::OnRegionStateChanged(int32 Region, uint8 PreviousState, uint8 NewState)
+{
+	if (Region == Component.ActionRegion)
+	{
+		Component.CurrentActionState = static_cast<ECharacterActionState>(NewState);
+	}
+	if (Component.bEventDrivenActive)
+	{
+		Component.UpdateEventDrivenTick();
+	}
+}
+
+const TCHAR* FCharacterStateComponentEnvironment::GetDebugName() const
+{
+	return *Component.ObjectName;
+}
 
+// ---- UCharacterStateManagerComponent ----
 UCharacterStateManagerComponent::UCharacterStateManagerComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 }
 
+void UCharacterStateManagerComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UCharacterStateManagerComponent, ReplicatedState);
+	DOREPLIFETIME_CONDITION(UCharacterStateManagerComponent, AckedPredictionId, COND_OwnerOnly);
+}
+
+void UCharacterStateManagerComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// Registration is where the owner can change (e.g. the component was renamed into another actor).
+	RefreshCachedComponents();
+}
+
 void UCharacterStateManagerComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (ACharacter* Char = Cast<ACharacter>(GetOwner()))
+	RefreshCachedComponents();
+	if (CachedCharacter)
 	{
-		if (USkeletalMeshComponent* Mesh = Char->GetMesh())
+		if (USkeletalMeshComponent* Mesh = CachedCharacter->GetMesh())
 		{
-			MeshComponent = Mesh;
-			AnimInstance = Mesh->GetAnimInstance();
-		}
-		if (UCapsuleComponent* Capsule = Char->GetCapsuleComponent())
-		{
-			DefaultCapsuleHalfHeight = Capsule->GetUnscaledCapsuleHalfHeight();
+			SetAnimInterface(Mesh, Mesh->GetAnimInstance());
 		}
 	}
+	if (CachedCapsule)
+	{
+		DefaultCapsuleHalfHeight = CachedCapsule->GetUnscaledCapsuleHalfHeight();
+		CapsuleUpdate.Reset(DefaultCapsuleHalfHeight);
+	}
 
-	SetupIllegalTransitions();
-	CreateStates();
+	UWorld* World = GetWorld();
+	CachedSubsystem = World ? World->GetSubsystem<UCharacterStateManagerSubsystem>() : nullptr;
+
+	StateMachine.SetTraceOwnerId(GetUniqueID());
+	StateMachine.SetLatentScheduler(CachedSubsystem ? &CachedSubsystem->GetLatentScheduler() : nullptr);
+	StateMachine.SetQueueTransitions(bQueueTransitions);
+	NetSync.CorrectionDelay = NetCorrectionDelay;
+	if (bReplicateState && GetOwnerRole() == ROLE_Authority)
+	{
+		SetIsReplicated(true);
+	}
+	if (StateGraph)
+	{
+		// The table is the asset's, shared by every character of the archetype; only the capsule size is per instance.
+		CompiledStateGraph = &StateGraph->GetCompiledGraph();
+		FCharacterStateMachineSettings Settings = CompiledStateGraph->Settings;
+		Settings.DefaultCapsuleHalfHeight = DefaultCapsuleHalfHeight;
+		StateMachine.Start(CompiledStateGraph->Table, Settings);
+	}
+	else
+	{
+		StateMachine.Start(SetupIllegalTransitions(), MakeStateMachineSettings());
+	}
+	CurrentStateEnum = StateMachine.GetCurrentStateEnum();
+	ActionRegion = bUseActionLayer ? StateMachine.AddRegion(SetupActionRules()) : INDEX_NONE;
+	CurrentActionState = ECharacterActionState::None;
+	if (CachedSubsystem && CachedSubsystem->IsCollectingStats())
+	{
+		StateMachine.SetCollectStats(true);
+	}
+	PostedRequestsGate.fetch_and(~PostedRequestsClosed);
+	bPostedRequestsListed.store(false);
+	DrainPostedRequests();
 
-	CurrentState = IdleState;
-	CurrentStateEnum = ECharacterState::Idle;
-	if (CurrentState)
+	if (IsStateSimulated())
+	{
+		// Every transition arrives through OnRep_NetState; nothing to evaluate locally.
+		SetComponentTickEnabled(false);
+	}
+	else if (bEventDrivenTick && CachedCharacter && CVarCharacterStateEventDrivenTick.GetValueOnGameThread())
 	{
-		CurrentState->Enter();
+		CachedCharacter->MovementModeChangedDelegate.AddUniqueDynamic(this, &UCharacterStateManagerComponent::OnOwnerMovementModeChanged);
+		bEventDrivenActive = true;
+		UpdateEventDrivenTick();
+	}
+	else if (bUseBatchedTick && CachedSubsystem && CVarCharacterStateBatchedTick.GetValueOnGameThread()
+		&& !(bReplicateState && GetOwnerRole() == ROLE_AutonomousProxy))
+	{
+		CachedSubsystem->RegisterComponent(this);
+		SetComponentTickEnabled(false);
 	}
 }
 
 void UCharacterStateManagerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	DestroyStates();
+	if (bEventDrivenActive)
+	{
+		if (CachedCharacter)
+		{
+			CachedCharacter->MovementModeChangedDelegate.RemoveDynamic(this, &UCharacterStateManagerComponent::OnOwnerMovementModeChanged);
+		}
+		bEventDrivenActive = false;
+	}
+	if (BatchIndex != INDEX_NONE && CachedSubsystem)
+	{
+		CachedSubsystem->UnregisterComponent(this);
+	}
+	if (CapsuleUpdate.bPending && CachedSubsystem)
+	{
+		CachedSubsystem->CancelCapsuleUpdate(this);
+		CapsuleUpdate.bPending = false;
+	}
+	if (bAnimTriggerFlushPending && CachedSubsystem)
+	{
+		CachedSubsystem->CancelAnimTriggerFlush(this);
+		bAnimTriggerFlushPending = false;
+	}
+	// Close first, then wait out posters already past the gate: one of them may be about to link this component.
+	PostedRequestsGate.fetch_or(PostedRequestsClosed);
+	while ((PostedRequestsGate.load(std::memory_order_acquire) & ~PostedRequestsClosed) != 0)
+	{
+		FPlatformProcess::YieldThread();
+	}
+	if (bPostedRequestsListed.exchange(true) && CachedSubsystem)
+	{
+		// Possibly still linked: drain the subsystem's list now, which unlinks this component and leaves it marked as listed.
+		CachedSubsystem->DrainPostedRequests();
+	}
+	if (Recorder)
+	{
+		StateMachine.SetRecorder(nullptr);
+		Recorder.Reset();
+		bResumeBatchedTick = false;
+	}
+	StateMachine.Stop();
+	StateMachine.SetLatentScheduler(nullptr);
+	CompiledStateGraph = nullptr;
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -51,196 +257,394 @@ void UCharacterStateManagerComponent::TickComponent(float DeltaTime, ELevelTick
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// If not in an air state and not grounded, switch to MidAir
-	if (!AirStates.Contains(CurrentStateEnum) && !IsGrounded())
+	// First, so requests posted from other threads since the last frame are validated and applied by this tick.
+	DrainPostedRequests();
+
+	AccumulatedDeltaTime += DeltaTime;
+	const bool bTickLOD = bAllowTickLOD && CachedSubsystem && UCharacterStateManagerSubsystem::IsTickLODEnabled();
+	if (bTickLOD && !StateMachine.HasQueuedTransitions() && !CharacterStateTickLOD::ShouldTick(GFrameCounter, GetUniqueID(), TickLODLevel))
+	{
+		INC_DWORD_STAT(STAT_CharacterStateSkippedTicks);
+		return;
+	}
+
+	const uint32 NumSuppressedBefore = StateMachine.GetNumSuppressedTransitions();
+	const uint32 NumHopsBefore = StateMachine.GetNumRouteHops();
+	const uint32 NumAvoidedBefore = StateMachine.GetNumAvoidedRetries();
+	StateMachine.Tick(AccumulatedDeltaTime);
+	INC_DWORD_STAT_BY(STAT_CharacterStateSuppressedTransitions, StateMachine.GetNumSuppressedTransitions() - NumSuppressedBefore);
+	INC_DWORD_STAT_BY(STAT_CharacterStateRouteHops, StateMachine.GetNumRouteHops() - NumHopsBefore);
+	INC_DWORD_STAT_BY(STAT_CharacterStateAvoidedRetries, StateMachine.GetNumAvoidedRetries() - NumAvoidedBefore);
+	if (bReplicateState && GetOwnerRole() == ROLE_AutonomousProxy)
 	{
-		SwitchState(MidAirState);
+		NetSync.Update(AccumulatedDeltaTime);
 	}
+	AccumulatedDeltaTime = 0.f;
+	CurrentStateEnum = StateMachine.GetCurrentStateEnum();
+
+	const AActor* Owner = bTickLOD ? GetOwner() : nullptr;
+	TickLODLevel = Owner ? CharacterStateTickLOD::ComputeLevel(CachedSubsystem->GetDistanceSquaredToNearestView(Owner->GetActorLocation()),
+		UCharacterStateManagerSubsystem::GetTickLODSettings()) : 0;
+
+	// Runs before the mesh's tick (see SetAnimInterface()); the subsystem's pass later in the frame then has nothing left.
+	FlushAnimTriggers();
 
-	if (CurrentState)
+	if (bEventDrivenActive)
 	{
-		CurrentState->Tick(DeltaTime);
-		CurrentStateEnum = CurrentState->GetState();
+		UpdateEventDrivenTick();
 	}
 }
 
+void UCharacterStateManagerComponent::OnOwnerMovementModeChanged(ACharacter* Character, EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	WakeStateMachine();
+}
 
-void UCharacterStateManagerComponent::SetupIllegalTransitions()
+void UCharacterStateManagerComponent::WakeStateMachine()
 {
-	// Called once from BeginPlay(); transition rules are fixed for the lifetime of the component.
-	IllegalTransitions.Empty();
+	// Same update the tick would have run this frame: forced MidAir when airborne, then the current state's Tick.
+	CatchUpStateTime();
+	StateMachine.Tick(AccumulatedDeltaTime);
+	AccumulatedDeltaTime = 0.f;
+	CurrentStateEnum = StateMachine.GetCurrentStateEnum();
+
+	if (bEventDrivenActive)
+	{
+		UpdateEventDrivenTick();
+	}
+}
+
+void UCharacterStateManagerComponent::StartRecording(int32 MaxEntries)
+{
+	if (IsStateSimulated() || MaxEntries <= 0)
+	{
+		return;
+	}
 
-	// From Idle: cannot go to WallRun
-	IllegalTransitions.Add(ECharacterState::Idle, { ECharacterState::WallRun });
+	if (BatchIndex != INDEX_NONE && CachedSubsystem)
+	{
+		// The batched pass evaluates transitions without calling Tick(), so it would leave no frames to replay.
+		CachedSubsystem->UnregisterComponent(this);
+		SetComponentTickEnabled(true);
+		bResumeBatchedTick = true;
+	}
+	Recorder = MakeUnique<FCharacterStateRecorder>(MaxEntries);
+	StateMachine.SetRecorder(Recorder.Get());
+}
 
-	// From Walking: cannot go to WallRun
-	IllegalTransitions.Add(ECharacterState::Walking, { ECharacterState::WallRun });
+bool UCharacterStateManagerComponent::StopRecording(const FString& FilePath)
+{
+	if (!Recorder)
+	{
+		return false;
+	}
+	StateMachine.SetRecorder(nullptr);
 
-	// From Sliding: cannot go to WallRun, Crouch
-	IllegalTransitions.Add(ECharacterState::Sliding, { ECharacterState::WallRun, ECharacterState::Crouch });
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized(static_cast<int32>(Recorder->GetSerializedSize()));
+	Recorder->Serialize(Bytes.GetData());
+	const bool bWritten = Recorder->GetNum() > 0 && FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+	Recorder.Reset();
 
-	// From MidAir: cannot go to Sliding, Sprinting, Crouch
-	IllegalTransitions.Add(ECharacterState::MidAir, { ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch });
+	if (bResumeBatchedTick && CachedSubsystem)
+	{
+		CachedSubsystem->RegisterComponent(this);
+		SetComponentTickEnabled(false);
+	}
+	bResumeBatchedTick = false;
+	return bWritten;
+}
 
-	// From WallRun: cannot go to Sliding, Sprinting, Crouch
-	IllegalTransitions.Add(ECharacterState::WallRun, { ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch });
+void UCharacterStateManagerComponent::UpdateEventDrivenTick()
+{
+	const bool bNeedsTick = StateMachine.NeedsTick();
+	if (bNeedsTick != IsComponentTickEnabled())
+	{
+		CatchUpStateTime();
+		SetComponentTickEnabled(bNeedsTick);
+		if (!bNeedsTick)
+		{
+			const UWorld* World = GetWorld();
+			SleepStartTime = World ? World->GetTimeSeconds() : 0.0;
+		}
+	}
+}
 
-	// From Sprinting: cannot go to WallRun, Crouch (slide instead)
-	IllegalTransitions.Add(ECharacterState::Sprinting, { ECharacterState::WallRun, ECharacterState::Crouch });
+void UCharacterStateManagerComponent::CatchUpStateTime()
+{
+	// Nothing ticks the state machine while it sleeps, so its dwell times would otherwise stop at the moment it fell asleep.
+	const UWorld* World = GetWorld();
+	if (!bEventDrivenActive || IsComponentTickEnabled() || !World)
+	{
+		return;
+	}
+	const double Now = World->GetTimeSeconds();
+	StateMachine.AdvanceStateTime(static_cast<float>(Now - SleepStartTime));
+	SleepStartTime = Now;
+}
 
-	// From Crouch: cannot go to WallRun
-	IllegalTransitions.Add(ECharacterState::Crouch, { ECharacterState::WallRun });
+FCharacterStateTransitionTable UCharacterStateManagerComponent::SetupIllegalTransitions() const
+{
+	// Called once from BeginPlay(); transition rules are fixed for the lifetime of the component.
+	FCharacterStateTransitionTable Table = CharacterStateRules::Default;
 
-	// From Grapple: cannot go to Sliding, Sprinting, Crouch
-	IllegalTransitions.Add(ECharacterState::Grapple, { ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch });
+	for (const FCharacterStateTransitionRule& Rule : IllegalTransitionOverrides)
+	{
+		Table.SetIllegal(Rule.From, static_cast<FCharacterStateMask>(Rule.IllegalTo));
+	}
 
 	// setup state categories
-	NormalStates = { ECharacterState::Idle, ECharacterState::Walking };
-	AirStates = { ECharacterState::MidAir, ECharacterState::WallRun, ECharacterState::Grapple };
-	GroundStates = { ECharacterState::Idle, ECharacterState::Walking, ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch };
+	Table.NormalStates = static_cast<FCharacterStateMask>(NormalStates);
+	Table.AirStates = static_cast<FCharacterStateMask>(AirStates);
+	Table.GroundStates = static_cast<FCharacterStateMask>(GroundStates);
+	return Table;
 }
 
-void UCharacterStateManagerComponent::CreateStates()
+FCharacterStateMachineSettings UCharacterStateManagerComponent::MakeStateMachineSettings() const
 {
-	DestroyStates();
-	IdleState = new FIdleState(this);
-	WalkingState = new FWalkingState(this);
-	SlidingState = new FSlidingState(this);
-	MidAirState = new FMidAirState(this);
-	WallRunState = new FWallRunState(this);
-	SprintingState = new FSprintingState(this);
-	CrouchState = new FCrouchState(this);
-	GrappleState = new FGrappleState(this);
+	FCharacterStateMachineSettings Settings;
+	Settings.NormalStateWalkThreshold = NormalStateWalkThreshold;
+	Settings.SprintingMinSpeed = SprintingMinSpeed;
+	Settings.CrouchCapsuleHalfHeight = CrouchCapsuleHalfHeight;
+	Settings.DefaultCapsuleHalfHeight = DefaultCapsuleHalfHeight;
+	Settings.NormalStateWalkHysteresis = NormalStateWalkHysteresis;
+	Settings.SprintingHysteresis = SprintingHysteresis;
+	for (const TPair<ECharacterState, float>& DwellTime : MinDwellTimes)
+	{
+		Settings.MinDwellTime[static_cast<uint8>(DwellTime.Key)] = DwellTime.Value;
+	}
+	for (const TPair<ECharacterState, float>& Duration : MaxStateDurations)
+	{
+		Settings.MaxTimeInState[static_cast<uint8>(Duration.Key)] = Duration.Value;
+	}
+	for (const TPair<ECharacterState, float>& Cooldown : StateCooldowns)
+	{
+		Settings.Cooldown[static_cast<uint8>(Cooldown.Key)] = Cooldown.Value;
+	}
+	return Settings;
 }
 
-void UCharacterStateManagerComponent::DestroyStates()
+FCharacterStateRegionRules UCharacterStateManagerComponent::SetupActionRules() const
 {
-	auto DeleteState = [](FCharacterBaseState*& S) { delete S; S = nullptr; };
-	DeleteState(IdleState);
-	DeleteState(WalkingState);
-	DeleteState(SlidingState);
-	DeleteState(MidAirState);
-	DeleteState(WallRunState);
-	DeleteState(SprintingState);
-	DeleteState(CrouchState);
-	DeleteState(GrappleState);
-	if (CurrentState) { CurrentState = nullptr; }
+	FCharacterStateRegionRules Rules = CharacterStateRules::DefaultActions;
+	for (const FCharacterActionStateRule& Rule : ActionRuleOverrides)
+	{
+		const uint8 Action = static_cast<uint8>(Rule.Action);
+		Rules.BlockedWhile[Action] = static_cast<FCharacterStateMask>(Rule.BlockedWhile);
+		Rules.IllegalTo[Action] = static_cast<FCharacterStateMask>(Rule.IllegalTo);
+		Rules.Duration[Action] = Rule.Duration;
+	}
+	return Rules;
 }
 
-void UCharacterStateManagerComponent::SwitchState(FCharacterBaseState* NewState)
+bool UCharacterStateManagerComponent::SetActionState(ECharacterActionState NewState)
 {
-	if (!NewState) return;
+	if (ActionRegion == INDEX_NONE || IsStateSimulated())
+	{
+		return false;
+	}
+
+	CatchUpStateTime();
+	return StateMachine.SwitchRegionState(ActionRegion, static_cast<uint8>(NewState));
+}
 
-	if (const TSet<ECharacterState>* IllegalSet = IllegalTransitions.Find(CurrentStateEnum))
+void UCharacterStateManagerComponent::UpdateStateGraphAnimTriggers(ECharacterState PreviousState, ECharacterState NewState)
+{
+	const FName& PreviousTrigger = CompiledStateGraph->AnimTriggers[static_cast<uint8>(PreviousState)];
+	const FName& NewTrigger = CompiledStateGraph->AnimTriggers[static_cast<uint8>(NewState)];
+	if (!PreviousTrigger.IsNone())
 	{
-		if (IllegalSet->Contains(NewState->GetState()))
-		{
-			UE_LOG(LogTemp, Warning, TEXT("%s: Invalid transition to state %d"), *ObjectName, static_cast<int32>(NewState->GetState()));
-			return;
-		}
+		QueueAnimTrigger(PreviousTrigger, false);
 	}
+	if (!NewTrigger.IsNone())
+	{
+		QueueAnimTrigger(NewTrigger, true);
+	}
+}
 
-	const ECharacterState NewStateEnum = NewState->GetState();
-	UE_LOG(LogTemp, Log, TEXT("%s: Transitioning to state %d"), *ObjectName, static_cast<int32>(NewStateEnum));
+void UCharacterStateManagerComponent::SwitchState(FCharacterBaseState* NewState)
+{
+	StateMachine.SwitchState(NewState);
+}
 
-	// On-screen print (like Blueprint Print String)
-	if (GEngine)
+bool UCharacterStateManagerComponent::SwitchStateByEnum(ECharacterState NewState)
+{
+	if (IsStateSimulated())
 	{
-		static const TCHAR* StateNames[] = { TEXT("Idle"), TEXT("Walking"), TEXT("Sliding"), TEXT("MidAir"), TEXT("WallRun"), TEXT("Sprinting"), TEXT("Crouch"), TEXT("Grapple") };
-		const int32 Idx = static_cast<int32>(NewStateEnum);
-		const FString Msg = ObjectName.IsEmpty() ? FString(StateNames[Idx]) : FString::Printf(TEXT("%s: %s"), *ObjectName, StateNames[Idx]);
-		GEngine->AddOnScreenDebugMessage(INDEX_NONE, 2.f, FColor::White, Msg);
+		return false;
 	}
 
-	if (CurrentState)
+	CatchUpStateTime();
+	bool bResult = false;
+	if (bReplicateState && GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		const int32 PredictionId = NetSync.PredictSwitch(NewState);
+		if (PredictionId != INDEX_NONE)
+		{
+			ServerRequestState(NewState, static_cast<uint8>(PredictionId));
+			bResult = true;
+		}
+	}
+	else
+	{
+		bResult = StateMachine.SwitchStateByEnum(NewState);
+	}
+	if (bEventDrivenActive && StateMachine.HasQueuedTransitions())
 	{
-		CurrentState->Exit();
+		// A queued request is applied by the next tick.
+		UpdateEventDrivenTick();
 	}
-	CurrentState = NewState;
-	CurrentStateEnum = NewState->GetState();
-	CurrentState->Enter();
+	return bResult;
 }
 
-bool UCharacterStateManagerComponent::SwitchStateByEnum(ECharacterState NewState)
+bool UCharacterStateManagerComponent::RequestStateVia(ECharacterState Target, bool bImmediate)
 {
-	if (CurrentStateEnum == NewState)
+	if (IsStateSimulated() || (bReplicateState && GetOwnerRole() == ROLE_AutonomousProxy))
 	{
 		return false;
 	}
-	FCharacterBaseState* StatePtr = nullptr;
-	switch (NewState)
+
+	CatchUpStateTime();
+	const uint32 NumHopsBefore = StateMachine.GetNumRouteHops();
+	const uint32 NumAvoidedBefore = StateMachine.GetNumAvoidedRetries();
+	const bool bResult = StateMachine.RequestStateVia(Target, bImmediate);
+	INC_DWORD_STAT_BY(STAT_CharacterStateRouteHops, StateMachine.GetNumRouteHops() - NumHopsBefore);
+	INC_DWORD_STAT_BY(STAT_CharacterStateAvoidedRetries, StateMachine.GetNumAvoidedRetries() - NumAvoidedBefore);
+	if (bEventDrivenActive && (StateMachine.HasRoute() || StateMachine.HasQueuedTransitions()))
 	{
-		case ECharacterState::Idle:      StatePtr = IdleState; break;
-		case ECharacterState::Walking:   StatePtr = WalkingState; break;
-		case ECharacterState::Sliding:   StatePtr = SlidingState; break;
-		case ECharacterState::MidAir:    StatePtr = MidAirState; break;
-		case ECharacterState::WallRun:   StatePtr = WallRunState; break;
-		case ECharacterState::Sprinting: StatePtr = SprintingState; break;
-		case ECharacterState::Crouch:    StatePtr = CrouchState; break;
-		case ECharacterState::Grapple:   StatePtr = GrappleState; break;
+		// The remaining hops are taken by the next ticks.
+		UpdateEventDrivenTick();
 	}
-	if (!StatePtr)
+	return bResult;
+}
+
+bool UCharacterStateManagerComponent::SignalStateEvent(FName EventName)
+{
+	if (IsStateSimulated())
 	{
 		return false;
 	}
-	if (const TSet<ECharacterState>* IllegalSet = IllegalTransitions.Find(CurrentStateEnum))
+
+	CatchUpStateTime();
+	return StateMachine.SignalEvent(GetTypeHash(EventName));
+}
+
+uint32 UCharacterStateManagerComponent::PostStateRequest(ECharacterState NewState)
+{
+	// Entering and the closed check are one atomic step, so EndPlay() either refuses this post or waits for it to finish.
+	if ((PostedRequestsGate.fetch_add(1, std::memory_order_acquire) & PostedRequestsClosed) != 0)
+	{
+		PostedRequestsGate.fetch_sub(1, std::memory_order_release);
+		return 0;
+	}
+
+	const uint32 Sequence = PostedRequests.Post(NewState);
+	if (Sequence != 0 && !bPostedRequestsListed.exchange(true))
 	{
-		if (IllegalSet->Contains(NewState))
+		// Linking needs the subsystem; components without one drain in TickComponent() only.
+		if (UCharacterStateManagerSubsystem* Subsystem = CachedSubsystem)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s: Invalid transition to state %d"), *ObjectName, static_cast<int32>(NewState));
-			return false;
+			Subsystem->LinkPostedRequests(this);
 		}
 	}
-	SwitchState(StatePtr);
-	return true;
+	PostedRequestsGate.fetch_sub(1, std::memory_order_release);
+	return Sequence;
+}
+
+void UCharacterStateManagerComponent::DrainPostedRequests()
+{
+	if (ArePostedRequestsClosed() || PostedRequests.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 NumDrained = PostedRequests.Drain([this](ECharacterState Target, uint32 Sequence)
+	{
+		SwitchStateByEnum(Target);
+	});
+	INC_DWORD_STAT_BY(STAT_CharacterStatePostedRequests, NumDrained);
+}
+
+void UCharacterStateManagerComponent::ServerRequestState_Implementation(ECharacterState NewState, uint8 PredictionId)
+{
+	NetSync.ServerHandlePrediction(NewState, PredictionId);
+	AckedPredictionId = NetSync.GetAckedPredictionId();
+}
+
+void UCharacterStateManagerComponent::OnRep_NetState()
+{
+	NetSync.ReceiveAuthoritativeState(FCharacterStateNetState::Unpack(ReplicatedState.Packed), AckedPredictionId, IsStateSimulated());
+	CurrentStateEnum = StateMachine.GetCurrentStateEnum();
 }
 
 void UCharacterStateManagerComponent::SetAnimInterface(USkeletalMeshComponent* InMesh, UAnimInstance* InAnimInstance)
 {
 	MeshComponent = InMesh;
 	AnimInstance = InAnimInstance;
+	AnimTriggers.Resolve(InAnimInstance);
+	if (InMesh)
+	{
+		// Triggers flushed at the end of TickComponent() are then seen by this frame's anim update.
+		InMesh->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+	}
 }
 
-void UCharacterStateManagerComponent::SwitchToNormalState()
+void UCharacterStateManagerComponent::SaveRollbackFrame(uint32 Frame)
 {
-	const FVector Vel = GetLinearVelocity();
-	const float HorizontalSpeed = Vel.Size2D();
-	if (HorizontalSpeed >= NormalStateWalkThreshold)
+	if (!RollbackHistory)
 	{
-		SwitchState(WalkingState);
+		RollbackHistory = MakeUnique<FCharacterStateSnapshotRing>();
 	}
-	else
+	FCharacterStateMachineSnapshot Snapshot;
+	StateMachine.SaveSnapshot(Snapshot);
+	RollbackHistory->Save(Frame, Snapshot);
+}
+
+bool UCharacterStateManagerComponent::RollbackToFrame(uint32 Frame)
+{
+	const FCharacterStateMachineSnapshot* Snapshot = RollbackHistory ? RollbackHistory->Find(Frame) : nullptr;
+	if (!Snapshot)
 	{
-		SwitchState(IdleState);
+		return false;
 	}
+	StateMachine.RestoreSnapshot(*Snapshot);
+	return true;
+}
+
+void UCharacterStateManagerComponent::ReconcileRollback()
+{
+	StateMachine.ReconcileSideEffects();
+	CurrentStateEnum = StateMachine.GetCurrentStateEnum();
+}
+
+void UCharacterStateManagerComponent::RefreshCachedComponents()
+{
+	CachedCharacter = Cast<ACharacter>(GetOwner());
+	CachedMovement = CachedCharacter ? CachedCharacter->GetCharacterMovement() : nullptr;
+	CachedCapsule = CachedCharacter ? CachedCharacter->GetCapsuleComponent() : nullptr;
+}
+
+void UCharacterStateManagerComponent::SwitchToNormalState()
+{
+	CatchUpStateTime();
+	StateMachine.SwitchToNormalState();
 }
 
 bool UCharacterStateManagerComponent::IsGrounded() const
 {
-	ACharacter* Char = Cast<ACharacter>(GetOwner());
-	if (UCharacterMovementComponent* Move = Char ? Char->GetCharacterMovement() : nullptr)
-	{
-		return Move->IsMovingOnGround();
-	}
-	return false;
+	return CachedMovement ? CachedMovement->IsMovingOnGround() : false;
 }
 
 FVector UCharacterStateManagerComponent::GetLinearVelocity() const
 {
-	ACharacter* Char = Cast<ACharacter>(GetOwner());
-	if (UCharacterMovementComponent* Move = Char ? Char->GetCharacterMovement() : nullptr)
-	{
-		return Move->Velocity;
-	}
-	return FVector::ZeroVector;
+	return CachedMovement ? CachedMovement->Velocity : FVector::ZeroVector;
 }
 
 void UCharacterStateManagerComponent::SetLinearVelocity(FVector Velocity)
 {
-	ACharacter* Char = Cast<ACharacter>(GetOwner());
-	if (UCharacterMovementComponent* Move = Char ? Char->GetCharacterMovement() : nullptr)
+	if (CachedMovement)
 	{
-		Move->Velocity = Velocity;
+		CachedMovement->Velocity = Velocity;
 	}
 }
 
@@ -254,11 +658,102 @@ void UCharacterStateManagerComponent::ResetAnimTrigger(const FName& TriggerName)
 	// Override in subclass or wire to AnimBP.
 }
 
+void UCharacterStateManagerComponent::QueueAnimTrigger(FName TriggerName, bool bValue)
+{
+	AnimTriggers.Queue(TriggerName, bValue);
+	ScheduleAnimTriggerFlush();
+}
+
+void UCharacterStateManagerComponent::QueueAnimTrigger(const TCHAR* TriggerName, bool bValue)
+{
+	AnimTriggers.Queue(TriggerName, bValue);
+	ScheduleAnimTriggerFlush();
+}
+
+void UCharacterStateManagerComponent::ScheduleAnimTriggerFlush()
+{
+	if (!CachedSubsystem)
+	{
+		FlushAnimTriggers();
+	}
+	else if (!bAnimTriggerFlushPending)
+	{
+		bAnimTriggerFlushPending = true;
+		CachedSubsystem->QueueAnimTriggerFlush(this);
+	}
+}
+
+void UCharacterStateManagerComponent::FlushAnimTriggers()
+{
+	if (!AnimTriggers.HasPending())
+	{
+		return;
+	}
+
+	int32 NumApplied = 0;
+	const int32 NumCancelled = AnimTriggers.Flush(AnimInstance, [this](FName Trigger, bool bValue)
+	{
+		if (bValue)
+		{
+			SetAnimTrigger(Trigger);
+		}
+		else
+		{
+			ResetAnimTrigger(Trigger);
+		}
+	}, NumApplied);
+	INC_DWORD_STAT_BY(STAT_CharacterStateAnimTriggerCalls, NumApplied);
+	INC_DWORD_STAT_BY(STAT_CharacterStateAnimTriggersCancelled, NumCancelled);
+}
+
 void UCharacterStateManagerComponent::UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps)
 {
-	ACharacter* Char = Cast<ACharacter>(GetOwner());
-	if (UCapsuleComponent* Capsule = Char ? Char->GetCapsuleComponent() : nullptr)
+	if (!CachedCapsule)
+	{
+		return;
+	}
+	if (!CachedSubsystem)
+	{
+		CachedCapsule->SetCapsuleHalfHeight(NewHalfHeight, bUpdateOverlaps);
+		return;
+	}
+
+	bool bResizeNow = false;
+	const bool bQueue = CapsuleUpdate.Request(CachedCapsule->GetUnscaledCapsuleHalfHeight(), NewHalfHeight, bUpdateOverlaps,
+		CapsuleHalfHeightInterpSpeed, bResizeNow);
+
+	// The shape changes now so later queries this frame see it; only the overlap refresh waits for the batched pass.
+	if (bResizeNow)
+	{
+		CachedCapsule->SetCapsuleHalfHeight(NewHalfHeight, false);
+	}
+	if (bQueue)
+	{
+		CachedSubsystem->QueueCapsuleUpdate(this);
+	}
+}
+
+bool UCharacterStateManagerComponent::FlushCapsuleHalfHeight(float DeltaTime)
+{
+	if (!CachedCapsule)
+	{
+		CapsuleUpdate.bPending = false;
+		CapsuleUpdate.bOverlapsPending = false;
+		return false;
+	}
+
+	const float CurrentHalfHeight = CachedCapsule->GetUnscaledCapsuleHalfHeight();
+	float NewHalfHeight = CurrentHalfHeight;
+	bool bRefreshOverlaps = false;
+	const bool bStillMoving = CapsuleUpdate.Step(NewHalfHeight, DeltaTime, CapsuleHalfHeightInterpSpeed, bRefreshOverlaps);
+	if (NewHalfHeight != CurrentHalfHeight)
+	{
+		CachedCapsule->SetCapsuleHalfHeight(NewHalfHeight, false);
+	}
+	if (bRefreshOverlaps)
 	{
-		Capsule->SetCapsuleHalfHeight(NewHalfHeight, bUpdateOverlaps);
+		CachedCapsule->UpdateOverlaps();
+		INC_DWORD_STAT(STAT_CharacterStateCapsuleOverlapUpdates);
 	}
+	return bStillMoving;
 }
@@ -1,16 +1,123 @@
 
+
 #pragma once
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Engine/EngineTypes.h"
+#include "CharacterStateManagement/CharacterStateAnimTriggers.h"
+#include "CharacterStateManagement/CharacterStateCapsule.h"
 #include "CharacterStateManagement/CharacterStateEnum.h"
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateNet.h"
+#include "CharacterStateManagement/CharacterStateRecording.h"
+#include "CharacterStateManagement/CharacterStateRequestChannel.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
 #include "CharacterStateManagerComponent.generated.h"
 
 class FCharacterBaseState;
+class ACharacter;
+class UCharacterMovementComponent;
+class UCapsuleComponent;
 class USkeletalMeshComponent;
 class UAnimInstance;
+class UCharacterStateManagerComponent;
+class UCharacterStateManagerSubsystem;
+class UCharacterStateGraphAsset;
+struct FCharacterStateCompiledGraph;
+
+/** Data override for one row of the illegal-transition table. */
+USTRUCT(BlueprintType)
+struct FCharacterStateTransitionRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State")
+	ECharacterState From = ECharacterState::Idle;
+
+	/** States that cannot be entered from From; replaces the built-in row. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterState"))
+	int32 IllegalTo = 0;
+};
+
+/** Data override for one upper-body action (see CharacterStateRules::DefaultActions). */
+USTRUCT(BlueprintType)
+struct FCharacterActionStateRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State")
+	ECharacterActionState Action = ECharacterActionState::None;
+
+	/** Locomotion states in which Action can neither be started nor held; replaces the built-in guard. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterState"))
+	int32 BlockedWhile = 0;
+
+	/** Actions that cannot be started while Action is active. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterActionState"))
+	int32 IllegalTo = 0;
+
+	/** Seconds after which Action ends by itself; 0 holds it until another action is set. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State", meta = (ClampMin = "0"))
+	float Duration = 0.f;
+};
+
+/** Replicated state of UCharacterStateManagerComponent, serialized as a single byte (see FCharacterStateNetState). */
+USTRUCT()
+struct FCharacterStateReplicatedState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 Packed = 0;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+	{
+		Ar.SerializeBits(&Packed, FCharacterStateNetState::StateBits + FCharacterStateNetState::SequenceBits);
+		bOutSuccess = true;
+		return true;
+	}
+
+	bool operator==(const FCharacterStateReplicatedState& Other) const { return Packed == Other.Packed; }
+};
+
+template<>
+struct TStructOpsTypeTraits<FCharacterStateReplicatedState> : public TStructOpsTypeTraitsBase2<FCharacterStateReplicatedState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
 
-/** Manages character state machine: Idle, Walking, Sliding, MidAir, WallRun, Sprinting, Crouch, Grapple. */
+/** Routes the state machine core's queries and side effects to the owning component. */
+class FCharacterStateComponentEnvironment final : public ICharacterStateEnvironment
+{
+public:
+	explicit FCharacterStateComponentEnvironment(UCharacterStateManagerComponent& InComponent) : Component(InComponent) {}
+
+	virtual bool IsGrounded() const override;
+	virtual FCharacterStateVector GetLinearVelocity() const override;
+	virtual void SetLinearVelocity(const FCharacterStateVector& Velocity) override;
+	virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps) override;
+	virtual void SetAnimTrigger(const TCHAR* TriggerName) override;
+	virtual void ResetAnimTrigger(const TCHAR* TriggerName) override;
+	virtual void OnStateChanged(ECharacterState PreviousState, ECharacterState NewState) override;
+	virtual void OnStateRestored(ECharacterState PreviousState, ECharacterState NewState) override;
+	virtual void OnRegionStateChanged(int32 Region, uint8 PreviousState, uint8 NewState) override;
+	virtual void OnStateResumed(ECharacterState State) override;
+	virtual const TCHAR* GetDebugName() const override;
+
+private:
+	UCharacterStateManagerComponent& Component;
+};
+
+/**
+ * Manages character state machine: Idle, Walking, Sliding, MidAir, WallRun, Sprinting, Crouch, Grapple.
+ * Thin adapter over the engine-independent FCharacterStateMachine.
+ */
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class CD_TEMP_API UCharacterStateManagerComponent : public UActorComponent
 {
@@ -19,9 +126,11 @@ class CD_TEMP_API UCharacterStateManagerComponent : public UActorComponent
 public:
 	UCharacterStateManagerComponent();
 
+	virtual void OnRegister() override;
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	/** Current state enum (for Blueprint/query). */
 	UPROPERTY(BlueprintReadOnly, Category = "State")
@@ -34,6 +143,106 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "State", meta = (DisplayName = "Switch State By Enum"))
 	bool SwitchStateByEnum(ECharacterState NewState);
 
+	/**
+	 * Thread-safe switch request for behavior tree services, EQS callbacks and async tasks. The request is handled on the game
+	 * thread like SwitchStateByEnum(), at the start of this component's next tick or the subsystem's next pass. Never allocates.
+	 * Returns a sequence number for HasHandledStateRequest(), or 0 if too many requests are pending or the component is not
+	 * playing, and this one was dropped.
+	 */
+	uint32 PostStateRequest(ECharacterState NewState);
+
+	/** Any thread. True once the posted request with this sequence number has gone through SwitchStateByEnum(). */
+	bool HasHandledStateRequest(uint32 Sequence) const { return PostedRequests.HasDrained(Sequence); }
+
+	/**
+	 * Heads for Target along the shortest legal route when the direct switch would be illegal (e.g. Sprinting -> Walking ->
+	 * Crouch): the first hop is taken now and one more per tick, or all of them now with bImmediate. Returns false if already
+	 * in Target, Target cannot be reached, or state is driven by the server. Not predicted; server or standalone only.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "State")
+	bool RequestStateVia(ECharacterState Target, bool bImmediate = false);
+
+	/**
+	 * Resumes the current state if it is a latent state awaiting this event (FCharacterStateMachine::AwaitEvent() with
+	 * GetTypeHash(EventName)), e.g. from a montage's OnMontageEnded or an async trace callback. Returns true if it did.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "State")
+	bool SignalStateEvent(FName EventName);
+
+	/** Hops taken by RequestStateVia() routes (also in stat game). */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "State")
+	int32 GetNumRouteHops() const { return static_cast<int32>(StateMachine.GetNumRouteHops()); }
+
+	/** Returns the registered state or built-in handle for an enum value (see FCharacterStateMachine::FindState()), or nullptr before BeginPlay. */
+	FCharacterBaseState* FindState(ECharacterState State) const { return StateMachine.FindState(State); }
+
+	/**
+	 * Runs upper-body actions (ECharacterActionState) as a second region of the same state machine: evaluated in the same
+	 * tick, with guards against the locomotion state instead of a combined enum or a second component.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Actions")
+	bool bUseActionLayer = false;
+
+	/** Actions whose built-in rules (CharacterStateRules::DefaultActions) are replaced. */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Actions")
+	TArray<FCharacterActionStateRule> ActionRuleOverrides;
+
+	/** Current upper-body action; None without bUseActionLayer. */
+	UPROPERTY(BlueprintReadOnly, Category = "State|Actions")
+	ECharacterActionState CurrentActionState = ECharacterActionState::None;
+
+	/**
+	 * Starts an upper-body action, or ends one with None. Returns false if the action layer is off, the action is already
+	 * active, or the action rules or the current locomotion state forbid it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "State|Actions")
+	bool SetActionState(ECharacterActionState NewState);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "State|Actions")
+	ECharacterActionState GetActionState() const { return CurrentActionState; }
+
+	/**
+	 * If true, this component is ticked by UCharacterStateManagerSubsystem in one batched pass instead of its own tick function
+	 * (see CharacterState.BatchedTick). Leave it off when replacing the built-in state objects with states that have their own
+	 * Tick logic.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bUseBatchedTick = false;
+
+	/**
+	 * If true, the component's tick is disabled while the current state has no per-frame logic (Idle, Walking, ...) and is
+	 * re-enabled by the owner's movement mode changes (walking off a ledge, landing) and by state switches
+	 * (see CharacterState.EventDrivenTick). Takes precedence over bUseBatchedTick.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bEventDrivenTick = false;
+
+	/**
+	 * If true, the state machine runs at 1/2, 1/4 or 1/8 rate when far from every player viewpoint (see CharacterState.TickLOD),
+	 * with the skipped frames' DeltaTime passed to the next Tick. The forced switch to MidAir is delayed by at most
+	 * CharacterStateTickLOD::MaxFrameInterval frames.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bAllowTickLOD = false;
+
+	/**
+	 * If true, switch requests made during a frame are coalesced (forced air transitions win) and applied once at the end of the
+	 * state machine's tick, so only the final Exit/Enter pair runs. See FCharacterStateMachine::SetQueueTransitions().
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	bool bQueueTransitions = false;
+
+	/**
+	 * If true, the server's state is replicated as one packed byte that is only sent when it changes. The owning client predicts
+	 * SwitchStateByEnum() locally and reconciles with the server (FCharacterStateNetSync); other clients follow the server.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Network")
+	bool bReplicateState = false;
+
+	/** Seconds the owning client's state may disagree with the server before it is corrected; about one round trip. */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Network", meta = (ClampMin = "0"))
+	float NetCorrectionDelay = 0.25f;
+
 	/** Optional display name for logging. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State")
 	FString ObjectName;
@@ -44,30 +253,69 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "State")
 	TObjectPtr<UAnimInstance> AnimInstance = nullptr;
 
-	/** Set from character to enable animation triggers. */
+	/**
+	 * Set from character to enable animation triggers. Resolves the trigger names to bool properties of the AnimInstance's
+	 * class and makes the mesh tick after this component, so triggers flushed by TickComponent() reach this frame's anim update.
+	 */
 	void SetAnimInterface(USkeletalMeshComponent* InMesh, UAnimInstance* InAnimInstance);
 
-	// ---- State instances (owned by this component) ----
-	FCharacterBaseState* IdleState = nullptr;
-	FCharacterBaseState* WalkingState = nullptr;
-	FCharacterBaseState* SlidingState = nullptr;
-	FCharacterBaseState* MidAirState = nullptr;
-	FCharacterBaseState* WallRunState = nullptr;
-	FCharacterBaseState* SprintingState = nullptr;
-	FCharacterBaseState* CrouchState = nullptr;
-	FCharacterBaseState* GrappleState = nullptr;
+	/**
+	 * Resolves the owning character and its movement and capsule components. Called from OnRegister() and BeginPlay();
+	 * call it again after replacing either component at runtime.
+	 */
+	void RefreshCachedComponents();
+
+	/** Runs one state machine update now and re-evaluates whether the event-driven tick is needed. */
+	void WakeStateMachine();
+
+	/**
+	 * Starts recording the state machine's inputs and switch requests (FCharacterStateRecorder), up to MaxEntries frames and
+	 * requests. A batched component ticks on its own while recording so that every frame's inputs are captured.
+	 */
+	void StartRecording(int32 MaxEntries);
+
+	/** Stops recording and writes the log to FilePath. Returns false if nothing was recorded or the file could not be written. */
+	bool StopRecording(const FString& FilePath);
+
+	bool IsRecording() const { return Recorder.IsValid(); }
+
+	/**
+	 * Rollback: saves the state machine's snapshot for Frame into a ring of the last FCharacterStateSnapshotRing::Capacity
+	 * frames, allocated on first use. Call once per simulated frame, before the frame runs.
+	 */
+	void SaveRollbackFrame(uint32 Frame);
+
+	/**
+	 * Rewinds the state machine to the snapshot saved for Frame without Exit/Enter. Resimulate the following frames, then call
+	 * ReconcileRollback() once. Returns false if Frame is no longer in the ring.
+	 */
+	bool RollbackToFrame(uint32 Frame);
+
+	/** Applies the net effect of a rollback and resimulation to the character (see FCharacterStateMachine::ReconcileSideEffects()). */
+	void ReconcileRollback();
 
 	/** Normal grounded states (Idle/Walking). */
-	UPROPERTY(EditDefaultsOnly, Category = "State")
-	TSet<ECharacterState> NormalStates;
+	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterState"))
+	int32 NormalStates = CharacterStateRules::Default.NormalStates;
 
 	/** Air states: MidAir, WallRun, Grapple. If not in one of these and not grounded, we switch to MidAir. */
-	UPROPERTY(EditDefaultsOnly, Category = "State")
-	TSet<ECharacterState> AirStates;
+	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterState"))
+	int32 AirStates = CharacterStateRules::Default.AirStates;
 
 	/** Ground states: Idle, Walking, Sliding, Sprinting, Crouch. */
+	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (Bitmask, BitmaskEnum = "/Script/CD_TEMP.ECharacterState"))
+	int32 GroundStates = CharacterStateRules::Default.GroundStates;
+
+	/**
+	 * Shared state graph for this archetype. When set, its compiled rules, speed guards, state timeouts, cooldowns and
+	 * animation triggers are used as-is and the table, threshold and timer properties on this component are ignored.
+	 */
 	UPROPERTY(EditDefaultsOnly, Category = "State")
-	TSet<ECharacterState> GroundStates;
+	TObjectPtr<UCharacterStateGraphAsset> StateGraph = nullptr;
+
+	/** Rows that replace the built-in illegal transitions (CharacterStateRules::Default). */
+	UPROPERTY(EditDefaultsOnly, Category = "State")
+	TArray<FCharacterStateTransitionRule> IllegalTransitionOverrides;
 
 	/** Horizontal speed above this threshold enters Walking; below enters Idle. Used when landing (e.g. from MidAir). */
 	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (ClampMin = "0"))
@@ -81,6 +329,48 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (ClampMin = "0"))
 	float CrouchCapsuleHalfHeight = 44.f;
 
+	/** Half-width of the speed band around NormalStateWalkThreshold when switching between Idle and Walking; damps switching on noisy speeds. */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Thresholds", meta = (ClampMin = "0"))
+	float NormalStateWalkHysteresis = 0.f;
+
+	/** Sprinting is only left once horizontal speed is this far below SprintingMinSpeed. */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Thresholds", meta = (ClampMin = "0"))
+	float SprintingHysteresis = 0.f;
+
+	/** Seconds a state must be held before a speed threshold may switch out of it; forced and requested switches are not delayed. */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Thresholds")
+	TMap<ECharacterState, float> MinDwellTimes;
+
+	/**
+	 * Seconds after which a state is left on its own: back to Idle/Walking when grounded, MidAir otherwise (e.g. Sliding's
+	 * maximum duration, WallRun's time limit, Grapple's maximum attach time). Runs on the subsystem's timing wheel, so timed
+	 * states need not tick. With a StateGraph, its states' MaxTimeInState apply instead.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Timers")
+	TMap<ECharacterState, float> MaxStateDurations;
+
+	/**
+	 * Seconds after leaving a state before it can be entered again (e.g. Crouch); server authority is not held back. With a
+	 * StateGraph, its states' Cooldown apply instead.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State|Timers")
+	TMap<ECharacterState, float> StateCooldowns;
+
+	/** Seconds until State can be entered again after its cooldown; 0 if it can now. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "State")
+	float GetStateCooldownLeft(ECharacterState State) const { return StateMachine.GetCooldownLeft(State); }
+
+	/** Speed threshold switches held back by the bands and dwell times above (also in stat game). */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "State")
+	int32 GetNumSuppressedTransitions() const { return static_cast<int32>(StateMachine.GetNumSuppressedTransitions()); }
+
+	/**
+	 * Speed (units per second) at which UpdateCapsuleHalfHeight() moves the capsule towards its target; 0 applies the
+	 * change at once. Overlaps are refreshed once the target is reached, not on every step.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State", meta = (ClampMin = "0"))
+	float CapsuleHalfHeightInterpSpeed = 0.f;
+
 	/** Cached default capsule half-height from BeginPlay. */
 	UPROPERTY(VisibleInstanceOnly, Category = "State")
 	float DefaultCapsuleHalfHeight = 0.f;
@@ -88,17 +378,21 @@ public:
 	/** Switch to Idle or Walking based on current horizontal speed (e.g. call when landing from MidAir). */
 	void SwitchToNormalState();
 
-	/** Illegal transitions: current state -> set of states we cannot transition to. */
-	TMap<ECharacterState, TSet<ECharacterState>> IllegalTransitions;
+	/** True if the transition table allows From -> To. */
+	bool IsTransitionLegal(ECharacterState From, ECharacterState To) const { return StateMachine.IsTransitionLegal(From, To); }
+
+	/** Engine-independent state machine driven by this component. */
+	FCharacterStateMachine& GetStateMachine() { return StateMachine; }
+	const FCharacterStateMachine& GetStateMachine() const { return StateMachine; }
 
 	/** Get current state object (C++ only). */
-	FCharacterBaseState* GetCurrentState() const { return CurrentState; }
+	FCharacterBaseState* GetCurrentState() const { return StateMachine.GetCurrentState(); }
 
 	/** Get current state as enum (Blueprint and C++). */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "State")
-	ECharacterState GetCurrentStateEnum() const { return CurrentStateEnum; }
+	ECharacterState GetCurrentStateEnum() const { return StateMachine.GetCurrentStateEnum(); }
 
-	/** Helpers that states may call. */
+	/** Helpers that states may call. The default implementations read the components cached by RefreshCachedComponents(). */
 	UFUNCTION(BlueprintCallable, Category = "State")
 	virtual bool IsGrounded() const;
 
@@ -108,12 +402,30 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "State")
 	virtual void SetLinearVelocity(FVector Velocity);
 
+	/**
+	 * Called by FlushAnimTriggers() for triggers that have no bool property of the same name on AnimInstance. State objects
+	 * and state graphs do not call these directly: their triggers are buffered with QueueAnimTrigger().
+	 */
 	UFUNCTION(BlueprintCallable, Category = "State")
 	virtual void SetAnimTrigger(const FName& TriggerName);
 
 	UFUNCTION(BlueprintCallable, Category = "State")
 	virtual void ResetAnimTrigger(const FName& TriggerName);
 
+	/**
+	 * Buffers a trigger change until the next FlushAnimTriggers(): at the end of this component's tick, or in the subsystem's
+	 * pass for batched and sleeping components. Without the subsystem it is applied at once.
+	 */
+	void QueueAnimTrigger(FName TriggerName, bool bValue);
+	void QueueAnimTrigger(const TCHAR* TriggerName, bool bValue);
+
+	/** Applies the buffered trigger changes that survived the frame (see FCharacterStateAnimTriggerBuffer). */
+	void FlushAnimTriggers();
+
+	/**
+	 * Sets the capsule's target half-height. Requests matching the current height are dropped; with the batched subsystem,
+	 * the overlap refresh (and any interpolation) is deferred to one pass per frame for all characters.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "State")
 	virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps = true);
 
@@ -121,9 +433,133 @@ public:
 	float GetCrouchCapsuleHalfHeight() const { return CrouchCapsuleHalfHeight; }
 
 protected:
-	void SetupIllegalTransitions();
-	void CreateStates();
-	void DestroyStates();
+	/** Builds the transition table from CharacterStateRules::Default and the data overrides above. */
+	FCharacterStateTransitionTable SetupIllegalTransitions() const;
+
+	/** Settings for the core, taken from the properties above. */
+	FCharacterStateMachineSettings MakeStateMachineSettings() const;
+
+	/** Action region rules from CharacterStateRules::DefaultActions and ActionRuleOverrides. */
+	FCharacterStateRegionRules SetupActionRules() const;
+
+	/** Fires the StateGraph's animation triggers for a transition: resets the one of PreviousState, sets the one of NewState. */
+	void UpdateStateGraphAnimTriggers(ECharacterState PreviousState, ECharacterState NewState);
+
+	/** Owning client's predicted switch; applied through the server's rules and acknowledged via AckedPredictionId. */
+	UFUNCTION(Server, Reliable)
+	void ServerRequestState(ECharacterState NewState, uint8 PredictionId);
+
+	UFUNCTION()
+	void OnRep_NetState();
+
+	/** True on clients whose state is driven purely by replication. */
+	bool IsStateSimulated() const { return bReplicateState && GetOwnerRole() == ROLE_SimulatedProxy; }
+
+	/** Event-driven mode: grounded state can only change with the movement mode, so this replaces the per-frame probe. */
+	UFUNCTION()
+	void OnOwnerMovementModeChanged(ACharacter* Character, EMovementMode PrevMovementMode, uint8 PreviousCustomMode);
+
+	/** Event-driven mode: enables the tick only while the state machine has per-frame work. */
+	void UpdateEventDrivenTick();
+
+	/** Event-driven mode: advances the state machine's time in state by the world time spent asleep. */
+	void CatchUpStateTime();
+
+	/**
+	 * Called by UCharacterStateManagerSubsystem once per frame while a capsule change is pending: steps the interpolation and,
+	 * once the target is reached, refreshes overlaps if any request asked for it. Returns true while still interpolating.
+	 */
+	bool FlushCapsuleHalfHeight(float DeltaTime);
+
+	/** Game thread: runs the requests posted with PostStateRequest() through SwitchStateByEnum(), oldest first. */
+	void DrainPostedRequests();
+
+	/** After QueueAnimTrigger(): flushes at once without the subsystem, otherwise adds this component to its flush list. */
+	void ScheduleAnimTriggerFlush();
+
+private:
+	friend class UCharacterStateManagerSubsystem;
+	friend class FCharacterStateComponentEnvironment;
+
+	/** Resolved once instead of casting the owner on every query; cleared by GC if the components are destroyed. */
+	UPROPERTY(Transient)
+	TObjectPtr<ACharacter> CachedCharacter = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UCharacterMovementComponent> CachedMovement = nullptr;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UCapsuleComponent> CachedCapsule = nullptr;
+
+	/** Source of player viewpoints for per-component tick LOD. */
+	UPROPERTY(Transient)
+	TObjectPtr<UCharacterStateManagerSubsystem> CachedSubsystem = nullptr;
+
+	/** StateGraph's compiled graph, resolved in BeginPlay(); owned by the asset and shared with every other user of it. */
+	const FCharacterStateCompiledGraph* CompiledStateGraph = nullptr;
+
+	FCharacterStateComponentEnvironment Environment{ *this };
+	FCharacterStateMachine StateMachine{ Environment };
+	FCharacterStateNetSync NetSync{ StateMachine };
+
+	UPROPERTY(ReplicatedUsing = OnRep_NetState)
+	FCharacterStateReplicatedState ReplicatedState;
+
+	/** Last ServerRequestState() handled by the server; owner only. */
+	UPROPERTY(ReplicatedUsing = OnRep_NetState)
+	uint8 AckedPredictionId = 0;
+
+	/** State machine region of the action layer, or INDEX_NONE without bUseActionLayer. */
+	int32 ActionRegion = INDEX_NONE;
+
+	/** Slot in UCharacterStateManagerSubsystem's arrays, or INDEX_NONE when ticking per component. */
+	int32 BatchIndex = INDEX_NONE;
+
+	/** True once BeginPlay() has bound the movement mode delegate for bEventDrivenTick. */
+	bool bEventDrivenActive = false;
+
+	/** World time at which the event-driven tick was last disabled, or last caught up by CatchUpStateTime(). */
+	double SleepStartTime = 0.0;
+
+	/** Pending capsule change, applied by FlushCapsuleHalfHeight(). */
+	FCharacterStateCapsuleUpdate CapsuleUpdate;
+
+	/** Requests from PostStateRequest(); any thread posts, the game thread drains. */
+	FCharacterStateRequestChannel PostedRequests;
+
+	/**
+	 * True while this component is linked in the subsystem's list of components with posted requests, so the first post after
+	 * each drain links it once. Held true outside BeginPlay()/EndPlay(), which keeps ended components out of the list.
+	 */
+	std::atomic<bool> bPostedRequestsListed{ true };
+
+	/**
+	 * PostedRequestsClosed while posting is refused (outside BeginPlay()/EndPlay()), plus the number of PostStateRequest() calls
+	 * in flight. EndPlay() sets the flag, then waits for the count to reach zero, so no poster can link this component into the
+	 * subsystem's list after EndPlay() has unlinked it.
+	 */
+	static constexpr uint32 PostedRequestsClosed = 1u << 31;
+	std::atomic<uint32> PostedRequestsGate{ PostedRequestsClosed };
+
+	bool ArePostedRequestsClosed() const { return (PostedRequestsGate.load(std::memory_order_relaxed) & PostedRequestsClosed) != 0; }
+
+	/** Next component in the subsystem's list of components with posted requests. */
+	UCharacterStateManagerComponent* NextPostedRequests = nullptr;
+
+	/** Trigger changes since the last FlushAnimTriggers(), and whether the subsystem has this component in its flush list. */
+	FCharacterStateAnimTriggerBuffer AnimTriggers;
+	bool bAnimTriggerFlushPending = false;
+
+	/** Active recording, if any; see StartRecording(). */
+	TUniquePtr<FCharacterStateRecorder> Recorder;
+
+	/** Rollback history; see SaveRollbackFrame(). */
+	TUniquePtr<FCharacterStateSnapshotRing> RollbackHistory;
+
+	/** True if StartRecording() took the component out of the batched tick; StopRecording() puts it back. */
+	bool bResumeBatchedTick = false;
 
-	FCharacterBaseState* CurrentState = nullptr;
+	/** Per-component tick LOD: current level and the DeltaTime of frames skipped since the last state machine update. */
+	uint8 TickLODLevel = 0;
+	float AccumulatedDeltaTime = 0.f;
 };
@@ -0,0 +1,977 @@
+
+#include "CharacterStateManagement/CharacterStateManagerSubsystem.h"
+#include "CharacterStateManagement/CharacterStateManagerComponent.h"
+#include "CharacterStateManagement/CharacterBaseState.h"
+#include "CharacterStateManagement/CharacterStateRecording.h"
+#include "CharacterStateManagement/CharacterStateTrace.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("CharacterState Batched Tick"), STAT_CharacterStateBatchedTick, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("CharacterState Evaluate"), STAT_CharacterStateEvaluate, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("CharacterState Apply"), STAT_CharacterStateApply, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("CharacterState Capsule Flush"), STAT_CharacterStateCapsuleFlush, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("CharacterState Anim Trigger Flush"), STAT_CharacterStateAnimTriggerFlush, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("CharacterState Latent Update"), STAT_CharacterStateLatentUpdate, STATGROUP_Game);
+DEFINE_STAT(STAT_CharacterStateSkippedTicks);
+DEFINE_STAT(STAT_CharacterStateCapsuleOverlapUpdates);
+DEFINE_STAT(STAT_CharacterStateSuppressedTransitions);
+DEFINE_STAT(STAT_CharacterStatePostedRequests);
+DEFINE_STAT(STAT_CharacterStateAnimTriggerCalls);
+DEFINE_STAT(STAT_CharacterStateAnimTriggersCancelled);
+DEFINE_STAT(STAT_CharacterStateRouteHops);
+DEFINE_STAT(STAT_CharacterStateAvoidedRetries);
+DEFINE_STAT(STAT_CharacterStateLatentResumes);
+DEFINE_STAT(STAT_CharacterStateTimeouts);
+
+static int32 GCharacterStateParallelChunkSize = 256;
+static FAutoConsoleVariableRef CVarCharacterStateParallelChunkSize(
+	TEXT("CharacterState.BatchedTick.ChunkSize"),
+	GCharacterStateParallelChunkSize,
+	TEXT("Characters evaluated per worker task by the batched tick. 0 evaluates serially on the game thread."));
+
+static bool GCharacterStateTickLOD = true;
+static FAutoConsoleVariableRef CVarCharacterStateTickLOD(
+	TEXT("CharacterState.TickLOD"),
+	GCharacterStateTickLOD,
+	TEXT("Evaluate state machines far from every player viewpoint at 1/2, 1/4 or 1/8 rate (components with bAllowTickLOD)."));
+
+static float GCharacterStateTickLODHalfRateDistance = 1500.f;
+static FAutoConsoleVariableRef CVarCharacterStateTickLODHalfRateDistance(
+	TEXT("CharacterState.TickLOD.HalfRateDistance"),
+	GCharacterStateTickLODHalfRateDistance,
+	TEXT("Distance from the nearest viewpoint beyond which state machines tick every 2nd frame."));
+
+static float GCharacterStateTickLODQuarterRateDistance = 3000.f;
+static FAutoConsoleVariableRef CVarCharacterStateTickLODQuarterRateDistance(
+	TEXT("CharacterState.TickLOD.QuarterRateDistance"),
+	GCharacterStateTickLODQuarterRateDistance,
+	TEXT("Distance from the nearest viewpoint beyond which state machines tick every 4th frame."));
+
+static float GCharacterStateTickLODEighthRateDistance = 6000.f;
+static FAutoConsoleVariableRef CVarCharacterStateTickLODEighthRateDistance(
+	TEXT("CharacterState.TickLOD.EighthRateDistance"),
+	GCharacterStateTickLODEighthRateDistance,
+	TEXT("Distance from the nearest viewpoint beyond which state machines tick every 8th frame."));
+
+static float GCharacterStateTickLODBudgetUs = 500.f;
+static FAutoConsoleVariableRef CVarCharacterStateTickLODBudgetUs(
+	TEXT("CharacterState.TickLOD.BudgetUs"),
+	GCharacterStateTickLODBudgetUs,
+	TEXT("Batched evaluation budget in microseconds. Over budget, every character drops one tick LOD level (at most 1/8 rate); 0 disables."));
+
+#if CHARACTER_STATE_WITH_TRACE
+static FAutoConsoleVariableRef CVarCharacterStateTrace(
+	TEXT("CharacterState.Trace"),
+	FCharacterStateTrace::bEnabled,
+	TEXT("Record every state transition into the FCharacterStateTrace ring buffer."));
+
+static int32 GCharacterStateShowTrace = 0;
+static FAutoConsoleVariableRef CVarCharacterStateShowTrace(
+	TEXT("CharacterState.ShowTrace"),
+	GCharacterStateShowTrace,
+	TEXT("Show the N most recent state transitions on screen (0 = off). Enables CharacterState.Trace."));
+#endif
+
+static int32 ComputeNumChunks(int32 NumCharacters)
+{
+	if (GCharacterStateParallelChunkSize <= 0 || NumCharacters <= GCharacterStateParallelChunkSize)
+	{
+		return 1;
+	}
+	return FMath::DivideAndRoundUp(NumCharacters, GCharacterStateParallelChunkSize);
+}
+
+/** CharacterState.BenchBatchedTick [Iterations]: times the evaluation pass at 1, 2, 4 .. N chunks over the registered characters. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateBenchBatchedTickCommand(
+	TEXT("CharacterState.BenchBatchedTick"),
+	TEXT("Times the batched transition evaluation at 1..N worker chunks over the currently registered characters."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCharacterStateManagerSubsystem* Batch = World ? World->GetSubsystem<UCharacterStateManagerSubsystem>() : nullptr;
+		if (!Batch || Batch->GetNumRegistered() == 0)
+		{
+			return;
+		}
+
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+		const int32 MaxChunks = FMath::Max(1, FPlatformMisc::NumberOfWorkerThreadsToSpawn() + 1);
+		for (int32 NumChunks = 1; ; NumChunks = FMath::Min(NumChunks * 2, MaxChunks))
+		{
+			const double Start = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Batch->EvaluateTransitions(NumChunks, 0.f);
+			}
+			const double Micros = (FPlatformTime::Seconds() - Start) * 1e6 / Iterations;
+			UE_LOG(LogTemp, Display, TEXT("CharacterState batched evaluate: %d characters, %d chunks: %.1f us/frame"), Batch->GetNumRegistered(), NumChunks, Micros);
+			if (NumChunks == MaxChunks)
+			{
+				break;
+			}
+		}
+	}));
+
+/**
+ * CharacterState.BenchSpawn Class [Count]: spawns Count characters of Class in a grid, logs the time taken by the spawns
+ * (BeginPlay included) and the state machine rule sets they share, then destroys them.
+ */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateBenchSpawnCommand(
+	TEXT("CharacterState.BenchSpawn"),
+	TEXT("Times spawning N characters of a class (default 5000) and reports how many state machine rule sets they share."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UClass* CharacterClass = Args.Num() > 0 ? LoadClass<ACharacter>(nullptr, *Args[0]) : nullptr;
+		if (!World || !CharacterClass)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("CharacterState.BenchSpawn: expected a character class path, e.g. /Game/BP_Npc.BP_Npc_C"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5000;
+		const int32 Columns = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count))));
+		const int32 RuleSetsBefore = FCharacterStateRuleSet::GetNumInterned();
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TArray<AActor*> Spawned;
+		Spawned.Reserve(Count);
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const FVector Location(200.f * (Index % Columns), 200.f * (Index / Columns), 200.f);
+			if (AActor* Actor = World->SpawnActor(CharacterClass, &Location, nullptr, SpawnParameters))
+			{
+				Spawned.Add(Actor);
+			}
+		}
+		const double Millis = (FPlatformTime::Seconds() - Start) * 1e3;
+
+		UE_LOG(LogTemp, Display, TEXT("CharacterState spawn: %d characters in %.2f ms (%.2f us each), %d new rule sets (%d interned), %d bytes of rules each"),
+			Spawned.Num(), Millis, Spawned.Num() > 0 ? Millis * 1e3 / Spawned.Num() : 0.0, FCharacterStateRuleSet::GetNumInterned() - RuleSetsBefore,
+			FCharacterStateRuleSet::GetNumInterned(), static_cast<int32>(sizeof(FCharacterStateRuleSetRef)));
+
+		for (AActor* Actor : Spawned)
+		{
+			Actor->Destroy();
+		}
+	}));
+
+/**
+ * CharacterState.BenchPost [Producers] [Requests]: Producers tasks each post Requests switch requests into one
+ * FCharacterStateRequestChannel while another task drains it; logs the throughput and how often the channel was full.
+ */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateBenchPostCommand(
+	TEXT("CharacterState.BenchPost"),
+	TEXT("Measures the cross-thread request channel under contention: N producer tasks (default 16) posting M requests each (default 100000)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumProducers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 16;
+		const int32 NumRequests = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100000;
+
+		FCharacterStateRequestChannel Channel;
+		std::atomic<int32> NumProducersDone{ 0 };
+		std::atomic<int64> NumFull{ 0 };
+		int64 NumDrained = 0;
+
+		// The consumer is the last task, so a serial ParallelFor runs it after the producers instead of spinning first;
+		// producers drop requests while the channel is full rather than waiting for it.
+		const double Start = FPlatformTime::Seconds();
+		ParallelFor(NumProducers + 1, [&](int32 Task)
+		{
+			if (Task == NumProducers)
+			{
+				while (NumProducersDone.load() < NumProducers)
+				{
+					NumDrained += Channel.Drain([](ECharacterState Target, uint32 Sequence) {});
+				}
+				NumDrained += Channel.Drain([](ECharacterState Target, uint32 Sequence) {});
+				return;
+			}
+
+			int64 Full = 0;
+			for (int32 Index = 0; Index < NumRequests; ++Index)
+			{
+				if (Channel.Post(static_cast<ECharacterState>(Index % NumCharacterStates)) == 0)
+				{
+					++Full;
+				}
+			}
+			NumFull += Full;
+			++NumProducersDone;
+		});
+		const double Seconds = FPlatformTime::Seconds() - Start;
+
+		const int64 NumPosts = static_cast<int64>(NumProducers) * NumRequests;
+		UE_LOG(LogTemp, Display, TEXT("CharacterState post: %d producers, %lld posts in %.2f ms (%.1f ns each), %lld drained, %lld found the channel full"),
+			NumProducers, NumPosts, Seconds * 1e3, Seconds * 1e9 / NumPosts, NumDrained, NumFull.load());
+	}));
+
+/**
+ * CharacterState.BenchRollback [Characters] [Frames] [Iterations]: headless FCharacterStateRollbackBenchmark; logs the cost of
+ * rewinding and resimulating every character against the 1 ms budget.
+ */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateBenchRollbackCommand(
+	TEXT("CharacterState.BenchRollback"),
+	TEXT("Times restoring, resimulating and reconciling N state machines (default 64) over M frames (default 10), averaged over K runs (default 1000)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 64;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10;
+		const int32 NumRollbacks = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 1000;
+
+		const FCharacterStateRollbackBenchmarkReport Report = FCharacterStateRollbackBenchmark::Run(NumCharacters, NumFrames, NumRollbacks);
+		UE_LOG(LogTemp, Display, TEXT("CharacterState rollback: %d characters x %d frames in %.3f ms average, %.3f ms worst (budget 1 ms: %s), %u mismatches, %d bytes per snapshot"),
+			Report.NumCharacters, Report.NumFrames, Report.AverageSeconds * 1e3, Report.WorstSeconds * 1e3, Report.WorstSeconds <= 1e-3 ? TEXT("met") : TEXT("missed"),
+			Report.NumMismatches, static_cast<int32>(sizeof(FCharacterStateMachineSnapshot)));
+	}));
+
+/**
+ * CharacterState.BenchLatent [Characters] [Frames]: headless FCharacterStateLatentBenchmark; logs polling against latent
+ * states for a mixed population.
+ */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateBenchLatentCommand(
+	TEXT("CharacterState.BenchLatent"),
+	TEXT("Runs N characters (default 5000) in mixed states for M frames (default 600), once with polling states and once with latent states and a scheduler."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 5000;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 600;
+
+		const FCharacterStateLatentBenchmarkReport Report = FCharacterStateLatentBenchmark::Run(NumCharacters, NumFrames);
+		UE_LOG(LogTemp, Display, TEXT("CharacterState latent: %d characters x %d frames, polling %.3f ms/frame (%llu ticks), latent %.3f ms/frame (%llu ticks, %u scheduled resumes), %u mismatches"),
+			Report.NumCharacters, Report.NumFrames, Report.PollingSeconds * 1e3 / Report.NumFrames, Report.NumPollingTicks,
+			Report.LatentSeconds * 1e3 / Report.NumFrames, Report.NumLatentTicks, Report.NumScheduledResumes, Report.NumMismatches);
+	}));
+
+/**
+ * CharacterState.BenchTimeouts [Characters] [Frames]: headless FCharacterStateTimeoutBenchmark; logs per-frame polling of
+ * time in state against timeouts on the timing wheel.
+ */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateBenchTimeoutsCommand(
+	TEXT("CharacterState.BenchTimeouts"),
+	TEXT("Runs N characters (default 5000) in timed states for M frames (default 600), once polling their time in state and once with timeouts on the timing wheel."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 5000;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 600;
+
+		const FCharacterStateTimeoutBenchmarkReport Report = FCharacterStateTimeoutBenchmark::Run(NumCharacters, NumFrames);
+		UE_LOG(LogTemp, Display, TEXT("CharacterState timeouts: %d characters x %d frames, polling %.3f ms/frame (%llu ticks), wheel %.3f ms/frame (%llu ticks, %u timeouts, %u cascaded), %u mismatches"),
+			Report.NumCharacters, Report.NumFrames, Report.PollingSeconds * 1e3 / Report.NumFrames, Report.NumPollingTicks,
+			Report.WheelSeconds * 1e3 / Report.NumFrames, Report.NumWheelTicks, Report.NumTimeouts, Report.NumCascaded, Report.NumMismatches);
+	}));
+
+/** CharacterState.Record.Start [MaxEntries]: starts recording every state machine in the world. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateRecordStartCommand(
+	TEXT("CharacterState.Record.Start"),
+	TEXT("Records the inputs and switch requests of every character state machine in the world (default 36000 entries each)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 MaxEntries = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 36000;
+		for (TObjectIterator<UCharacterStateManagerComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World && It->HasBegunPlay())
+			{
+				It->StartRecording(MaxEntries);
+			}
+		}
+	}));
+
+/** CharacterState.Record.Stop: writes one Saved/CharacterState/<Owner>_<Id>.csrec file per recording character. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateRecordStopCommand(
+	TEXT("CharacterState.Record.Stop"),
+	TEXT("Stops recording and writes Saved/CharacterState/<Owner>_<Id>.csrec for every recorded state machine."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		for (TObjectIterator<UCharacterStateManagerComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World && It->IsRecording())
+			{
+				const FString FilePath = FPaths::ProjectSavedDir() / TEXT("CharacterState") / FString::Printf(TEXT("%s_%u.csrec"), *GetNameSafe(It->GetOwner()), It->GetUniqueID());
+				if (It->StopRecording(FilePath))
+				{
+					UE_LOG(LogTemp, Display, TEXT("CharacterState recording written to %s"), *FilePath);
+				}
+			}
+		}
+	}));
+
+/** CharacterState.Replay File [Iterations]: replays a recording headlessly and logs time per state, oscillations and divergences. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateReplayCommand(
+	TEXT("CharacterState.Replay"),
+	TEXT("Replays a .csrec recording without a world and reports time per state, oscillating transitions and divergences from the recording."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		TArray<uint8> Bytes;
+		FCharacterStateRecordingView Recording;
+		if (Args.Num() == 0 || !FFileHelper::LoadFileToArray(Bytes, *Args[0]) || !FCharacterStateRecordingView::FromBytes(Bytes.GetData(), Bytes.Num(), Recording))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("CharacterState.Replay: not a state machine recording"));
+			return;
+		}
+
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1;
+		FCharacterStateReplayer Replayer;
+		FCharacterStateReplayReport Report;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Report = Replayer.Replay(Recording);
+		}
+		const double Seconds = (FPlatformTime::Seconds() - Start) / Iterations;
+
+		UE_LOG(LogTemp, Display, TEXT("CharacterState replay: %u frames, %.1f s recorded, replayed in %.3f ms (%.0fx real time)"),
+			Report.NumFrames, Report.TotalTime, Seconds * 1e3, Seconds > 0.0 ? Report.TotalTime / Seconds : 0.0);
+		for (int32 State = 0; State < NumCharacterStates; ++State)
+		{
+			if (Report.TimeInState[State] > 0.0)
+			{
+				UE_LOG(LogTemp, Display, TEXT("  %-10s %8.2f s (%.1f%%)"), GetCharacterStateName(static_cast<ECharacterState>(State)),
+					Report.TimeInState[State], Report.TotalTime > 0.0 ? 100.0 * Report.TimeInState[State] / Report.TotalTime : 0.0);
+			}
+		}
+		UE_LOG(LogTemp, Display, TEXT("  %u transitions, %u oscillations (first at %.2f s), %u divergences (first at entry %d)"),
+			Report.NumTransitions, Report.NumOscillations, Report.FirstOscillationTime, Report.NumDivergences, Report.FirstDivergence);
+		for (int32 From = 0; From < NumCharacterStates; ++From)
+		{
+			for (int32 To = 0; To < NumCharacterStates; ++To)
+			{
+				if (Report.Oscillations[From][To] > 0)
+				{
+					UE_LOG(LogTemp, Display, TEXT("  oscillating %s <-> %s: %u"), GetCharacterStateName(static_cast<ECharacterState>(From)),
+						GetCharacterStateName(static_cast<ECharacterState>(To)), Report.Oscillations[From][To]);
+				}
+			}
+		}
+	}));
+
+#if CHARACTER_STATE_WITH_STATS
+/** CharacterState.Stats.Start: clears and starts per-state stats on every state machine in the world. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateStatsStartCommand(
+	TEXT("CharacterState.Stats.Start"),
+	TEXT("Clears and starts collecting time in state, transition, rejection and hook cost counters for every character in the world."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCharacterStateManagerSubsystem* Subsystem = World ? World->GetSubsystem<UCharacterStateManagerSubsystem>() : nullptr)
+		{
+			Subsystem->ResetStats();
+			Subsystem->SetCollectStats(true);
+		}
+	}));
+
+/** CharacterState.Stats.Stop: pauses collection; collected stats are kept for Dump and Export. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateStatsStopCommand(
+	TEXT("CharacterState.Stats.Stop"),
+	TEXT("Pauses per-state stats collection; collected values are kept."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCharacterStateManagerSubsystem* Subsystem = World ? World->GetSubsystem<UCharacterStateManagerSubsystem>() : nullptr)
+		{
+			Subsystem->SetCollectStats(false);
+		}
+	}));
+
+/** CharacterState.Stats.Dump: logs the world's stats per state, then its most frequent transitions and rejections. */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateStatsDumpCommand(
+	TEXT("CharacterState.Stats.Dump"),
+	TEXT("Logs time in state and hook costs per state, and transition and rejection counts per edge, summed over the world."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCharacterStateManagerSubsystem* Subsystem = World ? World->GetSubsystem<UCharacterStateManagerSubsystem>() : nullptr;
+		FCharacterStateStats Stats;
+		const int32 NumMachines = Subsystem ? Subsystem->GatherStats(Stats) : 0;
+		if (NumMachines == 0)
+		{
+			UE_LOG(LogTemp, Display, TEXT("CharacterState stats: nothing collected (CharacterState.Stats.Start)"));
+			return;
+		}
+
+		const double MillisPerCycle = FCharacterStateStats::SecondsPerCycle() * 1e3;
+		UE_LOG(LogTemp, Display, TEXT("CharacterState stats: %d machines, %u transitions, %u rejected"), NumMachines, Stats.GetNumTransitions(), Stats.GetNumRejected());
+		for (int32 State = 0; State < NumCharacterStates; ++State)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %-10s %10.2f s  enter %6u %8.3f ms  tick %8u %8.3f ms  exit %6u %8.3f ms"),
+				GetCharacterStateName(static_cast<ECharacterState>(State)), Stats.TimeInState[State],
+				Stats.HookCalls[State][0], Stats.HookCycles[State][0] * MillisPerCycle,
+				Stats.HookCalls[State][1], Stats.HookCycles[State][1] * MillisPerCycle,
+				Stats.HookCalls[State][2], Stats.HookCycles[State][2] * MillisPerCycle);
+		}
+		for (int32 From = 0; From < NumCharacterStates; ++From)
+		{
+			for (int32 To = 0; To < NumCharacterStates; ++To)
+			{
+				if (Stats.Transitions[From][To] > 0 || Stats.Rejected[From][To] > 0)
+				{
+					UE_LOG(LogTemp, Display, TEXT("  %s -> %s: %u taken, %u rejected"), GetCharacterStateName(static_cast<ECharacterState>(From)),
+						GetCharacterStateName(static_cast<ECharacterState>(To)), Stats.Transitions[From][To], Stats.Rejected[From][To]);
+				}
+			}
+		}
+	}));
+
+/** CharacterState.Stats.Export [File]: writes the world's stats as CSV (default Saved/CharacterState/Stats.csv). */
+static FAutoConsoleCommandWithWorldAndArgs CharacterStateStatsExportCommand(
+	TEXT("CharacterState.Stats.Export"),
+	TEXT("Writes the per-state stats of the world as CSV (default Saved/CharacterState/Stats.csv)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCharacterStateManagerSubsystem* Subsystem = World ? World->GetSubsystem<UCharacterStateManagerSubsystem>() : nullptr;
+		const FString FilePath = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("CharacterState") / TEXT("Stats.csv");
+		if (Subsystem && Subsystem->ExportStatsCsv(FilePath))
+		{
+			UE_LOG(LogTemp, Display, TEXT("CharacterState stats written to %s"), *FilePath);
+		}
+	}));
+#endif
+
+void UCharacterStateManagerSubsystem::Deinitialize()
+{
+	while (Components.Num() > 0)
+	{
+		UnregisterComponent(Components.Last());
+	}
+	Super::Deinitialize();
+}
+
+TStatId UCharacterStateManagerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCharacterStateManagerSubsystem, STATGROUP_Tickables);
+}
+
+void UCharacterStateManagerSubsystem::RegisterComponent(UCharacterStateManagerComponent* Component)
+{
+	if (!Component || Component->BatchIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	Component->BatchIndex = Components.Add(Component);
+	States.Add(Component->GetCurrentStateEnum());
+	Grounded.Add(false);
+	HorizontalSpeedsSquared.Add(0.f);
+	StateTimes.Add(0.f);
+	SkippedDeltaTimes.Add(0.f);
+	RuleSets.Add(&Component->GetStateMachine().GetRuleSet());
+	TickLevels.Add(0);
+	TickPhases.Add(Component->GetUniqueID());
+	ViewDistancesSquared.Add(0.f);
+}
+
+void UCharacterStateManagerSubsystem::UnregisterComponent(UCharacterStateManagerComponent* Component)
+{
+	if (!Component || !Components.IsValidIndex(Component->BatchIndex) || Components[Component->BatchIndex] != Component)
+	{
+		return;
+	}
+
+	RemoveAtSwap(Component->BatchIndex);
+	Component->BatchIndex = INDEX_NONE;
+}
+
+void UCharacterStateManagerSubsystem::RemoveAtSwap(int32 Index)
+{
+	Components.RemoveAtSwap(Index);
+	States.RemoveAtSwap(Index);
+	Grounded.RemoveAtSwap(Index);
+	HorizontalSpeedsSquared.RemoveAtSwap(Index);
+	StateTimes.RemoveAtSwap(Index);
+	SkippedDeltaTimes.RemoveAtSwap(Index);
+	RuleSets.RemoveAtSwap(Index);
+	TickLevels.RemoveAtSwap(Index);
+	TickPhases.RemoveAtSwap(Index);
+	ViewDistancesSquared.RemoveAtSwap(Index);
+
+	if (Components.IsValidIndex(Index))
+	{
+		Components[Index]->BatchIndex = Index;
+	}
+}
+
+void UCharacterStateManagerSubsystem::GatherInputs(float DeltaTime)
+{
+	// Game thread: the only reads of the components, their movement and their actors, so workers never call into them.
+	// The only writes are to each character's own state machine clock.
+	NumSkippedLastFrame = 0;
+	for (int32 Index = 0; Index < Components.Num(); ++Index)
+	{
+		if (!CharacterStateTickLOD::ShouldTick(TickLODFrame, TickPhases[Index], TickLevels[Index]))
+		{
+			SkippedDeltaTimes[Index] += DeltaTime;
+			++NumSkippedLastFrame;
+			continue;
+		}
+
+		UCharacterStateManagerComponent* Component = Components[Index];
+		FCharacterStateMachine& Machine = Component->GetStateMachine();
+		Machine.AdvanceStateTime(SkippedDeltaTimes[Index] + DeltaTime);
+		SkippedDeltaTimes[Index] = 0.f;
+
+		States[Index] = Machine.GetCurrentStateEnum();
+		StateTimes[Index] = Machine.GetTimeInState();
+		Grounded[Index] = Component->IsGrounded();
+		HorizontalSpeedsSquared[Index] = Component->GetLinearVelocity().SizeSquared2D();
+
+		const AActor* Owner = bTickLODActive && Component->bAllowTickLOD ? Component->GetOwner() : nullptr;
+		ViewDistancesSquared[Index] = Owner ? GetDistanceSquaredToNearestView(Owner->GetActorLocation()) : 0.f;
+	}
+}
+
+void UCharacterStateManagerSubsystem::DecideRange(int32 Begin, int32 End, TArray<FPendingSwitch>& OutSwitches, TArray<int32>& OutSuppressed)
+{
+	// Tight loop over the gathered arrays. Skipped characters keep their level until they are next evaluated.
+	for (int32 Index = Begin; Index < End; ++Index)
+	{
+		if (!CharacterStateTickLOD::ShouldTick(TickLODFrame, TickPhases[Index], TickLevels[Index]))
+		{
+			continue;
+		}
+
+		bool bSuppressed = false;
+		const FCharacterStateRuleSet& Rules = *RuleSets[Index];
+		const ECharacterState Target = FCharacterStateMachine::EvaluateTransition(States[Index], Grounded[Index], HorizontalSpeedsSquared[Index],
+			StateTimes[Index], Rules.Table, Rules.Settings, bSuppressed);
+		if (Target != States[Index])
+		{
+			OutSwitches.Add({ Components[Index], Target });
+		}
+		else if (bSuppressed)
+		{
+			OutSuppressed.Add(Index);
+		}
+		TickLevels[Index] = CharacterStateTickLOD::ComputeLevel(ViewDistancesSquared[Index], TickLODSettings, TickLODBias);
+	}
+}
+
+void UCharacterStateManagerSubsystem::EvaluateTransitions(int32 NumChunks, float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterStateEvaluate);
+
+	const int32 Num = Components.Num();
+	NumChunks = FMath::Clamp(NumChunks, 1, FMath::Max(Num, 1));
+	const int32 ChunkSize = FMath::DivideAndRoundUp(FMath::Max(Num, 1), NumChunks);
+
+	ChunkSwitches.SetNum(NumChunks);
+	ChunkSuppressed.SetNum(NumChunks);
+	for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+	{
+		ChunkSwitches[Chunk].Reset();
+		ChunkSuppressed[Chunk].Reset();
+	}
+
+	GatherInputs(DeltaTime);
+
+	ParallelFor(NumChunks, [this, Num, ChunkSize](int32 Chunk)
+	{
+		const int32 Begin = Chunk * ChunkSize;
+		DecideRange(Begin, FMath::Min(Begin + ChunkSize, Num), ChunkSwitches[Chunk], ChunkSuppressed[Chunk]);
+	}, NumChunks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Back on the game thread: the machines' counters are only ever written here.
+	for (const TArray<int32>& Suppressed : ChunkSuppressed)
+	{
+		for (const int32 Index : Suppressed)
+		{
+			Components[Index]->GetStateMachine().NoteSuppressedTransition();
+		}
+		INC_DWORD_STAT_BY(STAT_CharacterStateSuppressedTransitions, Suppressed.Num());
+	}
+}
+
+void UCharacterStateManagerSubsystem::ApplyPendingSwitches()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterStateApply);
+
+	// Chunks cover ascending index ranges, so this is the same order as a serial pass.
+	// Only characters that change state pay for Exit/Enter (capsule updates etc. stay on the game thread).
+	for (const TArray<FPendingSwitch>& Switches : ChunkSwitches)
+	{
+		for (const FPendingSwitch& Pending : Switches)
+		{
+			// An earlier switch's Enter/Exit may have ended play for this component.
+			if (Pending.Component->BatchIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			FCharacterStateMachine& Machine = Pending.Component->GetStateMachine();
+			if (Machine.IsQueueingTransitions())
+			{
+				// Only the forced air switch decides MidAir; landing and speed drop-outs are normal requests.
+				Machine.RequestState(Pending.Target, Pending.Target == ECharacterState::MidAir ? ECharacterStateRequestPriority::Forced : ECharacterStateRequestPriority::Normal);
+			}
+			else
+			{
+				Pending.Component->SwitchState(Machine.FindState(Pending.Target));
+			}
+		}
+	}
+
+	// Queued mode: the batch's decisions and this frame's gameplay requests are applied together, once per character.
+	// Active RequestStateVia() routes take their next hop first, from the state the batch left them in.
+	// Timed region states (e.g. a melee swing) that ran out during evaluation end here too.
+	// Collected first: a switch here may end play for any component, and the swap-remove would move another one under the walk.
+	MachineUpdates.Reset();
+	for (UCharacterStateManagerComponent* Component : Components)
+	{
+		const FCharacterStateMachine& Machine = Component->GetStateMachine();
+		if (Machine.HasRoute() || Machine.HasQueuedTransitions() || Machine.HasRegionUpdate())
+		{
+			MachineUpdates.Add(Component);
+		}
+	}
+	for (UCharacterStateManagerComponent* Component : MachineUpdates)
+	{
+		if (Component->BatchIndex != INDEX_NONE)
+		{
+			FCharacterStateMachine& Machine = Component->GetStateMachine();
+			if (Machine.HasRoute())
+			{
+				const uint32 NumHopsBefore = Machine.GetNumRouteHops();
+				const uint32 NumAvoidedBefore = Machine.GetNumAvoidedRetries();
+				Machine.AdvanceRoute();
+				INC_DWORD_STAT_BY(STAT_CharacterStateRouteHops, Machine.GetNumRouteHops() - NumHopsBefore);
+				INC_DWORD_STAT_BY(STAT_CharacterStateAvoidedRetries, Machine.GetNumAvoidedRetries() - NumAvoidedBefore);
+			}
+			if (Machine.HasQueuedTransitions())
+			{
+				Machine.ApplyQueuedTransitions();
+			}
+			if (Machine.HasRegionUpdate())
+			{
+				Machine.UpdateRegions();
+			}
+		}
+	}
+}
+
+void UCharacterStateManagerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterStateBatchedTick);
+
+	// Before evaluation, so switches requested from other threads since the last frame are part of this frame's decisions.
+	DrainPostedRequests();
+
+	// Also before evaluation: switches and requests made by resumed and timed out states are applied by this pass.
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CharacterStateLatentUpdate);
+		const uint32 NumTimedOutBefore = LatentScheduler.GetNumTimedOut();
+		INC_DWORD_STAT_BY(STAT_CharacterStateLatentResumes, LatentScheduler.Update(DeltaTime));
+		INC_DWORD_STAT_BY(STAT_CharacterStateTimeouts, LatentScheduler.GetNumTimedOut() - NumTimedOutBefore);
+	}
+
+	++TickLODFrame;
+	bTickLODActive = IsTickLODEnabled();
+	TickLODSettings = GetTickLODSettings();
+	UpdateViewLocations();
+
+	const double EvaluateStart = FPlatformTime::Seconds();
+	EvaluateTransitions(ComputeNumChunks(Components.Num()), DeltaTime);
+	UpdateTickLODBias(FPlatformTime::Seconds() - EvaluateStart);
+	INC_DWORD_STAT_BY(STAT_CharacterStateSkippedTicks, NumSkippedLastFrame);
+
+	ApplyPendingSwitches();
+	FlushAnimTriggers();
+
+	// Last, so capsule changes from every path this frame (batched, per-component, gameplay) share one overlap pass.
+	FlushCapsuleUpdates(DeltaTime);
+
+#if CHARACTER_STATE_WITH_TRACE
+	if (GCharacterStateShowTrace > 0)
+	{
+		DrawTraceOverlay();
+	}
+#endif
+}
+
+void UCharacterStateManagerSubsystem::LinkPostedRequests(UCharacterStateManagerComponent* Component)
+{
+	// Treiber push; the consumer always takes the whole list, so there is no ABA problem.
+	UCharacterStateManagerComponent* Head = PostedRequestsHead.load(std::memory_order_relaxed);
+	do
+	{
+		Component->NextPostedRequests = Head;
+	}
+	while (!PostedRequestsHead.compare_exchange_weak(Head, Component, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void UCharacterStateManagerSubsystem::DrainPostedRequests()
+{
+	UCharacterStateManagerComponent* Component = PostedRequestsHead.exchange(nullptr, std::memory_order_acquire);
+	while (Component)
+	{
+		UCharacterStateManagerComponent* Next = Component->NextPostedRequests;
+		Component->NextPostedRequests = nullptr;
+		if (!Component->ArePostedRequestsClosed())
+		{
+			// Unlisted before draining: a request posted from here on links the component again instead of being missed.
+			Component->bPostedRequestsListed.store(false);
+			Component->DrainPostedRequests();
+		}
+		Component = Next;
+	}
+}
+
+void UCharacterStateManagerSubsystem::QueueCapsuleUpdate(UCharacterStateManagerComponent* Component)
+{
+	if (Component)
+	{
+		PendingCapsuleUpdates.Add(Component);
+	}
+}
+
+void UCharacterStateManagerSubsystem::CancelCapsuleUpdate(UCharacterStateManagerComponent* Component)
+{
+	PendingCapsuleUpdates.RemoveSingleSwap(Component);
+}
+
+void UCharacterStateManagerSubsystem::FlushCapsuleUpdates(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterStateCapsuleFlush);
+
+	// UpdateOverlaps() can end play for any component (CancelCapsuleUpdate()) or resize one (QueueCapsuleUpdate()), so the
+	// list is swapped out before the walk: those only touch the new list, and the components still interpolating go back
+	// on it. Components cancelled during the walk have cleared CapsuleUpdate.bPending and are skipped.
+	Swap(FlushingCapsuleUpdates, PendingCapsuleUpdates);
+	for (UCharacterStateManagerComponent* Component : FlushingCapsuleUpdates)
+	{
+		if (Component && Component->CapsuleUpdate.bPending && Component->FlushCapsuleHalfHeight(DeltaTime))
+		{
+			PendingCapsuleUpdates.Add(Component);
+		}
+	}
+	FlushingCapsuleUpdates.Reset();
+}
+
+void UCharacterStateManagerSubsystem::QueueAnimTriggerFlush(UCharacterStateManagerComponent* Component)
+{
+	if (Component)
+	{
+		PendingAnimTriggerFlushes.Add(Component);
+	}
+}
+
+void UCharacterStateManagerSubsystem::CancelAnimTriggerFlush(UCharacterStateManagerComponent* Component)
+{
+	PendingAnimTriggerFlushes.RemoveSingleSwap(Component);
+
+	// During FlushAnimTriggers() the component may still be waiting on the list being walked; it is skipped there.
+	const int32 FlushingIndex = FlushingAnimTriggerFlushes.Find(Component);
+	if (FlushingIndex != INDEX_NONE)
+	{
+		FlushingAnimTriggerFlushes[FlushingIndex] = nullptr;
+	}
+}
+
+void UCharacterStateManagerSubsystem::FlushAnimTriggers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterStateAnimTriggerFlush);
+
+	// A SetAnimTrigger() override may queue triggers (QueueAnimTriggerFlush()) or end play for any component
+	// (CancelAnimTriggerFlush()), so the list is swapped out before the walk, as in FlushCapsuleUpdates(). Components queued
+	// again after their flush go on the new list and are flushed next frame; cancelled ones are nulled and skipped.
+	Swap(FlushingAnimTriggerFlushes, PendingAnimTriggerFlushes);
+	for (UCharacterStateManagerComponent* Component : FlushingAnimTriggerFlushes)
+	{
+		if (Component)
+		{
+			Component->bAnimTriggerFlushPending = false;
+			Component->FlushAnimTriggers();
+		}
+	}
+	FlushingAnimTriggerFlushes.Reset();
+}
+
+bool UCharacterStateManagerSubsystem::IsTickLODEnabled()
+{
+	return GCharacterStateTickLOD;
+}
+
+CharacterStateTickLOD::FSettings UCharacterStateManagerSubsystem::GetTickLODSettings()
+{
+	CharacterStateTickLOD::FSettings LODSettings;
+	LODSettings.HalfRateDistance = GCharacterStateTickLODHalfRateDistance;
+	LODSettings.QuarterRateDistance = GCharacterStateTickLODQuarterRateDistance;
+	LODSettings.EighthRateDistance = GCharacterStateTickLODEighthRateDistance;
+	return LODSettings;
+}
+
+void UCharacterStateManagerSubsystem::UpdateViewLocations()
+{
+	ViewLocations.Reset();
+	if (!GCharacterStateTickLOD)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			FVector Location;
+			FRotator Rotation;
+			PlayerController->GetPlayerViewPoint(Location, Rotation);
+			ViewLocations.Add(Location);
+		}
+	}
+}
+
+float UCharacterStateManagerSubsystem::GetDistanceSquaredToNearestView(const FVector& Location) const
+{
+	if (ViewLocations.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	double Nearest = FVector::DistSquared(Location, ViewLocations[0]);
+	for (int32 Index = 1; Index < ViewLocations.Num(); ++Index)
+	{
+		Nearest = FMath::Min(Nearest, FVector::DistSquared(Location, ViewLocations[Index]));
+	}
+	return static_cast<float>(Nearest);
+}
+
+void UCharacterStateManagerSubsystem::UpdateTickLODBias(double EvaluateSeconds)
+{
+	if (!bTickLODActive || GCharacterStateTickLODBudgetUs <= 0.f)
+	{
+		TickLODBias = 0;
+		return;
+	}
+
+	// One level per frame in either direction; the band between half and full budget holds the current bias.
+	const double EvaluateMicros = EvaluateSeconds * 1e6;
+	if (EvaluateMicros > GCharacterStateTickLODBudgetUs && TickLODBias < CharacterStateTickLOD::MaxLevel)
+	{
+		++TickLODBias;
+	}
+	else if (EvaluateMicros < GCharacterStateTickLODBudgetUs * 0.5f && TickLODBias > 0)
+	{
+		--TickLODBias;
+	}
+}
+
+void UCharacterStateManagerSubsystem::DrawTraceOverlay() const
+{
+#if CHARACTER_STATE_WITH_TRACE
+	if (!GEngine)
+	{
+		return;
+	}
+
+	FCharacterStateTrace::bEnabled = true;
+
+	FCharacterStateTraceRecord Recent[FCharacterStateTrace::Capacity];
+	const int32 Count = FCharacterStateTrace::GetRecent(Recent, FMath::Min(GCharacterStateShowTrace, FCharacterStateTrace::Capacity));
+	const double Now = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FCharacterStateTraceRecord& Record = Recent[Index];
+		const uint64 Key = 0xC5A7E000ull + Index;
+		GEngine->AddOnScreenDebugMessage(Key, 0.f, FColor::White, FString::Printf(TEXT("[%u] %s -> %s (%.2fs ago)"),
+			Record.OwnerId, GetCharacterStateName(Record.From), GetCharacterStateName(Record.To), Now - Record.TimeSeconds));
+	}
+#endif
+}
+
+void UCharacterStateManagerSubsystem::SetCollectStats(bool bInCollectStats)
+{
+#if CHARACTER_STATE_WITH_STATS
+	bCollectStats = bInCollectStats;
+	for (TObjectIterator<UCharacterStateManagerComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == GetWorld() && It->HasBegunPlay())
+		{
+			It->GetStateMachine().SetCollectStats(bInCollectStats);
+		}
+	}
+#endif
+}
+
+void UCharacterStateManagerSubsystem::ResetStats()
+{
+#if CHARACTER_STATE_WITH_STATS
+	for (TObjectIterator<UCharacterStateManagerComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == GetWorld())
+		{
+			It->GetStateMachine().ResetStats();
+		}
+	}
+#endif
+}
+
+int32 UCharacterStateManagerSubsystem::GatherStats(FCharacterStateStats& OutStats) const
+{
+	OutStats.Reset();
+	int32 NumMachines = 0;
+#if CHARACTER_STATE_WITH_STATS
+	for (TObjectIterator<UCharacterStateManagerComponent> It; It; ++It)
+	{
+		const FCharacterStateStats* Stats = It->GetWorld() == GetWorld() ? It->GetStateMachine().GetStats() : nullptr;
+		if (Stats)
+		{
+			OutStats.Accumulate(*Stats);
+			++NumMachines;
+		}
+	}
+#endif
+	return NumMachines;
+}
+
+bool UCharacterStateManagerSubsystem::ExportStatsCsv(const FString& FilePath) const
+{
+#if CHARACTER_STATE_WITH_STATS
+	FCharacterStateStats Stats;
+	if (GatherStats(Stats) == 0)
+	{
+		return false;
+	}
+
+	static const TCHAR* const HookNames[NumCharacterStateHooks] = { TEXT("Enter"), TEXT("Tick"), TEXT("Exit") };
+	const double SecondsPerCycle = FCharacterStateStats::SecondsPerCycle();
+
+	FString Csv = TEXT("Kind,State,Other,Count,Seconds\n");
+	for (int32 State = 0; State < NumCharacterStates; ++State)
+	{
+		const TCHAR* StateName = GetCharacterStateName(static_cast<ECharacterState>(State));
+		Csv += FString::Printf(TEXT("Time,%s,,,%.6f\n"), StateName, Stats.TimeInState[State]);
+		for (int32 Hook = 0; Hook < NumCharacterStateHooks; ++Hook)
+		{
+			Csv += FString::Printf(TEXT("Hook,%s,%s,%u,%.9f\n"), StateName, HookNames[Hook], Stats.HookCalls[State][Hook], Stats.HookCycles[State][Hook] * SecondsPerCycle);
+		}
+	}
+	for (int32 From = 0; From < NumCharacterStates; ++From)
+	{
+		for (int32 To = 0; To < NumCharacterStates; ++To)
+		{
+			const TCHAR* FromName = GetCharacterStateName(static_cast<ECharacterState>(From));
+			const TCHAR* ToName = GetCharacterStateName(static_cast<ECharacterState>(To));
+			if (Stats.Transitions[From][To] > 0)
+			{
+				Csv += FString::Printf(TEXT("Transition,%s,%s,%u,\n"), FromName, ToName, Stats.Transitions[From][To]);
+			}
+			if (Stats.Rejected[From][To] > 0)
+			{
+				Csv += FString::Printf(TEXT("Rejected,%s,%s,%u,\n"), FromName, ToName, Stats.Rejected[From][To]);
+			}
+		}
+	}
+	return FFileHelper::SaveStringToFile(Csv, *FilePath);
+#else
+	return false;
+#endif
+}
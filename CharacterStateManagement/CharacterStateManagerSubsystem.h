@@ -0,0 +1,219 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CharacterStateManagement/CharacterStateEnum.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+#include "CharacterStateManagement/CharacterStateTickLOD.h"
+#include "Stats/Stats.h"
+#include <atomic>
+#include "CharacterStateManagerSubsystem.generated.h"
+
+class UCharacterStateManagerComponent;
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Skipped Ticks"), STAT_CharacterStateSkippedTicks, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Capsule Overlap Updates"), STAT_CharacterStateCapsuleOverlapUpdates, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Suppressed Transitions"), STAT_CharacterStateSuppressedTransitions, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Anim Trigger Calls"), STAT_CharacterStateAnimTriggerCalls, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Posted Requests"), STAT_CharacterStatePostedRequests, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Anim Triggers Cancelled"), STAT_CharacterStateAnimTriggersCancelled, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Route Hops"), STAT_CharacterStateRouteHops, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Avoided Retries"), STAT_CharacterStateAvoidedRetries, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Latent Resumes"), STAT_CharacterStateLatentResumes, STATGROUP_Game, CD_TEMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CharacterState Timeouts"), STAT_CharacterStateTimeouts, STATGROUP_Game, CD_TEMP_API);
+
+/**
+ * World-level manager that ticks every registered UCharacterStateManagerComponent in one pass.
+ * Per-character inputs live in contiguous arrays; the built-in tick logic (FCharacterStateMachine::EvaluateTransition:
+ * grounded -> MidAir, MidAir landing, Sprinting speed drop-out) is evaluated as one loop, then the resulting switches are
+ * applied through the component so Enter/Exit side effects match the per-component path exactly.
+ *
+ * With CharacterState.TickLOD, characters far from every viewer are evaluated at 1/2, 1/4 or 1/8 rate (CharacterStateTickLOD),
+ * and every reduced-rate character is pushed one level down while the evaluation pass exceeds CharacterState.TickLOD.BudgetUs.
+ */
+UCLASS()
+class CD_TEMP_API UCharacterStateManagerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Adds a component to the batch; its own tick function should be disabled by the caller. */
+	void RegisterComponent(UCharacterStateManagerComponent* Component);
+
+	/** Removes a component from the batch (swap-remove, O(1)). */
+	void UnregisterComponent(UCharacterStateManagerComponent* Component);
+
+	int32 GetNumRegistered() const { return Components.Num(); }
+
+	/**
+	 * Gathers inputs for every registered character on the calling thread, then decides their transitions split into
+	 * NumChunks ranges that run in parallel (1 = serial on the calling thread); workers only read the gathered arrays. Advances each state machine's time in state by DeltaTime and counts
+	 * suppressed threshold switches; otherwise has no side effects on the components. Results are applied by ApplyPendingSwitches().
+	 */
+	void EvaluateTransitions(int32 NumChunks, float DeltaTime);
+
+	/** Applies the switches from the last EvaluateTransitions() on the game thread, in ascending character order. */
+	void ApplyPendingSwitches();
+
+	/**
+	 * Any thread: adds a component with requests posted from another thread to a lock-free list (intrusive, so it never
+	 * allocates). Called by UCharacterStateManagerComponent::PostStateRequest() once per drain.
+	 */
+	void LinkPostedRequests(UCharacterStateManagerComponent* Component);
+
+	/** Game thread: takes the whole list and drains every linked component's requests. Called first in Tick(). */
+	void DrainPostedRequests();
+
+	/** Schedules Component->FlushCapsuleHalfHeight() for this frame's capsule pass (and following frames while it interpolates). */
+	void QueueCapsuleUpdate(UCharacterStateManagerComponent* Component);
+
+	/** Drops a pending capsule update, e.g. when the component ends play. */
+	void CancelCapsuleUpdate(UCharacterStateManagerComponent* Component);
+
+	/** Runs the deferred capsule height changes and overlap refreshes of all characters. Called from Tick(). */
+	void FlushCapsuleUpdates(float DeltaTime);
+
+	/** Schedules Component->FlushAnimTriggers() for this frame's trigger pass. */
+	void QueueAnimTriggerFlush(UCharacterStateManagerComponent* Component);
+
+	/** Drops a pending trigger flush, e.g. when the component ends play. */
+	void CancelAnimTriggerFlush(UCharacterStateManagerComponent* Component);
+
+	/**
+	 * Applies the buffered animation triggers of every character that did not flush them in its own tick (batched, sleeping,
+	 * or changed by gameplay after its tick). Called from Tick(); they reach the next frame's anim update.
+	 */
+	void FlushAnimTriggers();
+
+	/**
+	 * Resumes latent states of every character in this world whose Delay ran out or whose speed dropped below their
+	 * SpeedBelow threshold, and expires their state timeouts in one batch; their components need not tick while they
+	 * wait. Updated first in Tick().
+	 */
+	FCharacterStateLatentScheduler& GetLatentScheduler() { return LatentScheduler; }
+
+	/** True if CharacterState.TickLOD is on. */
+	static bool IsTickLODEnabled();
+
+	/** Distances from the CharacterState.TickLOD.* console variables. */
+	static CharacterStateTickLOD::FSettings GetTickLODSettings();
+
+	/** Squared distance from Location to the nearest player viewpoint of the last Tick(), or 0 if there is none (e.g. dedicated server). */
+	float GetDistanceSquaredToNearestView(const FVector& Location) const;
+
+	/** Characters whose evaluation was skipped by tick LOD in the last Tick(). */
+	int32 GetNumSkippedLastFrame() const { return NumSkippedLastFrame; }
+
+	/** Extra LOD levels currently applied because the evaluation pass ran over budget. */
+	uint8 GetTickLODBias() const { return TickLODBias; }
+
+	/**
+	 * Starts or pauses FCharacterStateStats collection on every state machine in this world; components that begin play
+	 * while it is on collect too. No-op when CHARACTER_STATE_WITH_STATS is off.
+	 */
+	void SetCollectStats(bool bInCollectStats);
+	bool IsCollectingStats() const { return bCollectStats; }
+
+	/** Clears the stats of every state machine in this world. */
+	void ResetStats();
+
+	/** Sum of the stats of every state machine in this world. Returns the number of machines that had stats. */
+	int32 GatherStats(FCharacterStateStats& OutStats) const;
+
+	/**
+	 * Writes GatherStats() as CSV with one row per value: Kind (Time, Hook, Transition, Rejected), State, Other (hook or
+	 * target state), Count, Seconds.
+	 */
+	bool ExportStatsCsv(const FString& FilePath) const;
+
+private:
+	/** A transition decided on a worker, applied later on the game thread. */
+	struct FPendingSwitch
+	{
+		UCharacterStateManagerComponent* Component;
+		ECharacterState Target;
+	};
+
+	/** Game thread: advances each evaluated machine's clock and copies its inputs into the arrays below. */
+	void GatherInputs(float DeltaTime);
+
+	/**
+	 * Any thread: decides transitions for [Begin, End) from the gathered arrays only. Characters whose switch was held back
+	 * by hysteresis or a dwell time go to OutSuppressed, to be counted on the game thread.
+	 */
+	void DecideRange(int32 Begin, int32 End, TArray<FPendingSwitch>& OutSwitches, TArray<int32>& OutSuppressed);
+	void UpdateViewLocations();
+	void UpdateTickLODBias(double EvaluateSeconds);
+	void DrawTraceOverlay() const;
+	void RemoveAtSwap(int32 Index);
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCharacterStateManagerComponent>> Components;
+
+	// Per-frame inputs, gathered at the start of the decision pass.
+	TArray<ECharacterState> States;
+	TArray<bool> Grounded;
+	TArray<float> HorizontalSpeedsSquared;
+	TArray<float> StateTimes;
+	TArray<float> ViewDistancesSquared;
+
+	/** DeltaTime of frames skipped by tick LOD, added to the state machine's time in state when it is next evaluated. */
+	TArray<float> SkippedDeltaTimes;
+
+	/** Per-character rules: the state machine's interned rule set, kept alive by the machine while the component is registered. */
+	TArray<const FCharacterStateRuleSet*> RuleSets;
+
+	/** CharacterStateTickLOD level per character, refreshed whenever the character is evaluated. */
+	TArray<uint8> TickLevels;
+
+	/**
+	 * Stagger phase per character (its component's unique ID, as on the per-component path), so a swap-remove does not move
+	 * the frames a character runs on.
+	 */
+	TArray<uint32> TickPhases;
+
+	/** Components with a pending capsule change; each appears at most once (see FCharacterStateCapsuleUpdate::bPending). */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCharacterStateManagerComponent>> PendingCapsuleUpdates;
+
+	/** PendingCapsuleUpdates as it was when FlushCapsuleUpdates() started; empty outside it, kept for its allocation. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCharacterStateManagerComponent>> FlushingCapsuleUpdates;
+
+	/** Head of the list of components with posted requests, linked through their NextPostedRequests. */
+	std::atomic<UCharacterStateManagerComponent*> PostedRequestsHead{ nullptr };
+
+	FCharacterStateLatentScheduler LatentScheduler;
+
+	/** Components with buffered animation triggers; each appears at most once (see bAnimTriggerFlushPending). */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCharacterStateManagerComponent>> PendingAnimTriggerFlushes;
+
+	/** PendingAnimTriggerFlushes as it was when FlushAnimTriggers() started; empty outside it, kept for its allocation. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCharacterStateManagerComponent>> FlushingAnimTriggerFlushes;
+
+	/** Components with a route, queued requests or a region update, collected by ApplyPendingSwitches() before it applies them. */
+	TArray<UCharacterStateManagerComponent*> MachineUpdates;
+
+	// Decision output, one list per chunk so workers never share a container. Suppressed transitions are component indices.
+	TArray<TArray<FPendingSwitch>> ChunkSwitches;
+	TArray<TArray<int32>> ChunkSuppressed;
+
+	/** Player viewpoints, gathered once per Tick() on the game thread. */
+	TArray<FVector> ViewLocations;
+
+	/** Frame number used for staggering; advanced once per Tick(). */
+	uint64 TickLODFrame = 0;
+	uint8 TickLODBias = 0;
+	bool bTickLODActive = false;
+	CharacterStateTickLOD::FSettings TickLODSettings;
+	int32 NumSkippedLastFrame = 0;
+
+	bool bCollectStats = false;
+};
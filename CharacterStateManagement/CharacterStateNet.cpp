@@ -0,0 +1,88 @@
+
+#include "CharacterStateManagement/CharacterStateNet.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+
+// ---- Authority ----
+void FCharacterStateNetSync::NotifyAuthorityTransition(ECharacterState NewState)
+{
+	Authoritative.State = NewState;
+	Authoritative.Sequence = static_cast<uint8>((Authoritative.Sequence + 1) & FCharacterStateNetState::SequenceMask);
+}
+
+bool FCharacterStateNetSync::ServerHandlePrediction(ECharacterState NewState, uint8 PredictionId)
+{
+	// Acknowledged whether or not it is accepted; a rejected prediction is corrected by the state that comes with the ack.
+	AckedPredictionId = PredictionId;
+	if (Machine.GetCurrentStateEnum() == NewState)
+	{
+		return true;
+	}
+	return Machine.SwitchStateByEnum(NewState);
+}
+
+// ---- Clients ----
+int32 FCharacterStateNetSync::PredictSwitch(ECharacterState NewState)
+{
+	if (!Machine.SwitchStateByEnum(NewState))
+	{
+		return INDEX_NONE;
+	}
+	LastPredictionId = static_cast<uint8>(LastPredictionId + 1);
+	bPredictionPending = true;
+	MismatchSeconds = 0.f;
+	return LastPredictionId;
+}
+
+void FCharacterStateNetSync::ReceiveAuthoritativeState(const FCharacterStateNetState& State, uint8 AckedId, bool bSimulated)
+{
+	// Out-of-order updates (possible on unordered transports) never move the state backwards.
+	if (!bHasReceived || State.Sequence == Received.Sequence || FCharacterStateNetState::IsNewer(State.Sequence, Received.Sequence))
+	{
+		Received = State;
+	}
+	bHasReceived = true;
+	ReceivedAckId = AckedId;
+
+	if (bSimulated)
+	{
+		Reconcile(true);
+		return;
+	}
+	if (HasUnacknowledgedPrediction())
+	{
+		return;
+	}
+
+	// The first update after our request was acknowledged already reflects it: adopt it without waiting.
+	const bool bAnswered = bPredictionPending;
+	bPredictionPending = false;
+	Reconcile(bAnswered);
+}
+
+void FCharacterStateNetSync::Update(float DeltaTime)
+{
+	if (!bHasReceived || HasUnacknowledgedPrediction() || Received.State == Machine.GetCurrentStateEnum())
+	{
+		MismatchSeconds = 0.f;
+		return;
+	}
+	MismatchSeconds += DeltaTime;
+	Reconcile(false);
+}
+
+void FCharacterStateNetSync::Reconcile(bool bImmediate)
+{
+	if (!bHasReceived || Received.State == Machine.GetCurrentStateEnum())
+	{
+		MismatchSeconds = 0.f;
+		return;
+	}
+	if (!bImmediate && MismatchSeconds < CorrectionDelay)
+	{
+		return;
+	}
+
+	Machine.SetStateFromAuthority(Received.State);
+	MismatchSeconds = 0.f;
+	++NumCorrections;
+}
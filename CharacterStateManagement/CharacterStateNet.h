@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+
+class FCharacterStateMachine;
+
+/** Replicated form of a character's state: 3-bit state and 5-bit transition sequence, one byte on the wire. */
+struct FCharacterStateNetState
+{
+	static constexpr uint32 StateBits = 3;
+	static constexpr uint32 SequenceBits = 5;
+	static constexpr uint8 SequenceMask = (1u << SequenceBits) - 1;
+
+	ECharacterState State = ECharacterState::Idle;
+
+	/** Incremented by the authority on every transition, modulo 2^SequenceBits. */
+	uint8 Sequence = 0;
+
+	uint8 Pack() const
+	{
+		return static_cast<uint8>((Sequence << StateBits) | static_cast<uint8>(State));
+	}
+
+	static FCharacterStateNetState Unpack(uint8 Packed)
+	{
+		FCharacterStateNetState Result;
+		Result.State = static_cast<ECharacterState>(Packed & ((1u << StateBits) - 1));
+		Result.Sequence = static_cast<uint8>(Packed >> StateBits);
+		return Result;
+	}
+
+	/**
+	 * True if sequence A follows B, allowing for wrap-around (A is at most half the sequence range ahead, i.e. 15).
+	 * An update 16 or more transitions ahead of the last one a client accepted is indistinguishable from a stale one and is
+	 * ignored; the client stays behind until an update comes back into the window, which may be never if the authority stops
+	 * changing state. Keep replication frequent enough that a character cannot make 16 transitions between two updates.
+	 */
+	static bool IsNewer(uint8 A, uint8 B)
+	{
+		const uint8 Distance = static_cast<uint8>((A - B) & SequenceMask);
+		return Distance != 0 && Distance <= (SequenceMask >> 1);
+	}
+
+	bool operator==(const FCharacterStateNetState& Other) const { return State == Other.State && Sequence == Other.Sequence; }
+	bool operator!=(const FCharacterStateNetState& Other) const { return !(*this == Other); }
+};
+
+static_assert(NumCharacterStates <= (1 << FCharacterStateNetState::StateBits), "ECharacterState no longer fits the replicated state bits.");
+
+/**
+ * Network bookkeeping for one FCharacterStateMachine, independent of the transport.
+ *
+ * Authority: NotifyAuthorityTransition() advances the replicated state; ServerHandlePrediction() applies a client's
+ * predicted switch and acknowledges it.
+ *
+ * Owning client: PredictSwitch() switches locally right away and returns an id to send with the request. Authoritative
+ * updates are held back while the prediction is unacknowledged. After that, a differing authoritative state is adopted once
+ * it has disagreed for CorrectionDelay seconds, or at once when it answers our own request, so local transitions that the
+ * server is about to make as well are never rolled back. Adopting the authority's state runs one Exit/Enter pair; a
+ * confirmed prediction runs none.
+ *
+ * Other clients: ReceiveAuthoritativeState() with bSimulated applies every update immediately.
+ */
+class CD_TEMP_API FCharacterStateNetSync
+{
+public:
+	explicit FCharacterStateNetSync(FCharacterStateMachine& InMachine) : Machine(InMachine) {}
+
+	// ---- Authority ----
+
+	/** Call after every transition on the authority. */
+	void NotifyAuthorityTransition(ECharacterState NewState);
+
+	const FCharacterStateNetState& GetAuthoritativeState() const { return Authoritative; }
+
+	/** Applies a client's predicted switch through the state machine's rules and acknowledges PredictionId. */
+	bool ServerHandlePrediction(ECharacterState NewState, uint8 PredictionId);
+
+	/** Last prediction id handled by ServerHandlePrediction(); replicated to the owning client. */
+	uint8 GetAckedPredictionId() const { return AckedPredictionId; }
+
+	// ---- Clients ----
+
+	/** Owning client: switches locally. Returns the prediction id to send to the server, or INDEX_NONE if the switch was rejected locally. */
+	int32 PredictSwitch(ECharacterState NewState);
+
+	/** Clients: an authoritative state arrived (AckedId is only meaningful for the owning client). Stale states are ignored (see IsNewer()). */
+	void ReceiveAuthoritativeState(const FCharacterStateNetState& State, uint8 AckedId, bool bSimulated);
+
+	/** Owning client: applies the pending correction once it has been outstanding for CorrectionDelay seconds. */
+	void Update(float DeltaTime);
+
+	/** Seconds a local state may disagree with the authority before it is corrected; about one round trip. */
+	float CorrectionDelay = 0.25f;
+
+	/** Number of times the local state was replaced by the authority's. */
+	uint32 GetNumCorrections() const { return NumCorrections; }
+
+private:
+	bool HasUnacknowledgedPrediction() const { return bPredictionPending && LastPredictionId != ReceivedAckId; }
+	void Reconcile(bool bImmediate);
+
+	FCharacterStateMachine& Machine;
+
+	FCharacterStateNetState Authoritative;
+	uint8 AckedPredictionId = 0;
+
+	FCharacterStateNetState Received;
+	bool bHasReceived = false;
+	uint8 ReceivedAckId = 0;
+	uint8 LastPredictionId = 0;
+	bool bPredictionPending = false;
+	float MismatchSeconds = 0.f;
+	uint32 NumCorrections = 0;
+};
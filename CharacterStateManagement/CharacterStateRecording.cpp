@@ -0,0 +1,266 @@
+
+#include "CharacterStateManagement/CharacterStateRecording.h"
+#include <cstring>
+
+// ---- FCharacterStateRecordingHeader ----
+FCharacterStateTransitionTable FCharacterStateRecordingHeader::GetTransitionTable() const
+{
+	FCharacterStateTransitionTable Table;
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		Table.IllegalTo[Index] = IllegalTo[Index];
+	}
+	Table.NormalStates = NormalStates;
+	Table.AirStates = AirStates;
+	Table.GroundStates = GroundStates;
+	return Table;
+}
+
+FCharacterStateMachineSettings FCharacterStateRecordingHeader::GetSettings() const
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.NormalStateWalkThreshold = NormalStateWalkThreshold;
+	Settings.SprintingMinSpeed = SprintingMinSpeed;
+	Settings.CrouchCapsuleHalfHeight = CrouchCapsuleHalfHeight;
+	Settings.DefaultCapsuleHalfHeight = DefaultCapsuleHalfHeight;
+	Settings.NormalStateWalkHysteresis = NormalStateWalkHysteresis;
+	Settings.SprintingHysteresis = SprintingHysteresis;
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		Settings.MinDwellTime[Index] = MinDwellTime[Index];
+		Settings.MaxTimeInState[Index] = MaxTimeInState[Index];
+		Settings.Cooldown[Index] = Cooldown[Index];
+	}
+	return Settings;
+}
+
+// ---- FCharacterStateRecorder ----
+FCharacterStateRecorder::FCharacterStateRecorder(int32 InCapacity)
+	: Capacity(InCapacity > 0 ? InCapacity : 0)
+{
+	Entries = Capacity > 0 ? new FCharacterStateRecordEntry[Capacity] : nullptr;
+}
+
+FCharacterStateRecorder::~FCharacterStateRecorder()
+{
+	delete[] Entries;
+}
+
+void FCharacterStateRecorder::Begin(const FCharacterStateMachine& Machine)
+{
+	Header = FCharacterStateRecordingHeader();
+
+	const FCharacterStateTransitionTable& Table = Machine.GetTransitionTable();
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		Header.IllegalTo[Index] = Table.IllegalTo[Index];
+	}
+	Header.NormalStates = Table.NormalStates;
+	Header.AirStates = Table.AirStates;
+	Header.GroundStates = Table.GroundStates;
+	Header.InitialState = Machine.GetCurrentStateEnum();
+	Header.Flags = Machine.IsQueueingTransitions() ? FCharacterStateRecordingHeader::QueueTransitionsFlag : 0;
+	if (Machine.GetLatentScheduler())
+	{
+		Header.Flags |= FCharacterStateRecordingHeader::ScheduledTimeoutsFlag;
+	}
+
+	const FCharacterStateMachineSettings& Settings = Machine.GetSettings();
+	Header.NormalStateWalkThreshold = Settings.NormalStateWalkThreshold;
+	Header.SprintingMinSpeed = Settings.SprintingMinSpeed;
+	Header.CrouchCapsuleHalfHeight = Settings.CrouchCapsuleHalfHeight;
+	Header.DefaultCapsuleHalfHeight = Settings.DefaultCapsuleHalfHeight;
+	Header.NormalStateWalkHysteresis = Settings.NormalStateWalkHysteresis;
+	Header.SprintingHysteresis = Settings.SprintingHysteresis;
+	for (int32 Index = 0; Index < NumCharacterStates; ++Index)
+	{
+		Header.MinDwellTime[Index] = Settings.MinDwellTime[Index];
+		Header.MaxTimeInState[Index] = Settings.MaxTimeInState[Index];
+		Header.Cooldown[Index] = Settings.Cooldown[Index];
+	}
+	Header.InitialTimeInState = Machine.GetTimeInState();
+
+	Num = 0;
+	bOverflowed = false;
+}
+
+FCharacterStateRecordEntry* FCharacterStateRecorder::Append()
+{
+	if (Num >= Capacity)
+	{
+		bOverflowed = true;
+		return nullptr;
+	}
+	FCharacterStateRecordEntry& Entry = Entries[Num++];
+	Entry = FCharacterStateRecordEntry();
+	return &Entry;
+}
+
+int64 FCharacterStateRecorder::GetSerializedSize() const
+{
+	return static_cast<int64>(sizeof(FCharacterStateRecordingHeader)) + static_cast<int64>(Num) * static_cast<int64>(sizeof(FCharacterStateRecordEntry));
+}
+
+void FCharacterStateRecorder::Serialize(uint8* Dest) const
+{
+	FCharacterStateRecordingHeader Written = Header;
+	Written.NumEntries = static_cast<uint32>(Num);
+	std::memcpy(Dest, &Written, sizeof(Written));
+	if (Num > 0)
+	{
+		std::memcpy(Dest + sizeof(Written), Entries, static_cast<size_t>(Num) * sizeof(FCharacterStateRecordEntry));
+	}
+}
+
+// ---- FCharacterStateRecordingView ----
+bool FCharacterStateRecordingView::FromBytes(const uint8* Data, int64 Size, FCharacterStateRecordingView& OutView)
+{
+	OutView = FCharacterStateRecordingView();
+	if (!Data || Size < static_cast<int64>(sizeof(FCharacterStateRecordingHeader))
+		|| reinterpret_cast<uintptr_t>(Data) % alignof(FCharacterStateRecordingHeader) != 0)
+	{
+		return false;
+	}
+
+	const FCharacterStateRecordingHeader* Header = reinterpret_cast<const FCharacterStateRecordingHeader*>(Data);
+	if (Header->Magic != FCharacterStateRecordingHeader::ExpectedMagic || Header->Version != FCharacterStateRecordingHeader::CurrentVersion)
+	{
+		return false;
+	}
+	const int64 EntryBytes = Size - static_cast<int64>(sizeof(FCharacterStateRecordingHeader));
+	if (static_cast<int64>(Header->NumEntries) > EntryBytes / static_cast<int64>(sizeof(FCharacterStateRecordEntry)))
+	{
+		return false;
+	}
+
+	OutView.Header = Header;
+	OutView.Entries = reinterpret_cast<const FCharacterStateRecordEntry*>(Data + sizeof(FCharacterStateRecordingHeader));
+	OutView.Num = static_cast<int32>(Header->NumEntries);
+	return true;
+}
+
+// ---- FCharacterStateReplayer ----
+FCharacterStateReplayReport FCharacterStateReplayer::Replay(const FCharacterStateRecordingView& Recording)
+{
+	if (!Recording.Header)
+	{
+		return FCharacterStateReplayReport();
+	}
+	return Replay(Recording, Recording.Header->GetTransitionTable(), Recording.Header->GetSettings());
+}
+
+FCharacterStateReplayReport FCharacterStateReplayer::Replay(const FCharacterStateRecordingView& Recording, const FCharacterStateTransitionTable& Table,
+	const FCharacterStateMachineSettings& Settings)
+{
+	FCharacterStateReplayReport Result;
+	if (!Recording.Header)
+	{
+		return Result;
+	}
+
+	bGrounded = Recording.Num > 0 ? Recording.Entries[0].IsGrounded() : true;
+	Velocity = Recording.Num > 0 ? Recording.Entries[0].GetVelocity() : FCharacterStateVector();
+	bHasLastTransition = false;
+
+	// Scheduled timeouts come back as ExpireStateTimeout entries. A scheduler that is never updated keeps this machine from
+	// also running them out on its own clock, which need not agree with the recording's to the frame.
+	FCharacterStateLatentScheduler HeldTimeouts;
+	FCharacterStateMachine Machine(*this);
+	if ((Recording.Header->Flags & FCharacterStateRecordingHeader::ScheduledTimeoutsFlag) != 0)
+	{
+		Machine.SetLatentScheduler(&HeldTimeouts);
+	}
+	Machine.SetQueueTransitions((Recording.Header->Flags & FCharacterStateRecordingHeader::QueueTransitionsFlag) != 0);
+	Machine.Start(Table, Settings);
+	Machine.SetStateFromAuthority(Recording.Header->InitialState);
+	Machine.AdvanceStateTime(Recording.Header->InitialTimeInState);
+
+	Report = &Result;
+	double Time = 0.0;
+	for (int32 Index = 0; Index < Recording.Num; ++Index)
+	{
+		const FCharacterStateRecordEntry& Entry = Recording.Entries[Index];
+		bGrounded = Entry.IsGrounded();
+		Velocity = Entry.GetVelocity();
+
+		switch (Entry.Type)
+		{
+			case ECharacterStateRecordType::Frame:
+				Time += Entry.DeltaTime;
+				Result.TimeInState[static_cast<uint8>(Machine.GetCurrentStateEnum())] += Entry.DeltaTime;
+				++Result.NumFrames;
+				Result.TotalTime = Time;
+				Machine.Tick(Entry.DeltaTime);
+				break;
+			case ECharacterStateRecordType::SwitchStateByEnum:
+				Machine.SwitchStateByEnum(Entry.Argument);
+				break;
+			case ECharacterStateRecordType::SwitchState:
+				Machine.SwitchState(Machine.FindState(Entry.Argument));
+				break;
+			case ECharacterStateRecordType::SwitchToNormalState:
+				Machine.SwitchToNormalState();
+				break;
+			case ECharacterStateRecordType::RequestState:
+				Machine.RequestState(Entry.Argument, (Entry.Flags & FCharacterStateRecordEntry::ForcedFlag)
+					? ECharacterStateRequestPriority::Forced : ECharacterStateRequestPriority::Normal);
+				break;
+			case ECharacterStateRecordType::ApplyQueuedTransitions:
+				Machine.ApplyQueuedTransitions();
+				break;
+			case ECharacterStateRecordType::SetStateFromAuthority:
+				Machine.SetStateFromAuthority(Entry.Argument);
+				break;
+			case ECharacterStateRecordType::AdvanceStateTime:
+				Time += Entry.DeltaTime;
+				Result.TimeInState[static_cast<uint8>(Machine.GetCurrentStateEnum())] += Entry.DeltaTime;
+				Result.TotalTime = Time;
+				Machine.AdvanceStateTime(Entry.DeltaTime);
+				break;
+			case ECharacterStateRecordType::RequestStateVia:
+				Machine.RequestStateVia(Entry.Argument, (Entry.Flags & FCharacterStateRecordEntry::ImmediateFlag) != 0);
+				break;
+			case ECharacterStateRecordType::AdvanceRoute:
+				Machine.AdvanceRoute();
+				break;
+			case ECharacterStateRecordType::ExpireStateTimeout:
+				Machine.ExpireStateTimeout();
+				break;
+		}
+
+		if (Machine.GetCurrentStateEnum() != Entry.Result)
+		{
+			if (Result.NumDivergences++ == 0)
+			{
+				Result.FirstDivergence = Index;
+			}
+		}
+	}
+	Report = nullptr;
+
+	Machine.Stop();
+	return Result;
+}
+
+void FCharacterStateReplayer::OnStateChanged(ECharacterState PreviousState, ECharacterState NewState)
+{
+	if (!Report)
+	{
+		return;
+	}
+
+	++Report->NumTransitions;
+	const double Time = Report->TotalTime;
+	if (bHasLastTransition && NewState == LastFrom && PreviousState == LastTo && Time - LastTransitionTime <= OscillationWindow)
+	{
+		++Report->Oscillations[static_cast<uint8>(NewState)][static_cast<uint8>(PreviousState)];
+		if (Report->NumOscillations++ == 0)
+		{
+			Report->FirstOscillationTime = Time;
+		}
+	}
+	LastFrom = PreviousState;
+	LastTo = NewState;
+	LastTransitionTime = Time;
+	bHasLastTransition = true;
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+
+/** What a recorded entry replays: one Tick() or one call made on the state machine from outside its tick. */
+enum class ECharacterStateRecordType : uint8
+{
+	Frame,
+	SwitchStateByEnum,
+	SwitchState,
+	SwitchToNormalState,
+	RequestState,
+	ApplyQueuedTransitions,
+	SetStateFromAuthority,
+	AdvanceStateTime,
+	RequestStateVia,
+	AdvanceRoute,
+	ExpireStateTimeout
+};
+
+/**
+ * One fixed-size record of a state machine timeline: the movement inputs the machine saw (grounded, velocity), the
+ * DeltaTime for frames or the target for requests, and the state the recording machine ended up in.
+ */
+struct FCharacterStateRecordEntry
+{
+	static constexpr uint8 GroundedFlag = 1 << 0;
+	static constexpr uint8 ForcedFlag = 1 << 1;
+	static constexpr uint8 ImmediateFlag = 1 << 2;
+
+	ECharacterStateRecordType Type = ECharacterStateRecordType::Frame;
+	uint8 Flags = 0;
+
+	/** Target state of a request; unused for frames. */
+	ECharacterState Argument = ECharacterState::Idle;
+
+	/** State after the entry was applied while recording; replays compare against it. */
+	ECharacterState Result = ECharacterState::Idle;
+
+	float DeltaTime = 0.f;
+	float Velocity[3] = {};
+
+	void SetInputs(bool bGrounded, const FCharacterStateVector& InVelocity)
+	{
+		Flags = bGrounded ? static_cast<uint8>(Flags | GroundedFlag) : static_cast<uint8>(Flags & ~GroundedFlag);
+		Velocity[0] = static_cast<float>(InVelocity.X);
+		Velocity[1] = static_cast<float>(InVelocity.Y);
+		Velocity[2] = static_cast<float>(InVelocity.Z);
+	}
+
+	bool IsGrounded() const { return (Flags & GroundedFlag) != 0; }
+
+	FCharacterStateVector GetVelocity() const
+	{
+		FCharacterStateVector Out;
+		Out.X = Velocity[0];
+		Out.Y = Velocity[1];
+		Out.Z = Velocity[2];
+		return Out;
+	}
+};
+
+/** Start of a recording: the rules and settings of the recording machine, followed by NumEntries entries. */
+struct FCharacterStateRecordingHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x52535343; // "CSSR"
+	static constexpr uint32 CurrentVersion = 3;
+
+	static constexpr uint32 QueueTransitionsFlag = 1 << 0;
+
+	/** Timeouts were expired by a latent scheduler and are replayed from their ExpireStateTimeout entries. */
+	static constexpr uint32 ScheduledTimeoutsFlag = 1 << 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+	uint32 NumEntries = 0;
+	uint32 Flags = 0;
+
+	FCharacterStateMask IllegalTo[NumCharacterStates] = {};
+	FCharacterStateMask NormalStates = 0;
+	FCharacterStateMask AirStates = 0;
+	FCharacterStateMask GroundStates = 0;
+	ECharacterState InitialState = ECharacterState::Idle;
+
+	float NormalStateWalkThreshold = 0.f;
+	float SprintingMinSpeed = 0.f;
+	float CrouchCapsuleHalfHeight = 0.f;
+	float DefaultCapsuleHalfHeight = 0.f;
+	float NormalStateWalkHysteresis = 0.f;
+	float SprintingHysteresis = 0.f;
+	float MinDwellTime[NumCharacterStates] = {};
+	float MaxTimeInState[NumCharacterStates] = {};
+	float Cooldown[NumCharacterStates] = {};
+
+	/** Time the recording machine had already spent in InitialState. */
+	float InitialTimeInState = 0.f;
+
+	FCharacterStateTransitionTable GetTransitionTable() const;
+	FCharacterStateMachineSettings GetSettings() const;
+};
+
+// The file is the header followed by the entries, with no padding, compression or per-record framing.
+static_assert(sizeof(FCharacterStateRecordEntry) == 20, "FCharacterStateRecordEntry is part of the recording format.");
+static_assert(sizeof(FCharacterStateRecordingHeader) == 152, "FCharacterStateRecordingHeader is part of the recording format.");
+static_assert(sizeof(FCharacterStateRecordingHeader) % alignof(FCharacterStateRecordEntry) == 0, "Entries must stay aligned after the header.");
+
+/**
+ * Records one state machine's timeline into a buffer allocated once up front: every Tick() (grounded, velocity, DeltaTime)
+ * and every switch request made from outside the tick. Attach with FCharacterStateMachine::SetRecorder(). Entries past
+ * the capacity are dropped, so a long session costs a fixed 20 bytes per frame and nothing else.
+ */
+class CD_TEMP_API FCharacterStateRecorder
+{
+public:
+	explicit FCharacterStateRecorder(int32 InCapacity);
+	~FCharacterStateRecorder();
+
+	FCharacterStateRecorder(const FCharacterStateRecorder&) = delete;
+	FCharacterStateRecorder& operator=(const FCharacterStateRecorder&) = delete;
+
+	/** Clears the recording and stores Machine's rules, settings, mode and current state as its starting point. */
+	void Begin(const FCharacterStateMachine& Machine);
+
+	/** Next entry to fill in, or nullptr once the recording is full. */
+	FCharacterStateRecordEntry* Append();
+
+	int32 GetNum() const { return Num; }
+	int32 GetCapacity() const { return Capacity; }
+	bool HasOverflowed() const { return bOverflowed; }
+
+	/** Bytes written by Serialize(): the header followed by GetNum() entries. */
+	int64 GetSerializedSize() const;
+
+	/** Writes the recording to Dest, which must hold GetSerializedSize() bytes. */
+	void Serialize(uint8* Dest) const;
+
+private:
+	FCharacterStateRecordingHeader Header;
+	FCharacterStateRecordEntry* Entries = nullptr;
+	int32 Capacity = 0;
+	int32 Num = 0;
+	bool bOverflowed = false;
+};
+
+/**
+ * Read-only view of a serialized recording. Points into the caller's bytes (a loaded or memory-mapped file, 4-byte
+ * aligned) without copying or parsing entries.
+ */
+struct CD_TEMP_API FCharacterStateRecordingView
+{
+	const FCharacterStateRecordingHeader* Header = nullptr;
+	const FCharacterStateRecordEntry* Entries = nullptr;
+	int32 Num = 0;
+
+	/** Returns false if Data is not a recording of the current version or is truncated. */
+	static bool FromBytes(const uint8* Data, int64 Size, FCharacterStateRecordingView& OutView);
+};
+
+/** Results of one replay. */
+struct FCharacterStateReplayReport
+{
+	/** Seconds spent in each state, by the DeltaTime of the frames that started in it. */
+	double TimeInState[NumCharacterStates] = {};
+	double TotalTime = 0.0;
+	uint32 NumFrames = 0;
+	uint32 NumTransitions = 0;
+
+	/** A -> B -> A within the oscillation window; counted by [A][B]. */
+	uint32 Oscillations[NumCharacterStates][NumCharacterStates] = {};
+	uint32 NumOscillations = 0;
+
+	/** Replay time of the first oscillation; negative if there was none. */
+	double FirstOscillationTime = -1.0;
+
+	/** Entries whose replayed state differs from the recorded one; nonzero when the rules, settings or state logic changed. */
+	uint32 NumDivergences = 0;
+	int32 FirstDivergence = INDEX_NONE;
+};
+
+/**
+ * Headless replay: feeds a recording's inputs back through a fresh FCharacterStateMachine with the built-in states and
+ * reports where time went, how often the machine flip-flopped between two states, and where it no longer matches the
+ * recording. Nothing but the state machine runs, so a replay is limited only by the cost of the transitions themselves.
+ */
+class CD_TEMP_API FCharacterStateReplayer final : public ICharacterStateEnvironment
+{
+public:
+	/** A transition back into the state that was left at most this many seconds earlier counts as an oscillation. */
+	float OscillationWindow = 0.25f;
+
+	/** Replays with the recorded rules and settings. */
+	FCharacterStateReplayReport Replay(const FCharacterStateRecordingView& Recording);
+
+	/** Replays the recorded inputs under different rules or thresholds; divergences show what the change would alter. */
+	FCharacterStateReplayReport Replay(const FCharacterStateRecordingView& Recording, const FCharacterStateTransitionTable& Table,
+		const FCharacterStateMachineSettings& Settings);
+
+	// ICharacterStateEnvironment
+	virtual bool IsGrounded() const override { return bGrounded; }
+	virtual FCharacterStateVector GetLinearVelocity() const override { return Velocity; }
+	virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+	virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps) override {}
+	virtual void OnStateChanged(ECharacterState PreviousState, ECharacterState NewState) override;
+	virtual const TCHAR* GetDebugName() const override { return TEXT("Replay"); }
+
+private:
+	bool bGrounded = false;
+	FCharacterStateVector Velocity;
+
+	/** Set while entries are being replayed; transitions made while setting up the machine are not reported. */
+	FCharacterStateReplayReport* Report = nullptr;
+
+	/** Last transition, for oscillation detection. */
+	ECharacterState LastFrom = ECharacterState::Idle;
+	ECharacterState LastTo = ECharacterState::Idle;
+	double LastTransitionTime = 0.0;
+	bool bHasLastTransition = false;
+};
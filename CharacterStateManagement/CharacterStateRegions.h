@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+
+/** Number of ECharacterActionState values. */
+constexpr int32 NumCharacterActionStates = 4;
+
+static_assert(static_cast<int32>(ECharacterActionState::Melee) == NumCharacterActionStates - 1, "Update NumCharacterActionStates when ECharacterActionState changes.");
+
+/** Extra regions an FCharacterStateMachine can run next to locomotion. */
+constexpr int32 MaxCharacterStateRegions = 2;
+
+/** Bit for a single action state, in the same layout as CharacterStateBit(). */
+constexpr FCharacterStateMask CharacterActionStateBit(ECharacterActionState State)
+{
+	return static_cast<FCharacterStateMask>(1u << static_cast<uint8>(State));
+}
+
+/**
+ * Rules of one orthogonal region: a small state machine of up to NumCharacterStates states (indexed 0..NumStates-1) that
+ * runs next to locomotion, e.g. ECharacterActionState for the upper body. Besides its own illegal transitions, each state
+ * has a cross-region guard against locomotion: BlockedWhile holds the ECharacterState bits in which the state can neither
+ * be entered nor held. Guards can name whole locomotion groups (e.g. FCharacterStateTransitionTable::AirStates) as parent
+ * states. A region in a blocked or expired state falls back to DefaultState.
+ */
+struct FCharacterStateRegionRules
+{
+	uint8 NumStates = 0;
+	uint8 DefaultState = 0;
+
+	/** Region states that cannot be entered from each region state. */
+	FCharacterStateMask IllegalTo[NumCharacterStates] = {};
+
+	/** Locomotion states (ECharacterState bits) that block each region state. */
+	FCharacterStateMask BlockedWhile[NumCharacterStates] = {};
+
+	/** Seconds after which a state returns to DefaultState by itself (e.g. a melee swing); 0 holds it until switched. */
+	float Duration[NumCharacterStates] = {};
+
+	constexpr bool IsIllegal(uint8 From, uint8 To) const { return (IllegalTo[From] & (1u << To)) != 0; }
+	constexpr bool IsBlocked(uint8 State, ECharacterState Locomotion) const { return (BlockedWhile[State] & CharacterStateBit(Locomotion)) != 0; }
+};
+
+/** Current state of one region; the rules are copied in when the region is added. */
+struct FCharacterStateRegion
+{
+	FCharacterStateRegionRules Rules;
+	uint8 CurrentState = 0;
+	float TimeInState = 0.f;
+
+	/** True while the current state runs out by itself; such regions keep an event-driven machine ticking. */
+	bool IsTimed() const { return Rules.Duration[CurrentState] > 0.f; }
+	bool HasExpired() const { return IsTimed() && TimeInState >= Rules.Duration[CurrentState]; }
+};
+
+namespace CharacterStateRules
+{
+	/** Built-in upper-body action region. */
+	constexpr FCharacterStateRegionRules MakeDefaultActionRules()
+	{
+		FCharacterStateRegionRules Rules;
+		Rules.NumStates = NumCharacterActionStates;
+		Rules.DefaultState = static_cast<uint8>(ECharacterActionState::None);
+
+		const uint8 Aiming = static_cast<uint8>(ECharacterActionState::Aiming);
+		const uint8 Reloading = static_cast<uint8>(ECharacterActionState::Reloading);
+		const uint8 Melee = static_cast<uint8>(ECharacterActionState::Melee);
+
+		// Aiming: not while sprinting, sliding, wall running or grappling
+		Rules.BlockedWhile[Aiming] = MakeCharacterStateMask(ECharacterState::Sprinting, ECharacterState::Sliding, ECharacterState::WallRun, ECharacterState::Grapple);
+
+		// Reloading: needs a free hand, so not while sliding, wall running or grappling
+		Rules.BlockedWhile[Reloading] = MakeCharacterStateMask(ECharacterState::Sliding, ECharacterState::WallRun, ECharacterState::Grapple);
+
+		// Melee: not while wall running or grappling; a swing cannot be cancelled into aiming or reloading
+		Rules.BlockedWhile[Melee] = MakeCharacterStateMask(ECharacterState::WallRun, ECharacterState::Grapple);
+		Rules.IllegalTo[Melee] = CharacterActionStateBit(ECharacterActionState::Aiming) | CharacterActionStateBit(ECharacterActionState::Reloading);
+		Rules.Duration[Melee] = 0.6f;
+
+		return Rules;
+	}
+
+	inline constexpr FCharacterStateRegionRules DefaultActions = MakeDefaultActionRules();
+
+	static_assert(DefaultActions.BlockedWhile[DefaultActions.DefaultState] == 0, "A region's default state must never be blocked.");
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include <atomic>
+
+/**
+ * Bounded, lock-free multi-producer/single-consumer channel of transition requests: any thread may Post(), one thread (the
+ * game thread) Drain()s. Fixed storage, so posting never allocates. Each request gets a sequence number in posting order,
+ * which the poster can compare against HasDrained() to learn when it has been handled.
+ *
+ * Cells carry their own sequence (Vyukov's bounded queue): a producer claims a position with one CAS, writes the target,
+ * then publishes the cell; the consumer reads published cells in order and hands them back one lap later.
+ */
+class FCharacterStateRequestChannel
+{
+public:
+	/** Requests that can be pending at once; a power of two. */
+	static constexpr uint32 Capacity = 16;
+
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+	FCharacterStateRequestChannel()
+	{
+		for (uint32 Index = 0; Index < Capacity; ++Index)
+		{
+			Cells[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+	}
+
+	FCharacterStateRequestChannel(const FCharacterStateRequestChannel&) = delete;
+	FCharacterStateRequestChannel& operator=(const FCharacterStateRequestChannel&) = delete;
+
+	/** Any thread. Returns the request's sequence number (never 0 in the first 2^32 posts), or 0 if the channel is full. */
+	uint32 Post(ECharacterState Target)
+	{
+		uint32 Position = EnqueuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FCell& Cell = Cells[Position & (Capacity - 1)];
+			const int32 Lap = static_cast<int32>(Cell.Sequence.load(std::memory_order_acquire) - Position);
+			if (Lap == 0)
+			{
+				// Free cell for this position; on failure Position is reloaded by the CAS.
+				if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				{
+					Cell.Target = Target;
+					Cell.Sequence.store(Position + 1, std::memory_order_release);
+					return Position + 1;
+				}
+			}
+			else if (Lap < 0)
+			{
+				// The consumer has not yet freed this cell from the previous lap.
+				return 0;
+			}
+			else
+			{
+				Position = EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * Consumer only. Calls Function(Target, Sequence) for every published request, oldest first, and returns their number.
+	 * Each cell is released before Function runs, so Function may post again; the request counts as drained once Function
+	 * has returned.
+	 */
+	template<typename FunctionType>
+	int32 Drain(FunctionType&& Function)
+	{
+		int32 Count = 0;
+		for (;;)
+		{
+			FCell& Cell = Cells[DequeuePosition & (Capacity - 1)];
+			if (Cell.Sequence.load(std::memory_order_acquire) != DequeuePosition + 1)
+			{
+				return Count;
+			}
+
+			const ECharacterState Target = Cell.Target;
+			Cell.Sequence.store(DequeuePosition + Capacity, std::memory_order_release);
+			++DequeuePosition;
+			Function(Target, DequeuePosition);
+
+			// Only after Function, so HasDrained() never reports a request whose switch has not run yet.
+			NumDrained.store(DequeuePosition, std::memory_order_release);
+			++Count;
+		}
+	}
+
+	/** Consumer only. True if there is nothing to drain. */
+	bool IsEmpty() const
+	{
+		return Cells[DequeuePosition & (Capacity - 1)].Sequence.load(std::memory_order_acquire) != DequeuePosition + 1;
+	}
+
+	/** Any thread. True once the request with this sequence number has been drained and its Function has returned. */
+	bool HasDrained(uint32 Sequence) const
+	{
+		return static_cast<int32>(NumDrained.load(std::memory_order_acquire) - Sequence) >= 0;
+	}
+
+private:
+	struct FCell
+	{
+		std::atomic<uint32> Sequence{ 0 };
+		ECharacterState Target = ECharacterState::Idle;
+	};
+
+	FCell Cells[Capacity];
+
+	// Producers and the consumer write different cache lines.
+	alignas(64) std::atomic<uint32> EnqueuePosition{ 0 };
+	alignas(64) uint32 DequeuePosition = 0;
+	std::atomic<uint32> NumDrained{ 0 };
+};
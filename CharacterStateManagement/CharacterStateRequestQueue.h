@@ -0,0 +1,117 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/** Priority of a queued transition request; when requests are coalesced the higher priority wins. */
+enum class ECharacterStateRequestPriority : uint8
+{
+	/** Gameplay, AI and state logic. */
+	Normal,
+	/** Forced switch into the air; overrides everything requested in the same frame. */
+	Forced
+};
+
+struct FCharacterStateRequest
+{
+	ECharacterState Target = ECharacterState::Idle;
+	ECharacterStateRequestPriority Priority = ECharacterStateRequestPriority::Normal;
+};
+
+/**
+ * Fixed-capacity per-character queue of transition requests for deferred application. Requests for the same target are
+ * merged; when full, the oldest request of the lowest priority is displaced. Never allocates.
+ */
+class FCharacterStateRequestQueue
+{
+public:
+	static constexpr int32 Capacity = 4;
+
+	/** Adds a request. Returns the number of requests dropped to make room for it (or 1 if it was dropped itself). */
+	int32 Push(ECharacterState Target, ECharacterStateRequestPriority Priority)
+	{
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			if (Requests[Index].Target == Target)
+			{
+				if (Requests[Index].Priority > Priority)
+				{
+					Priority = Requests[Index].Priority;
+				}
+				RemoveAt(Index);
+				Append(Target, Priority);
+				return 1;
+			}
+		}
+
+		if (Num < Capacity)
+		{
+			Append(Target, Priority);
+			return 0;
+		}
+
+		// Requests are kept oldest first, so the first match is the oldest of the lowest priority.
+		int32 Worst = 0;
+		for (int32 Index = 1; Index < Num; ++Index)
+		{
+			if (Requests[Index].Priority < Requests[Worst].Priority)
+			{
+				Worst = Index;
+			}
+		}
+		if (Priority < Requests[Worst].Priority)
+		{
+			return 1;
+		}
+		RemoveAt(Worst);
+		Append(Target, Priority);
+		return 1;
+	}
+
+	bool IsEmpty() const { return Num == 0; }
+	int32 GetNum() const { return Num; }
+
+	/** Moves all requests into Out, best candidate first (higher priority, then newer), and empties the queue. */
+	int32 Drain(FCharacterStateRequest (&Out)[Capacity])
+	{
+		int32 Count = 0;
+		for (int32 Index = Num - 1; Index >= 0; --Index)
+		{
+			if (Requests[Index].Priority == ECharacterStateRequestPriority::Forced)
+			{
+				Out[Count++] = Requests[Index];
+			}
+		}
+		for (int32 Index = Num - 1; Index >= 0; --Index)
+		{
+			if (Requests[Index].Priority != ECharacterStateRequestPriority::Forced)
+			{
+				Out[Count++] = Requests[Index];
+			}
+		}
+		Num = 0;
+		return Count;
+	}
+
+	void Reset() { Num = 0; }
+
+private:
+	void Append(ECharacterState Target, ECharacterStateRequestPriority Priority)
+	{
+		Requests[Num].Target = Target;
+		Requests[Num].Priority = Priority;
+		++Num;
+	}
+
+	void RemoveAt(int32 Index)
+	{
+		for (int32 Next = Index + 1; Next < Num; ++Next)
+		{
+			Requests[Next - 1] = Requests[Next];
+		}
+		--Num;
+	}
+
+	/** Oldest first. */
+	FCharacterStateRequest Requests[Capacity];
+	int32 Num = 0;
+};
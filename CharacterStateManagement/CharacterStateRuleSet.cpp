@@ -0,0 +1,134 @@
+
+#include "CharacterStateManagement/CharacterStateRuleSet.h"
+#include <cstring>
+#include <mutex>
+
+// Rule sets are compared and hashed as raw bytes, so neither struct may contain padding.
+static_assert(sizeof(FCharacterStateTransitionTable) == NumCharacterStates + 3, "FCharacterStateTransitionTable must not contain padding.");
+static_assert(sizeof(FCharacterStateMachineSettings) == sizeof(float) * (6 + 3 * NumCharacterStates), "FCharacterStateMachineSettings must not contain padding.");
+
+namespace
+{
+	/** Interned rule sets, as a list: a world holds a handful of archetypes, and lookups only happen when a machine starts. */
+	struct FCharacterStateRuleSetRegistry
+	{
+		std::mutex Mutex;
+		FCharacterStateRuleSet* Head = nullptr;
+		int32 Num = 0;
+	};
+
+	FCharacterStateRuleSetRegistry& GetRegistry()
+	{
+		static FCharacterStateRuleSetRegistry Registry;
+		return Registry;
+	}
+
+	/** FNV-1a over the table and settings bytes. */
+	uint32 HashRules(const FCharacterStateTransitionTable& Table, const FCharacterStateMachineSettings& Settings)
+	{
+		uint32 Hash = 2166136261u;
+		const auto Mix = [&Hash](const void* Data, size_t Size)
+		{
+			const uint8* Bytes = static_cast<const uint8*>(Data);
+			for (size_t Index = 0; Index < Size; ++Index)
+			{
+				Hash = (Hash ^ Bytes[Index]) * 16777619u;
+			}
+		};
+		Mix(&Table, sizeof(Table));
+		Mix(&Settings, sizeof(Settings));
+		return Hash;
+	}
+}
+
+FCharacterStateRuleSet::FCharacterStateRuleSet(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings, uint32 InHash, bool bInPersistent)
+	: Table(InTable)
+	, Settings(InSettings)
+	, Routes(FCharacterStateRouteTable::Build(InTable))
+	, Hash(InHash)
+	, bPersistent(bInPersistent)
+{
+}
+
+FCharacterStateRuleSetRef FCharacterStateRuleSet::Intern(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings)
+{
+	const uint32 Hash = HashRules(InTable, InSettings);
+
+	FCharacterStateRuleSetRegistry& Registry = GetRegistry();
+	std::lock_guard<std::mutex> Lock(Registry.Mutex);
+	for (FCharacterStateRuleSet* RuleSet = Registry.Head; RuleSet; RuleSet = RuleSet->Next)
+	{
+		if (RuleSet->Hash == Hash && std::memcmp(&RuleSet->Table, &InTable, sizeof(InTable)) == 0
+			&& std::memcmp(&RuleSet->Settings, &InSettings, sizeof(InSettings)) == 0)
+		{
+			RuleSet->RefCount.fetch_add(1, std::memory_order_relaxed);
+			return FCharacterStateRuleSetRef(RuleSet);
+		}
+	}
+
+	FCharacterStateRuleSet* RuleSet = new FCharacterStateRuleSet(InTable, InSettings, Hash, false);
+	RuleSet->RefCount.store(1, std::memory_order_relaxed);
+	RuleSet->Next = Registry.Head;
+	Registry.Head = RuleSet;
+	++Registry.Num;
+	return FCharacterStateRuleSetRef(RuleSet);
+}
+
+const FCharacterStateRuleSet& FCharacterStateRuleSet::GetDefault()
+{
+	static const FCharacterStateRuleSet Default(CharacterStateRules::Default, FCharacterStateMachineSettings(), 0, true);
+	return Default;
+}
+
+int32 FCharacterStateRuleSet::GetNumInterned()
+{
+	FCharacterStateRuleSetRegistry& Registry = GetRegistry();
+	std::lock_guard<std::mutex> Lock(Registry.Mutex);
+	return Registry.Num;
+}
+
+void FCharacterStateRuleSet::AddRef() const
+{
+	if (!bPersistent)
+	{
+		RefCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void FCharacterStateRuleSet::Release() const
+{
+	if (bPersistent)
+	{
+		return;
+	}
+
+	// Lock-free unless this may be the last reference: machines stopping in a busy world do not contend on the registry.
+	uint32 Count = RefCount.load(std::memory_order_relaxed);
+	while (Count > 1)
+	{
+		if (RefCount.compare_exchange_weak(Count, Count - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+
+	// Dropping the last reference and unlinking happen under the lock, so Intern() never hands out a rule set being freed.
+	// Intern() may have taken a new reference since the load above; then the rule set lives on.
+	FCharacterStateRuleSetRegistry& Registry = GetRegistry();
+	std::lock_guard<std::mutex> Lock(Registry.Mutex);
+	if (RefCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+
+	for (FCharacterStateRuleSet** Link = &Registry.Head; *Link; Link = &(*Link)->Next)
+	{
+		if (*Link == this)
+		{
+			*Link = Next;
+			--Registry.Num;
+			break;
+		}
+	}
+	delete this;
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+#include <atomic>
+
+class FCharacterStateRuleSetRef;
+
+/** Outcome of a speed threshold rule: the state to be in, and whether hysteresis or dwell time held back a switch the plain threshold would have made. */
+struct FCharacterStateThresholdResult
+{
+	ECharacterState Target;
+	bool bSuppressed;
+};
+
+/** Thresholds and capsule sizes read by the built-in states. */
+struct FCharacterStateMachineSettings
+{
+	/** Horizontal speed above this threshold enters Walking; below enters Idle. */
+	float NormalStateWalkThreshold = 10.f;
+
+	/** Horizontal speed below this threshold exits Sprinting. */
+	float SprintingMinSpeed = 600.f;
+
+	/** Target capsule half-height while crouched. */
+	float CrouchCapsuleHalfHeight = 44.f;
+
+	/** Capsule half-height restored when leaving Crouch; 0 leaves the capsule alone. */
+	float DefaultCapsuleHalfHeight = 0.f;
+
+	/**
+	 * Half-width of the band around NormalStateWalkThreshold when choosing between Idle and Walking: Idle starts walking
+	 * at the threshold plus this, Walking drops to Idle below the threshold minus this. 0 keeps the single threshold.
+	 */
+	float NormalStateWalkHysteresis = 0.f;
+
+	/** Sprinting is only left once horizontal speed is below SprintingMinSpeed minus this. */
+	float SprintingHysteresis = 0.f;
+
+	/**
+	 * Seconds each state must have been active before a speed threshold may switch out of it (Sprinting drop-out,
+	 * Idle <-> Walking). Forced, landing and requested transitions are never delayed.
+	 */
+	float MinDwellTime[NumCharacterStates] = {};
+
+	/**
+	 * Seconds after which each state is left on its own through FCharacterStateMachine::LeaveStateOnTimeout(), e.g.
+	 * Sliding's maximum duration or Grapple's maximum attach time; 0 for none. Registered when the state is entered.
+	 */
+	float MaxTimeInState[NumCharacterStates] = {};
+
+	/** Seconds after leaving each state before switches may enter it again, e.g. Crouch; 0 for none. */
+	float Cooldown[NumCharacterStates] = {};
+
+	/** Squared form of a speed threshold, for comparisons against squared horizontal speed; negative thresholds clamp to 0. */
+	static float SquaredSpeed(float Speed) { return Speed > 0.f ? Speed * Speed : 0.f; }
+
+	bool HasDwelt(ECharacterState State, float TimeInState) const { return TimeInState >= MinDwellTime[static_cast<uint8>(State)]; }
+
+	/**
+	 * Idle or Walking for a character in From. From Idle or Walking the hysteresis band and dwell time apply, so the result
+	 * may be From itself; from any other state (e.g. landing) the plain threshold decides.
+	 */
+	FCharacterStateThresholdResult EvaluateNormalState(ECharacterState From, float HorizontalSpeedSquared, float TimeInState) const
+	{
+		const ECharacterState Plain = HorizontalSpeedSquared >= SquaredSpeed(NormalStateWalkThreshold) ? ECharacterState::Walking : ECharacterState::Idle;
+		if (From != ECharacterState::Idle && From != ECharacterState::Walking)
+		{
+			return { Plain, false };
+		}
+
+		ECharacterState Target = From;
+		if (From == ECharacterState::Idle && HorizontalSpeedSquared >= SquaredSpeed(NormalStateWalkThreshold + NormalStateWalkHysteresis))
+		{
+			Target = ECharacterState::Walking;
+		}
+		else if (From == ECharacterState::Walking && HorizontalSpeedSquared < SquaredSpeed(NormalStateWalkThreshold - NormalStateWalkHysteresis))
+		{
+			Target = ECharacterState::Idle;
+		}
+		if (Target != From && !HasDwelt(From, TimeInState))
+		{
+			Target = From;
+		}
+		return { Target, Target != Plain };
+	}
+
+	/** Walking once Sprinting has fallen below its band for at least its dwell time, otherwise Sprinting. */
+	FCharacterStateThresholdResult EvaluateSprintingExit(float HorizontalSpeedSquared, float TimeInState) const
+	{
+		if (HorizontalSpeedSquared >= SquaredSpeed(SprintingMinSpeed))
+		{
+			return { ECharacterState::Sprinting, false };
+		}
+		if (HorizontalSpeedSquared < SquaredSpeed(SprintingMinSpeed - SprintingHysteresis) && HasDwelt(ECharacterState::Sprinting, TimeInState))
+		{
+			return { ECharacterState::Walking, false };
+		}
+		return { ECharacterState::Sprinting, true };
+	}
+};
+
+/**
+ * Transition table and settings shared, read-only, by every state machine started with the same rules. Instances are
+ * interned by content and reference-counted: the first machine of an archetype creates one, later ones only take a
+ * reference, and the last one to let go frees it. Hold them through FCharacterStateRuleSetRef.
+ */
+class CD_TEMP_API FCharacterStateRuleSet
+{
+public:
+	const FCharacterStateTransitionTable Table;
+	const FCharacterStateMachineSettings Settings;
+
+	/** Shortest legal routes through Table, built once when the rule set is created. */
+	const FCharacterStateRouteTable Routes;
+
+	/** The rule set with these contents, created on first use. Thread-safe. */
+	static FCharacterStateRuleSetRef Intern(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings);
+
+	/** CharacterStateRules::Default with default settings; never freed, and what machines use before Start(). */
+	static const FCharacterStateRuleSet& GetDefault();
+
+	/** Number of distinct interned rule sets alive (not counting the default). */
+	static int32 GetNumInterned();
+
+	/** Machines and batch slots currently sharing this rule set. */
+	uint32 GetRefCount() const { return RefCount.load(std::memory_order_relaxed); }
+
+	FCharacterStateRuleSet(const FCharacterStateRuleSet&) = delete;
+	FCharacterStateRuleSet& operator=(const FCharacterStateRuleSet&) = delete;
+
+private:
+	friend class FCharacterStateRuleSetRef;
+
+	FCharacterStateRuleSet(const FCharacterStateTransitionTable& InTable, const FCharacterStateMachineSettings& InSettings, uint32 InHash, bool bInPersistent);
+
+	void AddRef() const;
+	void Release() const;
+
+	/** Content hash and next entry in the intern list. */
+	uint32 Hash = 0;
+	FCharacterStateRuleSet* Next = nullptr;
+
+	mutable std::atomic<uint32> RefCount{ 0 };
+
+	/** Set on the default rule set, which is not reference-counted. */
+	bool bPersistent = false;
+};
+
+/** Counted reference to an FCharacterStateRuleSet. Default-constructed references point at FCharacterStateRuleSet::GetDefault(). */
+class CD_TEMP_API FCharacterStateRuleSetRef
+{
+public:
+	FCharacterStateRuleSetRef()
+		: RuleSet(&FCharacterStateRuleSet::GetDefault())
+	{
+	}
+
+	FCharacterStateRuleSetRef(const FCharacterStateRuleSetRef& Other)
+		: RuleSet(Other.RuleSet)
+	{
+		RuleSet->AddRef();
+	}
+
+	FCharacterStateRuleSetRef& operator=(const FCharacterStateRuleSetRef& Other)
+	{
+		Other.RuleSet->AddRef();
+		RuleSet->Release();
+		RuleSet = Other.RuleSet;
+		return *this;
+	}
+
+	~FCharacterStateRuleSetRef()
+	{
+		RuleSet->Release();
+	}
+
+	const FCharacterStateRuleSet& operator*() const { return *RuleSet; }
+	const FCharacterStateRuleSet* operator->() const { return RuleSet; }
+	const FCharacterStateRuleSet* Get() const { return RuleSet; }
+
+private:
+	friend class FCharacterStateRuleSet;
+
+	/** Adopts a reference that was already counted. */
+	explicit FCharacterStateRuleSetRef(const FCharacterStateRuleSet* InRuleSet)
+		: RuleSet(InRuleSet)
+	{
+	}
+
+	const FCharacterStateRuleSet* RuleSet;
+};
@@ -0,0 +1,165 @@
+
+#include "CharacterStateManagement/CharacterStateSnapshot.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+
+namespace
+{
+	/** One frame of scripted input. */
+	struct FRollbackBenchInput
+	{
+		FCharacterStateVector Velocity;
+		bool bGrounded = true;
+		bool bHasRequest = false;
+		ECharacterState Request = ECharacterState::Idle;
+
+		/** Request through RequestStateVia(), which may take several frames. */
+		bool bVia = false;
+	};
+
+	/** A character with nothing but its state machine, inputs and history. */
+	class FRollbackBenchCharacter final : public ICharacterStateEnvironment
+	{
+	public:
+		FRollbackBenchCharacter()
+			: Machine(*this)
+		{
+		}
+
+		virtual bool IsGrounded() const override { return bGrounded; }
+		virtual FCharacterStateVector GetLinearVelocity() const override { return Velocity; }
+		virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+		virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps) override { CapsuleHalfHeight = NewHalfHeight; }
+		virtual const TCHAR* GetDebugName() const override { return TEXT("Rollback"); }
+
+		/** Saves the snapshot the frame starts from, then runs it. */
+		void Step(uint32 Frame, const FRollbackBenchInput& Input, float DeltaTime)
+		{
+			FCharacterStateMachineSnapshot Snapshot;
+			Machine.SaveSnapshot(Snapshot);
+			History.Save(Frame, Snapshot);
+
+			bGrounded = Input.bGrounded;
+			Velocity = Input.Velocity;
+			if (Input.bHasRequest && Input.bVia)
+			{
+				Machine.RequestStateVia(Input.Request);
+			}
+			else if (Input.bHasRequest)
+			{
+				Machine.SwitchStateByEnum(Input.Request);
+			}
+			Machine.Tick(DeltaTime);
+		}
+
+		bool bGrounded = true;
+		FCharacterStateVector Velocity;
+		float CapsuleHalfHeight = 0.f;
+
+		FCharacterStateMachine Machine;
+		FCharacterStateSnapshotRing History;
+		FRollbackBenchInput Inputs[FCharacterStateSnapshotRing::Capacity];
+	};
+
+	/** Deterministic inputs that walk each character through most built-in transitions, out of phase with the others. */
+	FRollbackBenchInput MakeInput(int32 Character, uint32 Frame)
+	{
+		const uint32 Phase = Frame + static_cast<uint32>(Character) * 7u;
+
+		FRollbackBenchInput Input;
+		Input.bGrounded = Phase % 40u >= 6u;
+		Input.Velocity.X = Phase % 24u < 12u ? 750.0 : 250.0;
+		if (Phase % 13u == 0u)
+		{
+			Input.bHasRequest = true;
+			Input.Request = ECharacterState::Sprinting;
+		}
+		else if (Phase % 17u == 0u)
+		{
+			// From Sprinting or MidAir this is a two-hop route, so rollbacks land inside active routes.
+			Input.bHasRequest = true;
+			Input.bVia = true;
+			Input.Request = ECharacterState::Crouch;
+		}
+		else if (Phase % 29u == 0u)
+		{
+			Input.bHasRequest = true;
+			Input.Request = ECharacterState::Crouch;
+		}
+		else if (Phase % 31u == 0u)
+		{
+			Input.bHasRequest = true;
+			Input.Request = ECharacterState::Walking;
+		}
+		return Input;
+	}
+}
+
+FCharacterStateRollbackBenchmarkReport FCharacterStateRollbackBenchmark::Run(int32 NumCharacters, int32 NumFrames, int32 NumRollbacks)
+{
+	constexpr int32 Capacity = FCharacterStateSnapshotRing::Capacity;
+	constexpr float DeltaTime = 1.f / 60.f;
+
+	FCharacterStateRollbackBenchmarkReport Report;
+	Report.NumCharacters = NumCharacters > 0 ? NumCharacters : 1;
+	Report.NumFrames = NumFrames < 1 ? 1 : (NumFrames > Capacity - 1 ? Capacity - 1 : NumFrames);
+	Report.NumRollbacks = NumRollbacks > 0 ? NumRollbacks : 1;
+
+	FCharacterStateMachineSettings Settings;
+	Settings.DefaultCapsuleHalfHeight = 88.f;
+
+	FRollbackBenchCharacter* Characters = new FRollbackBenchCharacter[Report.NumCharacters];
+	FCharacterStateMachineSnapshot* Expected = new FCharacterStateMachineSnapshot[Report.NumCharacters];
+
+	// Fill the history with Capacity frames of ordinary simulation.
+	const FCharacterStateRuleSetRef Rules = FCharacterStateRuleSet::Intern(CharacterStateRules::Default, Settings);
+	const uint32 Now = static_cast<uint32>(Capacity);
+	for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+	{
+		FRollbackBenchCharacter& Character = Characters[Index];
+		Character.CapsuleHalfHeight = Settings.DefaultCapsuleHalfHeight;
+		Character.Machine.Start(Rules);
+		for (uint32 Frame = 0; Frame < Now; ++Frame)
+		{
+			Character.Inputs[Frame % Capacity] = MakeInput(Index, Frame);
+			Character.Step(Frame, Character.Inputs[Frame % Capacity], DeltaTime);
+		}
+		Character.Machine.SaveSnapshot(Expected[Index]);
+	}
+
+	const uint32 RollbackFrame = Now - static_cast<uint32>(Report.NumFrames);
+	double TotalSeconds = 0.0;
+	for (int32 Rollback = 0; Rollback < Report.NumRollbacks; ++Rollback)
+	{
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+		{
+			FRollbackBenchCharacter& Character = Characters[Index];
+			Character.Machine.RestoreSnapshot(*Character.History.Find(RollbackFrame));
+			for (uint32 Frame = RollbackFrame; Frame < Now; ++Frame)
+			{
+				Character.Step(Frame, Character.Inputs[Frame % Capacity], DeltaTime);
+			}
+			Character.Machine.ReconcileSideEffects();
+		}
+		const double Seconds = static_cast<double>(FCharacterStateStats::Cycles() - StartCycles) * FCharacterStateStats::SecondsPerCycle();
+		TotalSeconds += Seconds;
+		Report.WorstSeconds = Seconds > Report.WorstSeconds ? Seconds : Report.WorstSeconds;
+
+		for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+		{
+			const FCharacterStateMachine& Machine = Characters[Index].Machine;
+			if (Machine.GetCurrentStateEnum() != Expected[Index].State || Machine.HasRoute() != Expected[Index].bHasRoute
+				|| (Machine.HasRoute() && Machine.GetRouteTarget() != Expected[Index].RouteTarget))
+			{
+				++Report.NumMismatches;
+				break;
+			}
+		}
+	}
+	Report.AverageSeconds = TotalSeconds / Report.NumRollbacks;
+
+	delete[] Expected;
+	delete[] Characters;
+	return Report;
+}
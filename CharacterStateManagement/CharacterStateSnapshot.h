@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateLatent.h"
+#include "CharacterStateManagement/CharacterStateRegions.h"
+#include "CharacterStateManagement/CharacterStateRequestQueue.h"
+#include <type_traits>
+
+/**
+ * Everything an FCharacterStateMachine simulates from frame to frame: current state and time in it, region states and
+ * times, queued requests, an active RequestStateVia() route, a latent state's pending await, the state timeout and
+ * cooldowns. Rules, registered states and counters are not included; a snapshot is restored into the machine it was taken from (or one started with the same
+ * rules and regions). Plain data, copied with memcpy.
+ */
+struct FCharacterStateMachineSnapshot
+{
+	FCharacterStateRequestQueue RequestQueue;
+	FCharacterStateAwait Await;
+	float TimeInState = 0.f;
+	float StateTimeoutLeft = 0.f;
+	float CooldownLeft[NumCharacterStates] = {};
+	float RegionTimeInState[MaxCharacterStateRegions] = {};
+	ECharacterState State = ECharacterState::Idle;
+	ECharacterState RouteTarget = ECharacterState::Idle;
+	uint8 RegionStates[MaxCharacterStateRegions] = {};
+	uint8 NumRegions = 0;
+	bool bHasStateTimeout = false;
+	bool bHasRoute = false;
+};
+
+static_assert(std::is_trivially_copyable<FCharacterStateMachineSnapshot>::value, "FCharacterStateMachineSnapshot must stay plain data.");
+
+/**
+ * Snapshots of one character's last Capacity frames for rollback, indexed by frame number: saving overwrites the frame
+ * Capacity frames older, and finding a frame is one array access.
+ */
+class FCharacterStateSnapshotRing
+{
+public:
+	static constexpr int32 Capacity = 16;
+
+	void Save(uint32 Frame, const FCharacterStateMachineSnapshot& Snapshot)
+	{
+		const int32 Index = static_cast<int32>(Frame % Capacity);
+		Snapshots[Index] = Snapshot;
+		Frames[Index] = Frame;
+		ValidMask |= 1u << Index;
+	}
+
+	/** The snapshot saved for Frame, or nullptr if it was never saved or has been overwritten. */
+	const FCharacterStateMachineSnapshot* Find(uint32 Frame) const
+	{
+		const int32 Index = static_cast<int32>(Frame % Capacity);
+		return (ValidMask & (1u << Index)) != 0 && Frames[Index] == Frame ? &Snapshots[Index] : nullptr;
+	}
+
+	void Reset() { ValidMask = 0; }
+
+private:
+	FCharacterStateMachineSnapshot Snapshots[Capacity];
+	uint32 Frames[Capacity] = {};
+	uint32 ValidMask = 0;
+};
+
+/** Results of FCharacterStateRollbackBenchmark::Run(). */
+struct FCharacterStateRollbackBenchmarkReport
+{
+	int32 NumCharacters = 0;
+	int32 NumFrames = 0;
+	int32 NumRollbacks = 0;
+
+	/** Seconds to restore, resimulate NumFrames and reconcile every character once: average and worst of NumRollbacks. */
+	double AverageSeconds = 0.0;
+	double WorstSeconds = 0.0;
+
+	/** Rollbacks that ended in a different state or route than the original simulation; nonzero means resimulation is not deterministic. */
+	uint32 NumMismatches = 0;
+};
+
+/**
+ * Headless rollback benchmark: NumCharacters machines with the built-in states run scripted inputs (leaving the ground,
+ * speed changes, sprint and crouch requests, crouching through RequestStateVia() routes) while saving a snapshot per
+ * frame. Each rollback then rewinds every character NumFrames (at most FCharacterStateSnapshotRing::Capacity - 1),
+ * resimulates the same inputs, saving snapshots again, and reconciles.
+ */
+class CD_TEMP_API FCharacterStateRollbackBenchmark
+{
+public:
+	static FCharacterStateRollbackBenchmarkReport Run(int32 NumCharacters, int32 NumFrames, int32 NumRollbacks);
+};
@@ -0,0 +1,70 @@
+
+#include "CharacterStateManagement/CharacterStateStats.h"
+
+#if defined(WITH_ENGINE)
+#include "HAL/PlatformTime.h"
+#else
+#include <chrono>
+#endif
+
+void FCharacterStateStats::Accumulate(const FCharacterStateStats& Other)
+{
+	for (int32 From = 0; From < NumCharacterStates; ++From)
+	{
+		TimeInState[From] += Other.TimeInState[From];
+		for (int32 To = 0; To < NumCharacterStates; ++To)
+		{
+			Transitions[From][To] += Other.Transitions[From][To];
+			Rejected[From][To] += Other.Rejected[From][To];
+		}
+		for (int32 Hook = 0; Hook < NumCharacterStateHooks; ++Hook)
+		{
+			HookCalls[From][Hook] += Other.HookCalls[From][Hook];
+			HookCycles[From][Hook] += Other.HookCycles[From][Hook];
+		}
+	}
+}
+
+uint32 FCharacterStateStats::GetNumTransitions() const
+{
+	uint32 Num = 0;
+	for (int32 From = 0; From < NumCharacterStates; ++From)
+	{
+		for (int32 To = 0; To < NumCharacterStates; ++To)
+		{
+			Num += Transitions[From][To];
+		}
+	}
+	return Num;
+}
+
+uint32 FCharacterStateStats::GetNumRejected() const
+{
+	uint32 Num = 0;
+	for (int32 From = 0; From < NumCharacterStates; ++From)
+	{
+		for (int32 To = 0; To < NumCharacterStates; ++To)
+		{
+			Num += Rejected[From][To];
+		}
+	}
+	return Num;
+}
+
+uint64 FCharacterStateStats::Cycles()
+{
+#if defined(WITH_ENGINE)
+	return FPlatformTime::Cycles64();
+#else
+	return static_cast<uint64>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+double FCharacterStateStats::SecondsPerCycle()
+{
+#if defined(WITH_ENGINE)
+	return FPlatformTime::GetSecondsPerCycle64();
+#else
+	return static_cast<double>(std::chrono::steady_clock::period::num) / static_cast<double>(std::chrono::steady_clock::period::den);
+#endif
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+
+/** State hooks timed by FCharacterStateStats. */
+enum class ECharacterStateHook : uint8
+{
+	Enter,
+	Tick,
+	Exit
+};
+
+constexpr int32 NumCharacterStateHooks = 3;
+
+/**
+ * Counters collected by one FCharacterStateMachine while stats are enabled (FCharacterStateMachine::SetCollectStats()),
+ * and the sum of many machines for per-world views. Fixed-size arrays indexed by state, so collecting never allocates and
+ * merging is a loop of additions. Nothing is collected when CHARACTER_STATE_WITH_STATS is off.
+ */
+struct CD_TEMP_API FCharacterStateStats
+{
+	/** Seconds spent in each state, from Tick() and AdvanceStateTime(). */
+	double TimeInState[NumCharacterStates] = {};
+
+	/** Transitions performed, by [From][To]. */
+	uint32 Transitions[NumCharacterStates][NumCharacterStates] = {};
+
+	/** Switches refused by the transition table, by [From][To]. */
+	uint32 Rejected[NumCharacterStates][NumCharacterStates] = {};
+
+	/** Calls to and cycles spent in each state's Enter/Tick/Exit, by [State][Hook]; see Cycles(). */
+	uint32 HookCalls[NumCharacterStates][NumCharacterStateHooks] = {};
+	uint64 HookCycles[NumCharacterStates][NumCharacterStateHooks] = {};
+
+	void Accumulate(const FCharacterStateStats& Other);
+	void Reset() { *this = FCharacterStateStats(); }
+
+	uint32 GetNumTransitions() const;
+	uint32 GetNumRejected() const;
+
+	/** Timestamp in the units of HookCycles. */
+	static uint64 Cycles();
+	static double SecondsPerCycle();
+};
+
+#if CHARACTER_STATE_WITH_STATS
+
+/** Adds the cycles of its scope to one hook of one state; does nothing without stats. */
+struct FCharacterStateScopedHookTimer
+{
+	FCharacterStateScopedHookTimer(FCharacterStateStats* InStats, ECharacterState InState, ECharacterStateHook InHook)
+		: Stats(InStats)
+		, State(InState)
+		, Hook(InHook)
+		, StartCycles(InStats ? FCharacterStateStats::Cycles() : 0)
+	{
+	}
+
+	~FCharacterStateScopedHookTimer()
+	{
+		if (Stats)
+		{
+			const uint8 StateIndex = static_cast<uint8>(State);
+			const uint8 HookIndex = static_cast<uint8>(Hook);
+			++Stats->HookCalls[StateIndex][HookIndex];
+			Stats->HookCycles[StateIndex][HookIndex] += FCharacterStateStats::Cycles() - StartCycles;
+		}
+	}
+
+	FCharacterStateStats* Stats;
+	ECharacterState State;
+	ECharacterStateHook Hook;
+	uint64 StartCycles;
+};
+
+#define CHARACTER_STATE_SCOPED_HOOK_TIMER(Stats, State, Hook) FCharacterStateScopedHookTimer CharacterStateHookTimer(Stats, State, Hook)
+
+#else
+
+#define CHARACTER_STATE_SCOPED_HOOK_TIMER(Stats, State, Hook) do {} while (0)
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/**
+ * Tick-rate levels for characters far from every viewer: level N runs the state machine every 2^N frames
+ * (full, 1/2, 1/4, 1/8 rate). Characters are staggered by a per-character phase, so each frame evaluates an even
+ * fraction of every level's population instead of all of it at once.
+ */
+namespace CharacterStateTickLOD
+{
+	constexpr uint8 MaxLevel = 3;
+
+	/** Upper bound on the frames between two evaluations of one character, and so on the delay of a forced switch to MidAir. */
+	constexpr uint32 MaxFrameInterval = 1u << MaxLevel;
+
+	/** Distance from the nearest viewer at which each reduced rate starts. */
+	struct FSettings
+	{
+		float HalfRateDistance = 1500.f;
+		float QuarterRateDistance = 3000.f;
+		float EighthRateDistance = 6000.f;
+	};
+
+	/**
+	 * Level for a character DistanceSquared away from the nearest viewer, raised by Bias (budget pressure) and clamped to
+	 * MaxLevel. Characters within HalfRateDistance stay at full rate whatever the bias.
+	 */
+	inline uint8 ComputeLevel(float DistanceSquared, const FSettings& Settings, uint8 Bias = 0)
+	{
+		uint8 Level = 0;
+		if (DistanceSquared >= Settings.EighthRateDistance * Settings.EighthRateDistance)
+		{
+			Level = 3;
+		}
+		else if (DistanceSquared >= Settings.QuarterRateDistance * Settings.QuarterRateDistance)
+		{
+			Level = 2;
+		}
+		else if (DistanceSquared >= Settings.HalfRateDistance * Settings.HalfRateDistance)
+		{
+			Level = 1;
+		}
+		else
+		{
+			return 0;
+		}
+		const uint32 Biased = static_cast<uint32>(Level) + Bias;
+		return static_cast<uint8>(Biased < MaxLevel ? Biased : MaxLevel);
+	}
+
+	/** True on the frames a character with the given phase runs at Level. */
+	inline bool ShouldTick(uint64 FrameNumber, uint32 Phase, uint8 Level)
+	{
+		const uint64 Mask = (uint64(1) << Level) - 1;
+		return ((FrameNumber + Phase) & Mask) == 0;
+	}
+}
@@ -0,0 +1,359 @@
+
+#include "CharacterStateManagement/CharacterStateTimers.h"
+#include "CharacterStateManagement/CharacterStateLatent.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+
+FCharacterStateTimerWheel::FCharacterStateTimerWheel(double InResolution)
+	: Resolution(InResolution > 0.0 ? InResolution : DefaultResolution)
+{
+}
+
+void FCharacterStateTimerWheel::Link(FCharacterStateTimer& Timer, uint16 List)
+{
+	Timer.Next = Lists[List];
+	if (Timer.Next)
+	{
+		Timer.Next->PrevNext = &Timer.Next;
+	}
+	Lists[List] = &Timer;
+	Timer.PrevNext = &Lists[List];
+	Timer.List = List;
+}
+
+void FCharacterStateTimerWheel::Unlink(FCharacterStateTimer& Timer)
+{
+	*Timer.PrevNext = Timer.Next;
+	if (Timer.Next)
+	{
+		Timer.Next->PrevNext = Timer.PrevNext;
+	}
+	if (Timer.List < OverflowList && !Lists[Timer.List])
+	{
+		Occupied[Timer.List / NumSlots] &= ~(uint64(1) << (Timer.List % NumSlots));
+	}
+	Timer.Next = nullptr;
+	Timer.PrevNext = nullptr;
+}
+
+void FCharacterStateTimerWheel::Place(FCharacterStateTimer& Timer)
+{
+	uint64 Tick = TickOf(Timer.Deadline);
+	if (Tick < CurrentTick)
+	{
+		Tick = CurrentTick;
+	}
+
+	// The lowest level whose current turn contains Tick.
+	for (int32 Level = 0; Level < NumLevels; ++Level)
+	{
+		const int32 TurnShift = SlotBits * (Level + 1);
+		if ((Tick >> TurnShift) == (CurrentTick >> TurnShift))
+		{
+			const uint16 Slot = static_cast<uint16>((Tick >> (SlotBits * Level)) & (NumSlots - 1));
+			Occupied[Level] |= uint64(1) << Slot;
+			Link(Timer, static_cast<uint16>(Level * NumSlots + Slot));
+			return;
+		}
+	}
+	Link(Timer, OverflowList);
+}
+
+void FCharacterStateTimerWheel::Cascade(uint16 List)
+{
+	FCharacterStateTimer* Timer = Lists[List];
+	Lists[List] = nullptr;
+	if (List < OverflowList)
+	{
+		Occupied[List / NumSlots] &= ~(uint64(1) << (List % NumSlots));
+	}
+	while (Timer)
+	{
+		FCharacterStateTimer* Next = Timer->Next;
+		Timer->Next = nullptr;
+		Timer->PrevNext = nullptr;
+		Place(*Timer);
+		++NumCascaded;
+		Timer = Next;
+	}
+}
+
+int32 FCharacterStateTimerWheel::ExpireCurrentSlot()
+{
+	const uint16 List = static_cast<uint16>(CurrentTick & (NumSlots - 1));
+	int32 NumExpired = 0;
+	for (FCharacterStateTimer* Timer = Lists[List]; Timer; )
+	{
+		FCharacterStateTimer* Next = Timer->Next;
+		if (Timer->Deadline <= Time)
+		{
+			Unlink(*Timer);
+			Link(*Timer, ExpiredList);
+			++NumExpired;
+		}
+		Timer = Next;
+	}
+	return NumExpired;
+}
+
+void FCharacterStateTimerWheel::Schedule(FCharacterStateTimer& Timer, double Seconds)
+{
+	if (Timer.IsScheduled())
+	{
+		Unlink(Timer);
+		--Num;
+	}
+	Timer.Deadline = Time + Seconds;
+	Place(Timer);
+	++Num;
+}
+
+void FCharacterStateTimerWheel::Cancel(FCharacterStateTimer& Timer)
+{
+	if (Timer.IsScheduled())
+	{
+		Unlink(Timer);
+		--Num;
+	}
+}
+
+int32 FCharacterStateTimerWheel::Advance(double DeltaTime)
+{
+	Time += DeltaTime;
+	const uint64 TargetTick = TickOf(Time);
+	if (Num == 0)
+	{
+		CurrentTick = TargetTick > CurrentTick ? TargetTick : CurrentTick;
+		return 0;
+	}
+
+	// The current slot again first: it may hold timers that were not due yet at the last Advance().
+	int32 NumExpired = ExpireCurrentSlot();
+	while (CurrentTick < TargetTick)
+	{
+		// Nothing left in level 0's current turn: jump to the next turn, where the level above refills it.
+		const int32 Index = static_cast<int32>(CurrentTick & (NumSlots - 1));
+		const bool bAhead = Index + 1 < NumSlots && (Occupied[0] >> (Index + 1)) != 0;
+		const uint64 NextTick = bAhead ? CurrentTick + 1 : (CurrentTick | (NumSlots - 1)) + 1;
+		if (NextTick > TargetTick)
+		{
+			CurrentTick = TargetTick;
+			break;
+		}
+		CurrentTick = NextTick;
+
+		// Highest level first, so timers it moves down are picked up by the lower levels at this same boundary.
+		if ((CurrentTick & ((uint64(1) << (SlotBits * NumLevels)) - 1)) == 0)
+		{
+			Cascade(OverflowList);
+		}
+		for (int32 Level = NumLevels - 1; Level > 0; --Level)
+		{
+			if ((CurrentTick & ((uint64(1) << (SlotBits * Level)) - 1)) == 0)
+			{
+				Cascade(static_cast<uint16>(Level * NumSlots + ((CurrentTick >> (SlotBits * Level)) & (NumSlots - 1))));
+			}
+		}
+		NumExpired += ExpireCurrentSlot();
+	}
+	return NumExpired;
+}
+
+FCharacterStateTimer* FCharacterStateTimerWheel::PopExpired()
+{
+	FCharacterStateTimer* Timer = Lists[ExpiredList];
+	if (Timer)
+	{
+		Unlink(*Timer);
+		--Num;
+	}
+	return Timer;
+}
+
+FCharacterStateTimer* FCharacterStateTimerWheel::PopAny()
+{
+	for (int32 List = NumLists - 1; List >= 0 && Num > 0; --List)
+	{
+		if (FCharacterStateTimer* Timer = Lists[List])
+		{
+			Unlink(*Timer);
+			--Num;
+			return Timer;
+		}
+	}
+	return nullptr;
+}
+
+namespace
+{
+	constexpr uint32 TimeoutBenchScriptFrames = 240;
+
+	/** A character with nothing but its state machine and the tick bookkeeping of an event-driven component. */
+	class FTimeoutBenchCharacter final : public ICharacterStateEnvironment
+	{
+	public:
+		FTimeoutBenchCharacter()
+			: Machine(*this)
+		{
+		}
+
+		virtual bool IsGrounded() const override { return bGrounded; }
+		virtual FCharacterStateVector GetLinearVelocity() const override { return Velocity; }
+		virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+		virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool bUpdateOverlaps) override {}
+		virtual void OnStateChanged(ECharacterState PreviousState, ECharacterState NewState) override { bAwake = Machine.NeedsTick(); }
+		virtual void OnStateResumed(ECharacterState State) override { bAwake = Machine.NeedsTick(); }
+		virtual const TCHAR* GetDebugName() const override { return TEXT("Timeout"); }
+
+		/** Applies this frame's scripted inputs: a slide, a wall run, a grapple, or idling. */
+		void ApplyInputs(int32 Character, uint32 Frame)
+		{
+			const uint32 Phase = (Frame + static_cast<uint32>(Character) * 37u) % TimeoutBenchScriptFrames;
+			switch (Character % 4)
+			{
+				case 0:
+					if (Phase == 0u)
+					{
+						Velocity.X = 500.0;
+						Machine.SwitchStateByEnum(ECharacterState::Sliding);
+					}
+					break;
+				case 1:
+					if (Phase == 0u)
+					{
+						bGrounded = false;
+					}
+					else if (Phase == 10u)
+					{
+						Machine.SwitchStateByEnum(ECharacterState::WallRun);
+					}
+					else if (Phase == 200u)
+					{
+						bGrounded = true;
+					}
+					break;
+				case 2:
+					if (Phase == 0u)
+					{
+						bGrounded = false;
+					}
+					else if (Phase == 5u)
+					{
+						Machine.SwitchStateByEnum(ECharacterState::Grapple);
+					}
+					else if (Phase == 180u)
+					{
+						bGrounded = true;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		bool bGrounded = true;
+		FCharacterStateVector Velocity;
+
+		/** Wheel variant: ticking enabled, and time since the last tick. */
+		bool bAwake = false;
+		float AccumulatedDeltaTime = 0.f;
+
+		FCharacterStateMachine Machine;
+	};
+
+	/** Runs one variant; returns its seconds and fills OutStates with the final states. */
+	double RunTimeoutBenchVariant(bool bWheel, int32 NumCharacters, int32 NumFrames, ECharacterState* OutStates, FCharacterStateTimeoutBenchmarkReport& Report)
+	{
+		constexpr float DeltaTime = 1.f / 60.f;
+
+		// Not multiples of the frame time, so both variants leave on the same frame.
+		FCharacterStateMachineSettings Settings;
+		Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.81f;
+		Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::WallRun)] = 1.23f;
+		Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Grapple)] = 1.97f;
+		const FCharacterStateRuleSetRef Rules = FCharacterStateRuleSet::Intern(CharacterStateRules::Default, Settings);
+
+		FCharacterStateLatentScheduler Scheduler;
+		FTimeoutBenchCharacter* Characters = new FTimeoutBenchCharacter[NumCharacters];
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			FCharacterStateMachine& Machine = Characters[Index].Machine;
+			if (bWheel)
+			{
+				Machine.SetLatentScheduler(&Scheduler);
+			}
+			Machine.Start(Rules);
+			Characters[Index].bAwake = Machine.NeedsTick();
+		}
+
+		uint64& NumTicks = bWheel ? Report.NumWheelTicks : Report.NumPollingTicks;
+		const uint64 StartCycles = FCharacterStateStats::Cycles();
+		for (uint32 Frame = 0; Frame < static_cast<uint32>(NumFrames); ++Frame)
+		{
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				FTimeoutBenchCharacter& Character = Characters[Index];
+				const bool bWasGrounded = Character.bGrounded;
+				Character.ApplyInputs(Index, Frame);
+				if (!bWheel)
+				{
+					Character.Machine.Tick(DeltaTime);
+					++NumTicks;
+					continue;
+				}
+
+				// Asleep until something needs a tick or the movement mode changes.
+				Character.AccumulatedDeltaTime += DeltaTime;
+				if (Character.bAwake || Character.bGrounded != bWasGrounded)
+				{
+					Character.Machine.Tick(Character.AccumulatedDeltaTime);
+					Character.AccumulatedDeltaTime = 0.f;
+					Character.bAwake = Character.Machine.NeedsTick();
+					++NumTicks;
+				}
+			}
+			if (bWheel)
+			{
+				Scheduler.Update(DeltaTime);
+			}
+		}
+		const double Seconds = static_cast<double>(FCharacterStateStats::Cycles() - StartCycles) * FCharacterStateStats::SecondsPerCycle();
+
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			OutStates[Index] = Characters[Index].Machine.GetCurrentStateEnum();
+		}
+		if (bWheel)
+		{
+			Report.NumTimeouts = Scheduler.GetNumTimedOut();
+			Report.NumCascaded = Scheduler.GetWheel().GetNumCascaded();
+		}
+
+		// Before the scheduler goes out of scope: stopping a machine cancels its timeout.
+		delete[] Characters;
+		return Seconds;
+	}
+}
+
+FCharacterStateTimeoutBenchmarkReport FCharacterStateTimeoutBenchmark::Run(int32 NumCharacters, int32 NumFrames)
+{
+	FCharacterStateTimeoutBenchmarkReport Report;
+	Report.NumCharacters = NumCharacters > 0 ? NumCharacters : 1;
+	Report.NumFrames = NumFrames > 0 ? NumFrames : 1;
+
+	ECharacterState* PollingStates = new ECharacterState[Report.NumCharacters];
+	ECharacterState* WheelStates = new ECharacterState[Report.NumCharacters];
+	Report.PollingSeconds = RunTimeoutBenchVariant(false, Report.NumCharacters, Report.NumFrames, PollingStates, Report);
+	Report.WheelSeconds = RunTimeoutBenchVariant(true, Report.NumCharacters, Report.NumFrames, WheelStates, Report);
+	for (int32 Index = 0; Index < Report.NumCharacters; ++Index)
+	{
+		if (PollingStates[Index] != WheelStates[Index])
+		{
+			++Report.NumMismatches;
+		}
+	}
+
+	delete[] WheelStates;
+	delete[] PollingStates;
+	return Report;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+class FCharacterStateMachine;
+
+/**
+ * Intrusive entry of FCharacterStateTimerWheel: a deadline on the wheel's clock and the machine it belongs to. Embedded in
+ * FCharacterStateMachine (its await delay and its state timeout), so scheduling never allocates.
+ */
+struct FCharacterStateTimer
+{
+	FCharacterStateMachine* Machine = nullptr;
+	double Deadline = 0.0;
+
+	FCharacterStateTimer* Next = nullptr;
+
+	/** The link pointing at this timer (a list head or the previous timer's Next); nullptr while not scheduled. */
+	FCharacterStateTimer** PrevNext = nullptr;
+
+	/** Level * NumSlots + slot, or one of the wheel's list indices past the slots. */
+	uint16 List = 0;
+
+	bool IsScheduled() const { return PrevNext != nullptr; }
+};
+
+/**
+ * Hierarchical timing wheel: NumLevels levels of NumSlots slots, where a slot of level L covers NumSlots^L ticks of
+ * Resolution seconds. Schedule() and Cancel() are O(1). Advance() visits one slot per elapsed tick, jumps over empty
+ * runs, and moves a timer down a level at most NumLevels - 1 times before it expires, so its cost follows the number of
+ * expirations rather than the number of timers. Timers expire exactly at their deadline (the first Advance() that reaches
+ * it), not rounded up to ticks. Deadlines past the top level (about 19 hours at the default resolution) wait in an
+ * overflow list that is revisited once per turn of the top level. Game thread only.
+ */
+class CD_TEMP_API FCharacterStateTimerWheel
+{
+public:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+
+	/** Four ticks per 60 Hz frame: a level 0 turn is about a quarter second. */
+	static constexpr double DefaultResolution = 1.0 / 240.0;
+
+	explicit FCharacterStateTimerWheel(double InResolution = DefaultResolution);
+
+	FCharacterStateTimerWheel(const FCharacterStateTimerWheel&) = delete;
+	FCharacterStateTimerWheel& operator=(const FCharacterStateTimerWheel&) = delete;
+
+	/** Schedules Timer Seconds from now, rescheduling it if it is already scheduled. Negative seconds expire on the next Advance(). */
+	void Schedule(FCharacterStateTimer& Timer, double Seconds);
+
+	/** Unschedules Timer, including a timer that has expired but not been popped yet. Does nothing if it is not scheduled. */
+	void Cancel(FCharacterStateTimer& Timer);
+
+	/** Advances the clock and moves every timer whose deadline has been reached to the expired list. Returns their number. */
+	int32 Advance(double DeltaTime);
+
+	/** Unlinks and returns the next expired timer, or nullptr. Timers may be scheduled or cancelled between pops. */
+	FCharacterStateTimer* PopExpired();
+
+	/** Unlinks and returns any scheduled timer, expired or not, or nullptr once the wheel is empty; for tearing it down. */
+	FCharacterStateTimer* PopAny();
+
+	double GetTime() const { return Time; }
+	double GetSecondsLeft(const FCharacterStateTimer& Timer) const { return Timer.Deadline - Time; }
+
+	/** Scheduled timers, including expired ones not popped yet. */
+	int32 GetNum() const { return Num; }
+
+	/** Timers moved from a slot to a lower level or back into the overflow list. */
+	uint32 GetNumCascaded() const { return NumCascaded; }
+
+private:
+	static constexpr uint16 OverflowList = NumLevels * NumSlots;
+	static constexpr uint16 ExpiredList = OverflowList + 1;
+	static constexpr int32 NumLists = ExpiredList + 1;
+
+	uint64 TickOf(double Seconds) const { return Seconds > 0.0 ? static_cast<uint64>(Seconds / Resolution) : 0; }
+
+	void Link(FCharacterStateTimer& Timer, uint16 List);
+	void Unlink(FCharacterStateTimer& Timer);
+
+	/** Links Timer into the slot of its tick relative to CurrentTick, or the overflow list. */
+	void Place(FCharacterStateTimer& Timer);
+
+	/** Re-places every timer of one list, moving them down towards level 0. */
+	void Cascade(uint16 List);
+
+	/** Moves the due timers of CurrentTick's level 0 slot to the expired list. Returns their number. */
+	int32 ExpireCurrentSlot();
+
+	FCharacterStateTimer* Lists[NumLists] = {};
+
+	/** Per level, a bit for every slot that may be non-empty. */
+	uint64 Occupied[NumLevels] = {};
+
+	double Resolution;
+	double Time = 0.0;
+	uint64 CurrentTick = 0;
+	int32 Num = 0;
+	uint32 NumCascaded = 0;
+};
+
+/** Results of FCharacterStateTimeoutBenchmark::Run(). */
+struct FCharacterStateTimeoutBenchmarkReport
+{
+	int32 NumCharacters = 0;
+	int32 NumFrames = 0;
+
+	/** Seconds for all frames: every character ticked to watch its time in state, and timeouts on the timing wheel. */
+	double PollingSeconds = 0.0;
+	double WheelSeconds = 0.0;
+
+	/** Machine ticks run by each variant. */
+	uint64 NumPollingTicks = 0;
+	uint64 NumWheelTicks = 0;
+
+	/** Timeouts expired by the wheel, and timers it moved down a level. */
+	uint32 NumTimeouts = 0;
+	uint32 NumCascaded = 0;
+
+	/** Characters that ended in a different state in the two variants; nonzero means they do not behave alike. */
+	uint32 NumMismatches = 0;
+};
+
+/**
+ * Headless benchmark of state timeouts: NumCharacters characters split between slides, wall runs and grapples that end on
+ * their MaxTimeInState, and idling. Both variants run the same scripted inputs. The polling variant has no scheduler, so
+ * every timed state ticks every frame until its time in state runs out; the wheel variant ticks only characters whose
+ * NeedsTick() is true or whose movement mode changed (as event-driven components do) and expires the rest from a
+ * FCharacterStateLatentScheduler.
+ */
+class CD_TEMP_API FCharacterStateTimeoutBenchmark
+{
+public:
+	static FCharacterStateTimeoutBenchmarkReport Run(int32 NumCharacters, int32 NumFrames);
+};
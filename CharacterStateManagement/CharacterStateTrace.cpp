@@ -0,0 +1,40 @@
+
+#include "CharacterStateManagement/CharacterStateTrace.h"
+
+#if defined(WITH_ENGINE)
+#include "HAL/PlatformTime.h"
+#else
+#include <chrono>
+#endif
+
+#if defined(WITH_ENGINE) && CHARACTER_STATE_WITH_LOGGING
+DEFINE_LOG_CATEGORY(LogCharacterState);
+#endif
+
+bool FCharacterStateTrace::bEnabled = false;
+FCharacterStateTraceRecord FCharacterStateTrace::Records[FCharacterStateTrace::Capacity];
+uint64 FCharacterStateTrace::NumRecorded = 0;
+
+double FCharacterStateTrace::Now()
+{
+#if defined(WITH_ENGINE)
+	return FPlatformTime::Seconds();
+#else
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int32 FCharacterStateTrace::GetRecent(FCharacterStateTraceRecord* OutRecords, int32 MaxRecords)
+{
+	if (MaxRecords <= 0)
+	{
+		return 0;
+	}
+	const uint64 Available = NumRecorded < static_cast<uint64>(Capacity) ? NumRecorded : static_cast<uint64>(Capacity);
+	const int32 Count = static_cast<int32>(static_cast<uint64>(MaxRecords) < Available ? static_cast<uint64>(MaxRecords) : Available);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		OutRecords[Index] = Records[(NumRecorded - 1 - Index) % Capacity];
+	}
+	return Count;
+}
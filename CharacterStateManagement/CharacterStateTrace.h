@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/** One successful transition. */
+struct FCharacterStateTraceRecord
+{
+	double TimeSeconds = 0.0;
+	uint32 OwnerId = 0;
+	ECharacterState From = ECharacterState::Idle;
+	ECharacterState To = ECharacterState::Idle;
+};
+
+/**
+ * Process-wide, fixed-size ring buffer of transitions. Written by FCharacterStateMachine::SwitchState on the game thread
+ * when CHARACTER_STATE_WITH_TRACE is set and recording is enabled; debug views read it instead of being pushed strings.
+ * No allocation, no formatting.
+ */
+class CD_TEMP_API FCharacterStateTrace
+{
+public:
+	static constexpr int32 Capacity = 256;
+
+	/** Runtime toggle; recording is skipped while false. */
+	static bool bEnabled;
+
+	static void Record(uint32 OwnerId, ECharacterState From, ECharacterState To)
+	{
+		if (!bEnabled)
+		{
+			return;
+		}
+		FCharacterStateTraceRecord& Entry = Records[NumRecorded++ % Capacity];
+		Entry.TimeSeconds = Now();
+		Entry.OwnerId = OwnerId;
+		Entry.From = From;
+		Entry.To = To;
+	}
+
+	/** Copies up to MaxRecords of the most recent records into OutRecords, newest first. Returns the number copied. */
+	static int32 GetRecent(FCharacterStateTraceRecord* OutRecords, int32 MaxRecords);
+
+	/** Total transitions recorded since the last Reset (may exceed Capacity). */
+	static uint64 GetNumRecorded() { return NumRecorded; }
+
+	static void Reset() { NumRecorded = 0; }
+
+private:
+	static double Now();
+
+	static FCharacterStateTraceRecord Records[Capacity];
+	static uint64 NumRecorded;
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateCoreTypes.h"
+
+/** One bit per ECharacterState (bit index == enum value). */
+using FCharacterStateMask = uint8;
+
+/** Number of ECharacterState values; rows and columns of the transition table. */
+constexpr int32 NumCharacterStates = 8;
+
+static_assert(static_cast<int32>(ECharacterState::Grapple) == NumCharacterStates - 1, "Update NumCharacterStates when ECharacterState changes.");
+static_assert(NumCharacterStates <= static_cast<int32>(sizeof(FCharacterStateMask) * 8), "FCharacterStateMask is too narrow for ECharacterState.");
+
+/** Bit for a single state. */
+constexpr FCharacterStateMask CharacterStateBit(ECharacterState State)
+{
+	return static_cast<FCharacterStateMask>(1u << static_cast<uint8>(State));
+}
+
+/** Builds a mask from a list of states, e.g. MakeCharacterStateMask(ECharacterState::Idle, ECharacterState::Walking). */
+template <typename... TStates>
+constexpr FCharacterStateMask MakeCharacterStateMask(TStates... States)
+{
+	return static_cast<FCharacterStateMask>((0u | ... | CharacterStateBit(States)));
+}
+
+/**
+ * Illegal-transition matrix and state categories packed as bitmasks.
+ * IllegalTo[From] has a bit set for every state that cannot be entered from From,
+ * so both transition checks and category checks are a single AND.
+ */
+struct FCharacterStateTransitionTable
+{
+	FCharacterStateMask IllegalTo[NumCharacterStates] = {};
+
+	/** Normal grounded states (Idle/Walking). */
+	FCharacterStateMask NormalStates = 0;
+
+	/** Air states; if not in one of these and not grounded, the component switches to MidAir. */
+	FCharacterStateMask AirStates = 0;
+
+	/** Ground states. */
+	FCharacterStateMask GroundStates = 0;
+
+	constexpr bool IsIllegal(ECharacterState From, ECharacterState To) const
+	{
+		return (IllegalTo[static_cast<uint8>(From)] & CharacterStateBit(To)) != 0;
+	}
+
+	constexpr void SetIllegal(ECharacterState From, FCharacterStateMask ToMask)
+	{
+		IllegalTo[static_cast<uint8>(From)] = ToMask;
+	}
+
+	/** Replaces State's row and categories, e.g. from a state graph asset: every state outside LegalTo becomes illegal. */
+	constexpr void DefineState(ECharacterState State, FCharacterStateMask LegalTo, bool bNormal, bool bAir, bool bGround)
+	{
+		constexpr FCharacterStateMask AllStates = static_cast<FCharacterStateMask>((1u << NumCharacterStates) - 1);
+		const FCharacterStateMask Bit = CharacterStateBit(State);
+		SetIllegal(State, static_cast<FCharacterStateMask>(~LegalTo & AllStates));
+		NormalStates = bNormal ? static_cast<FCharacterStateMask>(NormalStates | Bit) : static_cast<FCharacterStateMask>(NormalStates & ~Bit);
+		AirStates = bAir ? static_cast<FCharacterStateMask>(AirStates | Bit) : static_cast<FCharacterStateMask>(AirStates & ~Bit);
+		GroundStates = bGround ? static_cast<FCharacterStateMask>(GroundStates | Bit) : static_cast<FCharacterStateMask>(GroundStates & ~Bit);
+	}
+
+	constexpr bool IsNormalState(ECharacterState State) const { return (NormalStates & CharacterStateBit(State)) != 0; }
+	constexpr bool IsAirState(ECharacterState State) const { return (AirStates & CharacterStateBit(State)) != 0; }
+	constexpr bool IsGroundState(ECharacterState State) const { return (GroundStates & CharacterStateBit(State)) != 0; }
+};
+
+/** NextHop value for pairs without a legal path. */
+constexpr uint8 CharacterStateNoRoute = 0xFF;
+
+/**
+ * All-pairs shortest legal paths of a transition table, for routing a request around an illegal direct edge (e.g.
+ * Sprinting -> Walking -> Crouch). NextHop[From][To] is the first state of a shortest route (To itself when the direct
+ * edge is legal, CharacterStateNoRoute when To cannot be reached) and Hops[From][To] its length. Built with one
+ * breadth-first search per state; ties go to the lowest state, so routes are deterministic.
+ */
+struct FCharacterStateRouteTable
+{
+	uint8 NextHop[NumCharacterStates][NumCharacterStates] = {};
+	uint8 Hops[NumCharacterStates][NumCharacterStates] = {};
+
+	constexpr bool HasRoute(ECharacterState From, ECharacterState To) const { return NextHop[static_cast<uint8>(From)][static_cast<uint8>(To)] != CharacterStateNoRoute; }
+	constexpr ECharacterState GetNextHop(ECharacterState From, ECharacterState To) const { return static_cast<ECharacterState>(NextHop[static_cast<uint8>(From)][static_cast<uint8>(To)]); }
+	constexpr int32 GetNumHops(ECharacterState From, ECharacterState To) const { return Hops[static_cast<uint8>(From)][static_cast<uint8>(To)]; }
+
+	static constexpr FCharacterStateRouteTable Build(const FCharacterStateTransitionTable& Table)
+	{
+		FCharacterStateRouteTable Routes;
+		for (int32 From = 0; From < NumCharacterStates; ++From)
+		{
+			for (int32 To = 0; To < NumCharacterStates; ++To)
+			{
+				Routes.NextHop[From][To] = CharacterStateNoRoute;
+			}
+
+			// Each visited state remembers the first hop taken from From to reach it.
+			uint8 Queue[NumCharacterStates] = {};
+			int32 Head = 0;
+			int32 Tail = 0;
+			Routes.NextHop[From][From] = static_cast<uint8>(From);
+			Queue[Tail++] = static_cast<uint8>(From);
+			while (Head < Tail)
+			{
+				const uint8 State = Queue[Head++];
+				for (int32 To = 0; To < NumCharacterStates; ++To)
+				{
+					if (Routes.NextHop[From][To] != CharacterStateNoRoute || (Table.IllegalTo[State] & (1u << To)) != 0)
+					{
+						continue;
+					}
+					Routes.NextHop[From][To] = State == From ? static_cast<uint8>(To) : Routes.NextHop[From][State];
+					Routes.Hops[From][To] = static_cast<uint8>(Routes.Hops[From][State] + 1);
+					Queue[Tail++] = static_cast<uint8>(To);
+				}
+			}
+		}
+		return Routes;
+	}
+};
+
+namespace CharacterStateRules
+{
+	/** Built-in rules; components start from these and may override rows from data. */
+	constexpr FCharacterStateTransitionTable MakeDefaultTable()
+	{
+		FCharacterStateTransitionTable Table;
+
+		// From Idle: cannot go to WallRun
+		Table.SetIllegal(ECharacterState::Idle, MakeCharacterStateMask(ECharacterState::WallRun));
+
+		// From Walking: cannot go to WallRun
+		Table.SetIllegal(ECharacterState::Walking, MakeCharacterStateMask(ECharacterState::WallRun));
+
+		// From Sliding: cannot go to WallRun, Crouch
+		Table.SetIllegal(ECharacterState::Sliding, MakeCharacterStateMask(ECharacterState::WallRun, ECharacterState::Crouch));
+
+		// From MidAir: cannot go to Sliding, Sprinting, Crouch
+		Table.SetIllegal(ECharacterState::MidAir, MakeCharacterStateMask(ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch));
+
+		// From WallRun: cannot go to Sliding, Sprinting, Crouch
+		Table.SetIllegal(ECharacterState::WallRun, MakeCharacterStateMask(ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch));
+
+		// From Sprinting: cannot go to WallRun, Crouch (slide instead)
+		Table.SetIllegal(ECharacterState::Sprinting, MakeCharacterStateMask(ECharacterState::WallRun, ECharacterState::Crouch));
+
+		// From Crouch: cannot go to WallRun
+		Table.SetIllegal(ECharacterState::Crouch, MakeCharacterStateMask(ECharacterState::WallRun));
+
+		// From Grapple: cannot go to Sliding, Sprinting, Crouch
+		Table.SetIllegal(ECharacterState::Grapple, MakeCharacterStateMask(ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch));
+
+		// State categories
+		Table.NormalStates = MakeCharacterStateMask(ECharacterState::Idle, ECharacterState::Walking);
+		Table.AirStates = MakeCharacterStateMask(ECharacterState::MidAir, ECharacterState::WallRun, ECharacterState::Grapple);
+		Table.GroundStates = MakeCharacterStateMask(ECharacterState::Idle, ECharacterState::Walking, ECharacterState::Sliding, ECharacterState::Sprinting, ECharacterState::Crouch);
+
+		return Table;
+	}
+
+	/** True if SwitchToNormalState() can always land from every air state. */
+	constexpr bool CanLandFromAllAirStates(const FCharacterStateTransitionTable& Table)
+	{
+		for (int32 From = 0; From < NumCharacterStates; ++From)
+		{
+			if ((Table.AirStates & (1u << From)) && (Table.IllegalTo[From] & Table.NormalStates))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	inline constexpr FCharacterStateTransitionTable Default = MakeDefaultTable();
+
+	static_assert(CanLandFromAllAirStates(Default), "Landing (air -> Idle/Walking) must be legal from every air state.");
+	static_assert(!Default.IsIllegal(ECharacterState::Idle, ECharacterState::MidAir), "Walking off a ledge must be able to enter MidAir.");
+	static_assert((Default.AirStates & Default.GroundStates) == 0, "A state cannot be both an air and a ground state.");
+	static_assert((Default.NormalStates & ~Default.GroundStates) == 0, "Normal states must also be ground states.");
+
+	inline constexpr FCharacterStateRouteTable DefaultRoutes = FCharacterStateRouteTable::Build(Default);
+
+	static_assert(DefaultRoutes.GetNumHops(ECharacterState::Sprinting, ECharacterState::Crouch) == 2, "Sprinting reaches Crouch through one intermediate state.");
+	static_assert(DefaultRoutes.GetNumHops(ECharacterState::MidAir, ECharacterState::Sliding) == 2, "MidAir reaches Sliding by landing first.");
+	static_assert(DefaultRoutes.GetNextHop(ECharacterState::MidAir, ECharacterState::Sliding) == ECharacterState::Idle, "Routes prefer the lowest intermediate state.");
+}
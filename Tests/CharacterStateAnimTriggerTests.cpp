@@ -0,0 +1,65 @@
+
+#include "CharacterStateManagement/CharacterStateAnimTriggers.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	/** Runs FCharacterStateAnimTriggerBuffer's flush step for one trigger; returns 1 for a set, 0 for a reset, -1 for nothing. */
+	int32 Flush(FCharacterStateAnimTriggerValue& Value)
+	{
+		bool bValue = false;
+		return Value.Take(bValue) ? (bValue ? 1 : 0) : -1;
+	}
+}
+
+TEST(CharacterStateAnimTriggers, FirstValueIsAlwaysDispatched)
+{
+	FCharacterStateAnimTriggerValue Value;
+	EXPECT_EQ(Flush(Value), -1);
+	Value.Queue(false);
+	EXPECT_EQ(Flush(Value), 0);
+	EXPECT_EQ(Flush(Value), -1);
+}
+
+TEST(CharacterStateAnimTriggers, SetAndResetInOneFrameCancelOut)
+{
+	// Idle -> Walking -> Idle in one frame: Walking's trigger is set on Enter and reset on Exit.
+	FCharacterStateAnimTriggerValue Value;
+	Value.Queue(false);
+	ASSERT_EQ(Flush(Value), 0);
+
+	Value.Queue(true);
+	Value.Queue(false);
+	EXPECT_EQ(Flush(Value), -1);
+
+	// The same pair the other way round, from a set trigger.
+	Value.Queue(true);
+	ASSERT_EQ(Flush(Value), 1);
+	Value.Queue(false);
+	Value.Queue(true);
+	EXPECT_EQ(Flush(Value), -1);
+}
+
+TEST(CharacterStateAnimTriggers, LastValueWins)
+{
+	FCharacterStateAnimTriggerValue Value;
+	Value.Queue(false);
+	ASSERT_EQ(Flush(Value), 0);
+
+	Value.Queue(true);
+	Value.Queue(false);
+	Value.Queue(true);
+	EXPECT_EQ(Flush(Value), 1);
+	EXPECT_EQ(Flush(Value), -1);
+}
+
+TEST(CharacterStateAnimTriggers, ForgetDispatchesAgain)
+{
+	// A new AnimInstance holds its own defaults, so the value already applied to the old one is sent again.
+	FCharacterStateAnimTriggerValue Value;
+	Value.Queue(true);
+	ASSERT_EQ(Flush(Value), 1);
+	Value.Forget();
+	Value.Queue(true);
+	EXPECT_EQ(Flush(Value), 1);
+}
@@ -0,0 +1,111 @@
+
+#include "CharacterStateManagement/CharacterStateCapsule.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	constexpr float FrameTime = 1.f / 60.f;
+
+	/** A capsule driven the way UCharacterStateManagerComponent drives its own, with the overlap queries counted. */
+	struct FTestCapsule
+	{
+		FTestCapsule()
+		{
+			Update.Reset(HalfHeight);
+		}
+
+		void Request(float NewHalfHeight, bool bUpdateOverlaps = true)
+		{
+			bool bResizeNow = false;
+			NumQueued += Update.Request(HalfHeight, NewHalfHeight, bUpdateOverlaps, InterpSpeed, bResizeNow) ? 1 : 0;
+			if (bResizeNow)
+			{
+				HalfHeight = NewHalfHeight;
+			}
+		}
+
+		/** The subsystem's pass: returns true while the capsule is still moving. */
+		bool Flush()
+		{
+			bool bRefreshOverlaps = false;
+			const bool bStillMoving = Update.Step(HalfHeight, FrameTime, InterpSpeed, bRefreshOverlaps);
+			NumOverlapUpdates += bRefreshOverlaps ? 1 : 0;
+			return bStillMoving;
+		}
+
+		FCharacterStateCapsuleUpdate Update;
+		float HalfHeight = 88.f;
+		float InterpSpeed = 0.f;
+		int32 NumQueued = 0;
+		int32 NumOverlapUpdates = 0;
+	};
+}
+
+TEST(CharacterStateCapsuleUpdate, RequestForCurrentHeightIsDropped)
+{
+	FTestCapsule Capsule;
+	Capsule.Request(88.f);
+	EXPECT_FALSE(Capsule.Update.bPending);
+	EXPECT_EQ(Capsule.NumQueued, 0);
+}
+
+TEST(CharacterStateCapsuleUpdate, ResizesAtOnceAndRefreshesOverlapsInTheFlush)
+{
+	FTestCapsule Capsule;
+	Capsule.Request(44.f);
+	EXPECT_EQ(Capsule.HalfHeight, 44.f);
+	EXPECT_EQ(Capsule.NumOverlapUpdates, 0);
+
+	// Further requests before the flush do not queue the capsule again.
+	Capsule.Request(50.f);
+	EXPECT_EQ(Capsule.NumQueued, 1);
+
+	EXPECT_FALSE(Capsule.Flush());
+	EXPECT_EQ(Capsule.HalfHeight, 50.f);
+	EXPECT_EQ(Capsule.NumOverlapUpdates, 1);
+	EXPECT_FALSE(Capsule.Update.bPending);
+}
+
+TEST(CharacterStateCapsuleUpdate, CrouchAndStandInOneFrameSkipsTheQuery)
+{
+	FTestCapsule Capsule;
+	Capsule.Request(44.f);
+	Capsule.Request(88.f);
+	EXPECT_FALSE(Capsule.Flush());
+	EXPECT_EQ(Capsule.HalfHeight, 88.f);
+	EXPECT_EQ(Capsule.NumOverlapUpdates, 0);
+}
+
+TEST(CharacterStateCapsuleUpdate, OverlapsOnlyWhenAsked)
+{
+	FTestCapsule Capsule;
+	Capsule.Request(44.f, false);
+	EXPECT_FALSE(Capsule.Flush());
+	EXPECT_EQ(Capsule.NumOverlapUpdates, 0);
+
+	// The refresh compares against the last refreshed height, not the last flushed one.
+	Capsule.Request(60.f, false);
+	Capsule.Request(60.f, true);
+	EXPECT_FALSE(Capsule.Flush());
+	EXPECT_EQ(Capsule.NumOverlapUpdates, 1);
+}
+
+TEST(CharacterStateCapsuleUpdate, InterpolatesThenRefreshesOnce)
+{
+	FTestCapsule Capsule;
+	Capsule.InterpSpeed = 600.f;
+	Capsule.Request(44.f);
+	EXPECT_EQ(Capsule.HalfHeight, 88.f);
+
+	// 44 units at 10 units per frame: four steps on the way, the fifth arrives.
+	int32 NumSteps = 0;
+	while (Capsule.Flush())
+	{
+		++NumSteps;
+		EXPECT_GT(Capsule.HalfHeight, 44.f);
+		ASSERT_LT(NumSteps, 10);
+	}
+	EXPECT_EQ(NumSteps, 4);
+	EXPECT_EQ(Capsule.HalfHeight, 44.f);
+	EXPECT_EQ(Capsule.NumOverlapUpdates, 1);
+}
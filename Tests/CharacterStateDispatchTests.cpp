@@ -0,0 +1,134 @@
+
+#include "Tests/CharacterStateTestEnvironment.h"
+#include "CharacterStateManagement/CharacterStateDispatch.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace
+{
+	constexpr float FrameTime = 1.f / 60.f;
+
+	/** Settings with hysteresis, dwell times, a cooldown and timeouts, so both machines exercise every timed rule. */
+	FCharacterStateMachineSettings MakeTimedSettings()
+	{
+		FCharacterStateMachineSettings Settings;
+		Settings.DefaultCapsuleHalfHeight = 88.f;
+		Settings.SprintingHysteresis = 40.f;
+		Settings.MinDwellTime[static_cast<uint8>(ECharacterState::Walking)] = 0.1f;
+		Settings.MinDwellTime[static_cast<uint8>(ECharacterState::Sprinting)] = 0.2f;
+		Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.4f;
+		Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::WallRun)] = 0.7f;
+		Settings.Cooldown[static_cast<uint8>(ECharacterState::Crouch)] = 0.5f;
+		return Settings;
+	}
+
+	/** Runs the same random inputs through both machines and expects the same state after every call. */
+	void CheckSameAsDynamic(bool bQueueTransitions)
+	{
+		const FCharacterStateMachineSettings Settings = MakeTimedSettings();
+		FTestCharacterEnvironment StaticEnvironment;
+		TCharacterStateMachine<> Static(StaticEnvironment);
+		Static.Start(CharacterStateRules::Default, Settings);
+		Static.SetQueueTransitions(bQueueTransitions);
+		FTestCharacter Dynamic(Settings);
+		Dynamic.Machine.SetQueueTransitions(bQueueTransitions);
+
+		// Inputs hold for a while, so timed states can run out.
+		std::mt19937 Random(7);
+		bool bGrounded = true;
+		double Speed = 0.0;
+		for (int32 Frame = 0; Frame < 5000; ++Frame)
+		{
+			if (Random() % 40 == 0)
+			{
+				bGrounded = !bGrounded;
+			}
+			if (Random() % 30 == 0)
+			{
+				Speed = static_cast<double>(Random() % 900);
+			}
+			StaticEnvironment.bGrounded = Dynamic.Environment.bGrounded = bGrounded;
+			StaticEnvironment.SetSpeed(Speed);
+			Dynamic.Environment.SetSpeed(Speed);
+
+			if (Random() % 20 == 0)
+			{
+				const ECharacterState Request = static_cast<ECharacterState>(Random() % NumCharacterStates);
+				EXPECT_EQ(Static.SwitchStateByEnum(Request), Dynamic.Machine.SwitchStateByEnum(Request)) << "frame " << Frame;
+			}
+			Static.Tick(FrameTime);
+			Dynamic.Machine.Tick(FrameTime);
+			ASSERT_EQ(Static.GetCurrentStateEnum(), Dynamic.GetState()) << "frame " << Frame;
+		}
+		EXPECT_EQ(Static.GetNumSuppressedTransitions(), Dynamic.Machine.GetNumSuppressedTransitions());
+		EXPECT_EQ(Static.GetNumTimeouts(), Dynamic.Machine.GetNumTimeouts());
+		EXPECT_GT(Static.GetNumTimeouts(), 0u);
+		EXPECT_EQ(StaticEnvironment.NumStateChanges, Dynamic.Environment.NumStateChanges);
+		EXPECT_EQ(StaticEnvironment.CapsuleHalfHeight, Dynamic.Environment.CapsuleHalfHeight);
+	}
+}
+
+TEST(TCharacterStateList, TickingMask)
+{
+	EXPECT_TRUE(FDefaultCharacterStateList::HasTick(ECharacterState::MidAir));
+	EXPECT_TRUE(FDefaultCharacterStateList::HasTick(ECharacterState::Sprinting));
+	EXPECT_FALSE(FDefaultCharacterStateList::HasTick(ECharacterState::Idle));
+	EXPECT_FALSE(FDefaultCharacterStateList::HasTick(ECharacterState::Crouch));
+	EXPECT_EQ(FDefaultCharacterStateList::StateMask, static_cast<FCharacterStateMask>((1u << NumCharacterStates) - 1u));
+}
+
+TEST(TCharacterStateMachine, RefusesStatesOutsideItsList)
+{
+	using FGroundList = TCharacterStateList<CharacterStateLogic::FIdle, CharacterStateLogic::FWalking, CharacterStateLogic::FCrouch>;
+	FTestCharacterEnvironment Environment;
+	TCharacterStateMachine<FGroundList> Machine(Environment);
+	Machine.Start(CharacterStateRules::Default, FCharacterStateMachineSettings());
+
+	EXPECT_FALSE(Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+	EXPECT_TRUE(Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	EXPECT_EQ(Machine.GetCurrentStateEnum(), ECharacterState::Crouch);
+	EXPECT_EQ(Environment.NumStateChanges, 1);
+}
+
+TEST(TCharacterStateMachine, CooldownRefusesReentry)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.Cooldown[static_cast<uint8>(ECharacterState::Crouch)] = 1.f;
+	FTestCharacterEnvironment Environment;
+	TCharacterStateMachine<> Machine(Environment);
+	Machine.Start(CharacterStateRules::Default, Settings);
+
+	ASSERT_TRUE(Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	ASSERT_TRUE(Machine.SwitchStateByEnum(ECharacterState::Idle));
+	EXPECT_FALSE(Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	Machine.AdvanceStateTime(1.f);
+	EXPECT_TRUE(Machine.SwitchStateByEnum(ECharacterState::Crouch));
+}
+
+TEST(TCharacterStateMachine, TimeoutLeavesState)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.5f;
+	FTestCharacterEnvironment Environment;
+	TCharacterStateMachine<> Machine(Environment);
+	Machine.Start(CharacterStateRules::Default, Settings);
+	Environment.SetSpeed(300.0);
+
+	ASSERT_TRUE(Machine.SwitchStateByEnum(ECharacterState::Sliding));
+	EXPECT_TRUE(Machine.HasStateTimeout());
+	Machine.Tick(0.4f);
+	EXPECT_EQ(Machine.GetCurrentStateEnum(), ECharacterState::Sliding);
+	Machine.Tick(0.11f);
+	EXPECT_EQ(Machine.GetCurrentStateEnum(), ECharacterState::Walking);
+	EXPECT_EQ(Machine.GetNumTimeouts(), 1u);
+}
+
+TEST(TCharacterStateMachine, MatchesDynamicMachine)
+{
+	CheckSameAsDynamic(false);
+}
+
+TEST(TCharacterStateMachine, MatchesDynamicMachineQueued)
+{
+	CheckSameAsDynamic(true);
+}
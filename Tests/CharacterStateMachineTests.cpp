@@ -0,0 +1,887 @@
+
+#include "Tests/CharacterStateTestEnvironment.h"
+#include "CharacterStateManagement/CharacterBaseState.h"
+#include "CharacterStateManagement/CharacterStateBatch.h"
+#include "CharacterStateManagement/CharacterStateRecording.h"
+#include "CharacterStateManagement/CharacterStateRequestQueue.h"
+#include "CharacterStateManagement/CharacterStateSnapshot.h"
+#include "CharacterStateManagement/CharacterStateStats.h"
+#include "CharacterStateManagement/CharacterStateTrace.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr float FrameTime = 1.f / 60.f;
+
+	/** Registered state that counts its hooks. */
+	class FCountingState final : public FCharacterBaseState
+	{
+	public:
+		FCountingState(FCharacterStateMachine* InOwner, ECharacterState InState)
+			: FCharacterBaseState(InOwner, InState)
+		{
+		}
+
+		virtual void Enter() override { ++NumEnters; }
+		virtual void Tick(float) override { ++NumTicks; }
+		virtual void Exit() override { ++NumExits; }
+
+		int32 NumEnters = 0;
+		int32 NumTicks = 0;
+		int32 NumExits = 0;
+	};
+}
+
+// ---- Transition table ----
+TEST(CharacterStateTransitionTable, DefaultRules)
+{
+	const FCharacterStateTransitionTable& Table = CharacterStateRules::Default;
+	EXPECT_TRUE(Table.IsIllegal(ECharacterState::Idle, ECharacterState::WallRun));
+	EXPECT_TRUE(Table.IsIllegal(ECharacterState::Sprinting, ECharacterState::Crouch));
+	EXPECT_TRUE(Table.IsIllegal(ECharacterState::MidAir, ECharacterState::Sliding));
+	EXPECT_FALSE(Table.IsIllegal(ECharacterState::Walking, ECharacterState::Crouch));
+	EXPECT_FALSE(Table.IsIllegal(ECharacterState::MidAir, ECharacterState::WallRun));
+	EXPECT_TRUE(Table.IsAirState(ECharacterState::Grapple));
+	EXPECT_TRUE(Table.IsNormalState(ECharacterState::Walking));
+}
+
+TEST(CharacterStateTransitionTable, DefaultRulesMatchEveryCell)
+{
+	// The illegal-transition sets the TMap/TSet rules used to build in SetupIllegalTransitions(), one row per source state.
+	using S = ECharacterState;
+	const std::vector<S> Illegal[NumCharacterStates] =
+	{
+		/* Idle */ { S::WallRun },
+		/* Walking */ { S::WallRun },
+		/* Sliding */ { S::WallRun, S::Crouch },
+		/* MidAir */ { S::Sliding, S::Sprinting, S::Crouch },
+		/* WallRun */ { S::Sliding, S::Sprinting, S::Crouch },
+		/* Sprinting */ { S::WallRun, S::Crouch },
+		/* Crouch */ { S::WallRun },
+		/* Grapple */ { S::Sliding, S::Sprinting, S::Crouch },
+	};
+
+	const FCharacterStateTransitionTable& Table = CharacterStateRules::Default;
+	for (int32 From = 0; From < NumCharacterStates; ++From)
+	{
+		for (int32 To = 0; To < NumCharacterStates; ++To)
+		{
+			const S FromState = static_cast<S>(From);
+			const S ToState = static_cast<S>(To);
+			bool bWasIllegal = false;
+			for (S IllegalState : Illegal[From])
+			{
+				bWasIllegal |= IllegalState == ToState;
+			}
+			EXPECT_EQ(Table.IsIllegal(FromState, ToState), bWasIllegal) << GetCharacterStateName(FromState) << " -> " << GetCharacterStateName(ToState);
+		}
+	}
+}
+
+TEST(CharacterStateTransitionTable, DefineStateReplacesRowAndCategories)
+{
+	// What a graph asset compiles for a character that can wall-run straight from Idle and treats Crouch as airborne.
+	FCharacterStateTransitionTable Table = CharacterStateRules::Default;
+	Table.DefineState(ECharacterState::Idle, MakeCharacterStateMask(ECharacterState::Walking, ECharacterState::WallRun), true, false, true);
+	Table.DefineState(ECharacterState::Crouch, MakeCharacterStateMask(ECharacterState::Idle, ECharacterState::Walking), false, true, false);
+
+	EXPECT_FALSE(Table.IsIllegal(ECharacterState::Idle, ECharacterState::WallRun));
+	EXPECT_TRUE(Table.IsIllegal(ECharacterState::Idle, ECharacterState::Crouch));
+	EXPECT_TRUE(Table.IsIllegal(ECharacterState::Crouch, ECharacterState::Sprinting));
+	EXPECT_TRUE(Table.IsAirState(ECharacterState::Crouch));
+	EXPECT_FALSE(Table.IsGroundState(ECharacterState::Crouch));
+	EXPECT_TRUE(CharacterStateRules::CanLandFromAllAirStates(Table));
+
+	// An air state that cannot land in every normal state is what Compile() warns about.
+	Table.DefineState(ECharacterState::Grapple, MakeCharacterStateMask(ECharacterState::MidAir, ECharacterState::Idle), false, true, false);
+	EXPECT_FALSE(CharacterStateRules::CanLandFromAllAirStates(Table));
+}
+
+TEST(CharacterStateTransitionTable, MachineStartsFromCompiledTable)
+{
+	FCharacterStateTransitionTable Table = CharacterStateRules::Default;
+	Table.DefineState(ECharacterState::Idle, MakeCharacterStateMask(ECharacterState::Walking, ECharacterState::WallRun), true, false, true);
+
+	FTestCharacterEnvironment Environment;
+	FCharacterStateMachine Machine(Environment);
+	Machine.Start(Table, FCharacterStateMachineSettings());
+	EXPECT_FALSE(Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	EXPECT_TRUE(Machine.SwitchStateByEnum(ECharacterState::WallRun));
+}
+
+TEST(CharacterStateTransitionTable, Routes)
+{
+	const FCharacterStateRouteTable& Routes = CharacterStateRules::DefaultRoutes;
+	EXPECT_EQ(Routes.GetNumHops(ECharacterState::Idle, ECharacterState::Idle), 0);
+	EXPECT_EQ(Routes.GetNumHops(ECharacterState::Idle, ECharacterState::Crouch), 1);
+	EXPECT_EQ(Routes.GetNumHops(ECharacterState::Sprinting, ECharacterState::Crouch), 2);
+	EXPECT_EQ(Routes.GetNextHop(ECharacterState::MidAir, ECharacterState::Sliding), ECharacterState::Idle);
+}
+
+// ---- Switching ----
+TEST(CharacterStateMachine, StartsInIdle)
+{
+	FTestCharacter Character;
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+	EXPECT_FALSE(Character.Machine.NeedsTick());
+}
+
+TEST(CharacterStateMachine, RefusesIllegalAndRepeatedSwitches)
+{
+	FTestCharacter Character;
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::Idle));
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::WallRun));
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+	EXPECT_EQ(Character.Environment.NumStateChanges, 0);
+
+	EXPECT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sprinting);
+	EXPECT_EQ(Character.Environment.NumStateChanges, 1);
+}
+
+TEST(CharacterStateMachine, RegisteredStateEnterTickExit)
+{
+	FTestCharacter Character;
+	FCountingState* Crouch = new FCountingState(&Character.Machine, ECharacterState::Crouch);
+	Character.Machine.RegisterState(Crouch);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	EXPECT_EQ(Crouch->NumEnters, 1);
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+
+	Character.Machine.Tick(FrameTime);
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Crouch->NumTicks, 2);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Idle));
+	EXPECT_EQ(Crouch->NumExits, 1);
+	EXPECT_EQ(Crouch->NumEnters, 1);
+}
+
+TEST(CharacterStateMachine, CrouchSetsAndRestoresCapsule)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.DefaultCapsuleHalfHeight = 88.f;
+	FTestCharacter Character(Settings);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	EXPECT_EQ(Character.Environment.CapsuleHalfHeight, Settings.CrouchCapsuleHalfHeight);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_EQ(Character.Environment.CapsuleHalfHeight, 88.f);
+}
+
+TEST(CharacterStateMachine, AuthorityIgnoresTable)
+{
+	FTestCharacter Character;
+	EXPECT_TRUE(Character.Machine.SetStateFromAuthority(ECharacterState::WallRun));
+	EXPECT_EQ(Character.GetState(), ECharacterState::WallRun);
+	EXPECT_EQ(Character.Environment.NumStateChanges, 1);
+	EXPECT_FALSE(Character.Machine.SetStateFromAuthority(ECharacterState::WallRun));
+}
+
+TEST(CharacterStateMachine, RestartDeletesOnlyRegisteredStates)
+{
+	class FTrackedState final : public FCharacterBaseState
+	{
+	public:
+		FTrackedState(FCharacterStateMachine* InOwner, bool& bInDestroyed)
+			: FCharacterBaseState(InOwner, ECharacterState::Crouch)
+			, bDestroyed(bInDestroyed)
+		{
+		}
+
+		virtual ~FTrackedState() override { bDestroyed = true; }
+
+		bool& bDestroyed;
+	};
+
+	FTestCharacter Character;
+	const FCharacterBaseState* BuiltinWalking = Character.Machine.FindState(ECharacterState::Walking);
+	ASSERT_NE(BuiltinWalking, nullptr);
+	EXPECT_EQ(BuiltinWalking->GetState(), ECharacterState::Walking);
+
+	bool bDestroyed = false;
+	Character.Machine.RegisterState(new FTrackedState(&Character.Machine, bDestroyed));
+	Character.Machine.Stop();
+	EXPECT_TRUE(bDestroyed);
+
+	// Built-in handles survive a restart and are shared by every machine.
+	Character.Machine.Start(CharacterStateRules::Default, FCharacterStateMachineSettings());
+	FTestCharacter Other;
+	EXPECT_EQ(Character.Machine.FindState(ECharacterState::Walking), BuiltinWalking);
+	EXPECT_EQ(Other.Machine.FindState(ECharacterState::Crouch), Character.Machine.FindState(ECharacterState::Crouch));
+}
+
+// ---- Tick ----
+TEST(CharacterStateMachine, ForcedMidAirAndLanding)
+{
+	FTestCharacter Character;
+	Character.Environment.bGrounded = false;
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::MidAir);
+
+	// Airborne MidAir waits for the movement mode to change.
+	EXPECT_FALSE(Character.Machine.NeedsTick());
+
+	Character.Environment.bGrounded = true;
+	Character.Environment.SetSpeed(300.0);
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+	EXPECT_FALSE(Character.Machine.NeedsTick());
+}
+
+TEST(CharacterStateMachine, OnlyPerFrameStatesNeedTick)
+{
+	FTestCharacter Character;
+	Character.Environment.SetSpeed(800.0);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+
+	const ECharacterState Sleeping[] = { ECharacterState::Walking, ECharacterState::Crouch, ECharacterState::Sliding };
+	for (ECharacterState State : Sleeping)
+	{
+		ASSERT_TRUE(Character.Machine.SwitchStateByEnum(State));
+		EXPECT_FALSE(Character.Machine.NeedsTick()) << GetCharacterStateName(State);
+	}
+}
+
+TEST(CharacterStateMachine, SprintDropsOutBelowMinSpeed)
+{
+	FTestCharacter Character;
+	Character.Environment.SetSpeed(800.0);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sprinting);
+
+	Character.Environment.SetSpeed(300.0);
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+}
+
+TEST(CharacterStateMachine, HysteresisAndDwellHoldSprint)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.SprintingHysteresis = 50.f;
+	Settings.MinDwellTime[static_cast<uint8>(ECharacterState::Sprinting)] = 0.5f;
+	FTestCharacter Character(Settings);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+	Character.Environment.SetSpeed(580.0);
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sprinting);
+
+	Character.Environment.SetSpeed(300.0);
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sprinting);
+	EXPECT_EQ(Character.Machine.GetNumSuppressedTransitions(), 2u);
+
+	Character.Machine.Tick(0.5f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+}
+
+TEST(CharacterStateMachine, NormalStateBand)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.NormalStateWalkHysteresis = 5.f;
+	FTestCharacter Character(Settings);
+
+	// Threshold 10 with a 5 band: Idle needs 15 to start walking, Walking drops back to Idle below 5.
+	Character.Environment.SetSpeed(12.0);
+	Character.Machine.SwitchToNormalState();
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+	EXPECT_EQ(Character.Environment.NumStateChanges, 0);
+
+	Character.Environment.SetSpeed(15.0);
+	Character.Machine.SwitchToNormalState();
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+
+	Character.Environment.SetSpeed(6.0);
+	Character.Machine.SwitchToNormalState();
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+	Character.Environment.SetSpeed(4.0);
+	Character.Machine.SwitchToNormalState();
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+}
+
+TEST(CharacterStateMachine, EvaluateTransitionMatchesTick)
+{
+	const FCharacterStateMachineSettings Settings;
+	const ECharacterState States[] = { ECharacterState::Idle, ECharacterState::Walking, ECharacterState::MidAir, ECharacterState::Sprinting };
+	const double Speeds[] = { 0.0, 300.0, 900.0 };
+	for (ECharacterState State : States)
+	{
+		for (bool bGrounded : { false, true })
+		{
+			for (double Speed : Speeds)
+			{
+				FTestCharacter Character(Settings);
+				if (State != ECharacterState::Idle)
+				{
+					ASSERT_TRUE(Character.Machine.SwitchStateByEnum(State));
+				}
+				Character.Environment.bGrounded = bGrounded;
+				Character.Environment.SetSpeed(Speed);
+
+				bool bSuppressed = false;
+				const ECharacterState Expected = FCharacterStateMachine::EvaluateTransition(State, bGrounded, static_cast<float>(Speed * Speed),
+					FrameTime, CharacterStateRules::Default, Settings, bSuppressed);
+				Character.Machine.Tick(FrameTime);
+				EXPECT_EQ(Character.GetState(), Expected) << "state " << static_cast<int32>(State) << " grounded " << bGrounded << " speed " << Speed;
+			}
+		}
+	}
+}
+
+TEST(CharacterStateMachine, BatchedPassMatchesTick)
+{
+	// The subsystem's batched pass advances the clock, decides from the sampled inputs and applies the switch; over a run of
+	// scripted inputs it must leave every character where its own Tick() would.
+	FCharacterStateMachineSettings Settings;
+	Settings.SprintingHysteresis = 40.f;
+	Settings.MinDwellTime[static_cast<uint8>(ECharacterState::Walking)] = 0.1f;
+	Settings.MinDwellTime[static_cast<uint8>(ECharacterState::Sprinting)] = 0.2f;
+
+	constexpr int32 NumCharacters = 16;
+	std::vector<std::unique_ptr<FTestCharacter>> Batched;
+	std::vector<std::unique_ptr<FTestCharacter>> Ticked;
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		Batched.push_back(std::make_unique<FTestCharacter>(Settings));
+		Ticked.push_back(std::make_unique<FTestCharacter>(Settings));
+	}
+	for (int32 Frame = 0; Frame < 600; ++Frame)
+	{
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			const int32 Phase = Frame + Index * 7;
+			for (FTestCharacter* Character : { Batched[Index].get(), Ticked[Index].get() })
+			{
+				Character->Environment.bGrounded = Phase % 40 >= 6;
+				Character->Environment.SetSpeed(Phase % 24 < 12 ? 750.0 : 250.0 + Index * 20.0);
+				if (Phase % 13 == 0)
+				{
+					Character->Machine.SwitchStateByEnum(ECharacterState::Sprinting);
+				}
+			}
+
+			FCharacterStateMachine& Machine = Batched[Index]->Machine;
+			Machine.AdvanceStateTime(FrameTime);
+			bool bSuppressed = false;
+			const FCharacterStateVector Velocity = Batched[Index]->Environment.GetLinearVelocity();
+			const ECharacterState Target = FCharacterStateMachine::EvaluateTransition(Machine.GetCurrentStateEnum(), Batched[Index]->Environment.IsGrounded(),
+				static_cast<float>(Velocity.SizeSquared2D()), Machine.GetTimeInState(), CharacterStateRules::Default, Settings, bSuppressed);
+			if (Target != Machine.GetCurrentStateEnum())
+			{
+				Machine.SwitchStateByEnum(Target);
+			}
+
+			Ticked[Index]->Machine.Tick(FrameTime);
+			ASSERT_EQ(Batched[Index]->GetState(), Ticked[Index]->GetState()) << "character " << Index << " frame " << Frame;
+		}
+	}
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		EXPECT_EQ(Batched[Index]->Environment.NumStateChanges, Ticked[Index]->Environment.NumStateChanges) << "character " << Index;
+		EXPECT_GT(Ticked[Index]->Environment.NumStateChanges, 0) << "character " << Index;
+	}
+}
+
+TEST(CharacterStateMachine, TickSamplesMovementOnce)
+{
+	/** Reads the movement helpers several times per frame and slows the character down. */
+	class FBrakingState final : public FCharacterBaseState
+	{
+	public:
+		explicit FBrakingState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::Sliding)
+		{
+		}
+
+		virtual void Tick(float) override
+		{
+			for (int32 Read = 0; Read < 3; ++Read)
+			{
+				bAllGrounded &= StateManager->IsGrounded();
+				SpeedSquaredBefore = StateManager->GetHorizontalSpeedSquared();
+			}
+			FCharacterStateVector Velocity = StateManager->GetLinearVelocity();
+			Velocity.X *= 0.5;
+			Velocity.Y *= 0.5;
+			StateManager->SetLinearVelocity(Velocity);
+			SpeedSquaredAfter = StateManager->GetHorizontalSpeedSquared();
+		}
+
+		bool bAllGrounded = true;
+		float SpeedSquaredBefore = 0.f;
+		float SpeedSquaredAfter = 0.f;
+	};
+
+	FTestCharacter Character;
+	FBrakingState* Sliding = new FBrakingState(&Character.Machine);
+	Character.Machine.RegisterState(Sliding);
+	Character.Environment.SetSpeed(400.0);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sliding));
+
+	Character.Environment.NumGroundedQueries = 0;
+	Character.Environment.NumVelocityQueries = 0;
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.Environment.NumGroundedQueries, 1);
+	EXPECT_EQ(Character.Environment.NumVelocityQueries, 1);
+	EXPECT_TRUE(Sliding->bAllGrounded);
+	EXPECT_EQ(Sliding->SpeedSquaredBefore, 400.f * 400.f);
+
+	// SetLinearVelocity() keeps the snapshot in sync; outside Tick() the helpers query the environment.
+	EXPECT_EQ(Sliding->SpeedSquaredAfter, 200.f * 200.f);
+	Character.Environment.SetSpeed(100.0);
+	EXPECT_EQ(Character.Machine.GetHorizontalSpeedSquared(), 100.f * 100.f);
+}
+
+// ---- Queued mode ----
+TEST(CharacterStateRequestQueue, MergesAndDisplacesLowestPriority)
+{
+	FCharacterStateRequestQueue Queue;
+	EXPECT_EQ(Queue.Push(ECharacterState::Crouch, ECharacterStateRequestPriority::Normal), 0);
+	EXPECT_EQ(Queue.Push(ECharacterState::MidAir, ECharacterStateRequestPriority::Forced), 0);
+	EXPECT_EQ(Queue.Push(ECharacterState::Crouch, ECharacterStateRequestPriority::Normal), 1);
+	EXPECT_EQ(Queue.GetNum(), 2);
+	EXPECT_EQ(Queue.Push(ECharacterState::Walking, ECharacterStateRequestPriority::Normal), 0);
+	EXPECT_EQ(Queue.Push(ECharacterState::Sprinting, ECharacterStateRequestPriority::Normal), 0);
+
+	// Full: the oldest Normal request, Crouch, makes room. Drain() lists Forced first, then newest first.
+	EXPECT_EQ(Queue.Push(ECharacterState::Sliding, ECharacterStateRequestPriority::Normal), 1);
+	FCharacterStateRequest Requests[FCharacterStateRequestQueue::Capacity];
+	ASSERT_EQ(Queue.Drain(Requests), FCharacterStateRequestQueue::Capacity);
+	EXPECT_EQ(Requests[0].Target, ECharacterState::MidAir);
+	EXPECT_EQ(Requests[1].Target, ECharacterState::Sliding);
+	EXPECT_EQ(Requests[2].Target, ECharacterState::Sprinting);
+	EXPECT_EQ(Requests[3].Target, ECharacterState::Walking);
+	EXPECT_TRUE(Queue.IsEmpty());
+}
+
+TEST(CharacterStateMachine, QueuedRequestsCoalesce)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.DefaultCapsuleHalfHeight = 88.f;
+	FTestCharacter Character(Settings);
+	Character.Machine.SetQueueTransitions(true);
+
+	EXPECT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	EXPECT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+	EXPECT_EQ(Character.Environment.NumCapsuleUpdates, 0);
+	EXPECT_EQ(Character.Environment.NumStateChanges, 1);
+	EXPECT_EQ(Character.Machine.GetNumCoalescedTransitions(), 1u);
+}
+
+TEST(CharacterStateMachine, ForcedRequestOutranksNewer)
+{
+	FTestCharacter Character;
+	Character.Machine.SetQueueTransitions(true);
+	Character.Environment.bGrounded = false;
+	Character.Machine.RequestState(ECharacterState::Walking);
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::MidAir);
+}
+
+// ---- Routes ----
+TEST(CharacterStateMachine, RouteHopsOncePerTick)
+{
+	FTestCharacter Character;
+	Character.Environment.SetSpeed(800.0);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+
+	ASSERT_TRUE(Character.Machine.RequestStateVia(ECharacterState::Crouch));
+	EXPECT_NE(Character.GetState(), ECharacterState::Crouch);
+	EXPECT_TRUE(Character.Machine.HasRoute());
+
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Crouch);
+	EXPECT_FALSE(Character.Machine.HasRoute());
+	EXPECT_EQ(Character.Machine.GetNumRouteHops(), 2u);
+}
+
+TEST(CharacterStateMachine, ImmediateRoute)
+{
+	FTestCharacter Character;
+	Character.Machine.SetStateFromAuthority(ECharacterState::MidAir);
+	EXPECT_TRUE(Character.Machine.RequestStateVia(ECharacterState::Sliding, true));
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sliding);
+	EXPECT_EQ(Character.Environment.NumStateChanges, 3);
+}
+
+// ---- Rule sets ----
+TEST(CharacterStateRuleSet, InternedByContent)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.SprintingMinSpeed = 612.f;
+	const int32 NumBefore = FCharacterStateRuleSet::GetNumInterned();
+	{
+		FTestCharacter First(Settings);
+		FTestCharacter Second(Settings);
+		EXPECT_EQ(&First.Machine.GetRuleSet(), &Second.Machine.GetRuleSet());
+		EXPECT_EQ(First.Machine.GetRuleSet().GetRefCount(), 2u);
+		EXPECT_EQ(FCharacterStateRuleSet::GetNumInterned(), NumBefore + 1);
+
+		Settings.SprintingMinSpeed = 613.f;
+		FTestCharacter Third(Settings);
+		EXPECT_NE(&First.Machine.GetRuleSet(), &Third.Machine.GetRuleSet());
+		EXPECT_EQ(FCharacterStateRuleSet::GetNumInterned(), NumBefore + 2);
+	}
+	EXPECT_EQ(FCharacterStateRuleSet::GetNumInterned(), NumBefore);
+}
+
+TEST(CharacterStateRuleSet, ConcurrentInternAndRelease)
+{
+	// Threads keep interning, copying and dropping the same rules, so the last reference is released while others intern
+	// it again; every reference must stay valid and the rule set must be freed once all are gone.
+	FCharacterStateMachineSettings Settings;
+	Settings.SprintingMinSpeed = 614.f;
+	const int32 NumBefore = FCharacterStateRuleSet::GetNumInterned();
+
+	constexpr int32 NumThreads = 8;
+	constexpr int32 NumRounds = 20000;
+	std::vector<std::thread> Threads;
+	std::vector<int32> NumWrong(NumThreads, 0);
+	for (int32 Thread = 0; Thread < NumThreads; ++Thread)
+	{
+		Threads.emplace_back([&Settings, &NumWrong, Thread]()
+		{
+			for (int32 Round = 0; Round < NumRounds; ++Round)
+			{
+				const FCharacterStateRuleSetRef Rules = FCharacterStateRuleSet::Intern(CharacterStateRules::Default, Settings);
+				const FCharacterStateRuleSetRef Copy = Rules;
+				NumWrong[Thread] += Copy->Settings.SprintingMinSpeed == 614.f && Copy->GetRefCount() >= 2u ? 0 : 1;
+			}
+		});
+	}
+	for (std::thread& Thread : Threads)
+	{
+		Thread.join();
+	}
+
+	for (int32 Thread = 0; Thread < NumThreads; ++Thread)
+	{
+		EXPECT_EQ(NumWrong[Thread], 0);
+	}
+	EXPECT_EQ(FCharacterStateRuleSet::GetNumInterned(), NumBefore);
+}
+
+// ---- Regions ----
+TEST(CharacterStateMachine, RegionBlockedByLocomotion)
+{
+	FTestCharacter Character;
+	const int32 Region = Character.Machine.AddRegion(CharacterStateRules::DefaultActions);
+	ASSERT_NE(Region, INDEX_NONE);
+
+	const uint8 Aiming = static_cast<uint8>(ECharacterActionState::Aiming);
+	ASSERT_TRUE(Character.Machine.SwitchRegionState(Region, Aiming));
+	Character.Environment.SetSpeed(800.0);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+	EXPECT_EQ(Character.Machine.GetRegionState(Region), static_cast<uint8>(ECharacterActionState::None));
+	EXPECT_FALSE(Character.Machine.CanEnterRegionState(Region, Aiming));
+}
+
+TEST(CharacterStateMachine, TimedRegionStateRunsOut)
+{
+	FTestCharacter Character;
+	const int32 Region = Character.Machine.AddRegion(CharacterStateRules::DefaultActions);
+	EXPECT_NE(Character.Machine.AddRegion(CharacterStateRules::DefaultActions), INDEX_NONE);
+	EXPECT_EQ(Character.Machine.AddRegion(CharacterStateRules::DefaultActions), INDEX_NONE);
+
+	const uint8 Melee = static_cast<uint8>(ECharacterActionState::Melee);
+	ASSERT_TRUE(Character.Machine.SwitchRegionState(Region, Melee));
+	EXPECT_EQ(Character.Environment.NumRegionStateChanges, 1);
+	EXPECT_FALSE(Character.Machine.SwitchRegionState(Region, static_cast<uint8>(ECharacterActionState::Aiming)));
+
+	Character.Machine.Tick(0.5f);
+	EXPECT_EQ(Character.Machine.GetRegionState(Region), Melee);
+	EXPECT_FALSE(Character.Machine.HasRegionUpdate());
+	Character.Machine.Tick(0.1f);
+	EXPECT_EQ(Character.Machine.GetRegionState(Region), static_cast<uint8>(ECharacterActionState::None));
+	EXPECT_EQ(Character.Environment.NumRegionStateChanges, 2);
+}
+
+// ---- Animation triggers ----
+TEST(CharacterStateMachine, BuiltinStatesSetTheirAnimTrigger)
+{
+	FTestCharacter Character;
+	EXPECT_EQ(Character.Environment.ActiveAnimTrigger, "IdleTrigger");
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_EQ(Character.Environment.ActiveAnimTrigger, "WalkingTrigger");
+
+	Character.Environment.bGrounded = false;
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::MidAir);
+	EXPECT_EQ(Character.Environment.ActiveAnimTrigger, "MidAirTrigger");
+}
+
+// ---- Rollback ----
+TEST(CharacterStateMachine, SnapshotRestoresWithoutSideEffects)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.DefaultCapsuleHalfHeight = 88.f;
+	FTestCharacter Character(Settings);
+
+	FCharacterStateMachineSnapshot Snapshot;
+	Character.Machine.SaveSnapshot(Snapshot);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	const int32 NumCapsuleUpdates = Character.Environment.NumCapsuleUpdates;
+
+	Character.Machine.RestoreSnapshot(Snapshot);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+	EXPECT_EQ(Character.Environment.NumCapsuleUpdates, NumCapsuleUpdates);
+	EXPECT_EQ(Character.Environment.ActiveAnimTrigger, "CrouchTrigger");
+	EXPECT_TRUE(Character.Machine.NeedsReconcile());
+
+	Character.Machine.ReconcileSideEffects();
+	EXPECT_EQ(Character.Environment.CapsuleHalfHeight, 88.f);
+	EXPECT_EQ(Character.Environment.ActiveAnimTrigger, "IdleTrigger");
+	EXPECT_FALSE(Character.Machine.NeedsReconcile());
+}
+
+TEST(CharacterStateSnapshotRing, FindsOnlyTheLastCapacityFrames)
+{
+	FCharacterStateSnapshotRing Ring;
+	FCharacterStateMachineSnapshot Snapshot;
+	for (uint32 Frame = 0; Frame < FCharacterStateSnapshotRing::Capacity + 4; ++Frame)
+	{
+		Snapshot.TimeInState = static_cast<float>(Frame);
+		Ring.Save(Frame, Snapshot);
+	}
+	EXPECT_EQ(Ring.Find(3), nullptr);
+	ASSERT_NE(Ring.Find(4), nullptr);
+	EXPECT_EQ(Ring.Find(4)->TimeInState, 4.f);
+	EXPECT_EQ(Ring.Find(FCharacterStateSnapshotRing::Capacity + 4), nullptr);
+
+	Ring.Reset();
+	EXPECT_EQ(Ring.Find(4), nullptr);
+}
+
+TEST(CharacterStateMachine, SnapshotRestoresRoute)
+{
+	FTestCharacter Character;
+	Character.Environment.SetSpeed(800.0);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting));
+
+	// A route started after the snapshot is dropped by restoring it.
+	FCharacterStateMachineSnapshot BeforeRoute;
+	Character.Machine.SaveSnapshot(BeforeRoute);
+	ASSERT_TRUE(Character.Machine.RequestStateVia(ECharacterState::Crouch));
+	FCharacterStateMachineSnapshot DuringRoute;
+	Character.Machine.SaveSnapshot(DuringRoute);
+	EXPECT_TRUE(DuringRoute.bHasRoute);
+
+	Character.Machine.RestoreSnapshot(BeforeRoute);
+	EXPECT_FALSE(Character.Machine.HasRoute());
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sprinting);
+
+	// A route that ended after the snapshot resumes.
+	Character.Machine.RestoreSnapshot(DuringRoute);
+	EXPECT_TRUE(Character.Machine.HasRoute());
+	EXPECT_EQ(Character.Machine.GetRouteTarget(), ECharacterState::Crouch);
+	Character.Machine.Tick(FrameTime);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Crouch);
+	EXPECT_FALSE(Character.Machine.HasRoute());
+}
+
+TEST(CharacterStateBatchBenchmark, ChunksMatchSerialTick)
+{
+	const FCharacterStateBatchBenchmarkReport Serial = FCharacterStateBatchBenchmark::Run(257, 240, 1);
+	EXPECT_EQ(Serial.NumMismatches, 0u);
+	EXPECT_GT(Serial.NumSwitches, 0u);
+	EXPECT_GT(Serial.NumSerialSuppressed, 0u);
+	EXPECT_EQ(Serial.NumSuppressed, Serial.NumSerialSuppressed);
+	for (int32 NumChunks = 2; NumChunks <= 8; ++NumChunks)
+	{
+		const FCharacterStateBatchBenchmarkReport Chunked = FCharacterStateBatchBenchmark::Run(257, 240, NumChunks);
+		EXPECT_EQ(Chunked.NumMismatches, 0u) << NumChunks << " chunks";
+		EXPECT_EQ(Chunked.NumSwitches, Serial.NumSwitches) << NumChunks << " chunks";
+		EXPECT_EQ(Chunked.SwitchHash, Serial.SwitchHash) << NumChunks << " chunks";
+		EXPECT_EQ(Chunked.NumSuppressed, Chunked.NumSerialSuppressed) << NumChunks << " chunks";
+	}
+}
+
+TEST(CharacterStateRollbackBenchmark, Deterministic)
+{
+	const FCharacterStateRollbackBenchmarkReport Report = FCharacterStateRollbackBenchmark::Run(64, 10, 4);
+	EXPECT_EQ(Report.NumMismatches, 0u);
+}
+
+// ---- Latent states ----
+TEST(CharacterStateMachine, AwaitEventSleepsUntilSignalled)
+{
+	class FAwaitingState final : public FCharacterBaseState
+	{
+	public:
+		explicit FAwaitingState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::Grapple)
+		{
+		}
+
+		virtual void Enter() override { StateManager->AwaitEvent(7, 1); }
+		virtual void Resume(int32 Linkage) override { LastLinkage = Linkage; }
+
+		int32 LastLinkage = 0;
+	};
+
+	FTestCharacter Character;
+	FAwaitingState* Grapple = new FAwaitingState(&Character.Machine);
+	Character.Machine.RegisterState(Grapple);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Grapple));
+	EXPECT_TRUE(Character.Machine.IsSuspended());
+
+	EXPECT_FALSE(Character.Machine.SignalEvent(8));
+	EXPECT_TRUE(Character.Machine.SignalEvent(7));
+	EXPECT_EQ(Grapple->LastLinkage, 1);
+	EXPECT_FALSE(Character.Machine.IsSuspended());
+	EXPECT_EQ(Character.Environment.NumResumes, 1);
+}
+
+// ---- Stats ----
+TEST(CharacterStateStats, CountsTransitionsRejectionsTimeAndHooks)
+{
+	FTestCharacter Character;
+	EXPECT_EQ(Character.Machine.GetStats(), nullptr);
+	Character.Machine.SetCollectStats(true);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::WallRun));
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	Character.Machine.Tick(0.25f);
+
+	const FCharacterStateStats* Stats = Character.Machine.GetStats();
+	ASSERT_NE(Stats, nullptr);
+	const uint8 Idle = static_cast<uint8>(ECharacterState::Idle);
+	const uint8 Walking = static_cast<uint8>(ECharacterState::Walking);
+	const uint8 Crouch = static_cast<uint8>(ECharacterState::Crouch);
+	EXPECT_EQ(Stats->Transitions[Idle][Walking], 1u);
+	EXPECT_EQ(Stats->Transitions[Walking][Crouch], 1u);
+	EXPECT_EQ(Stats->Rejected[Walking][static_cast<uint8>(ECharacterState::WallRun)], 1u);
+	EXPECT_EQ(Stats->GetNumTransitions(), 2u);
+	EXPECT_EQ(Stats->GetNumRejected(), 1u);
+	EXPECT_FLOAT_EQ(static_cast<float>(Stats->TimeInState[Crouch]), 0.25f);
+	EXPECT_EQ(Stats->HookCalls[Crouch][static_cast<uint8>(ECharacterStateHook::Enter)], 1u);
+	EXPECT_EQ(Stats->HookCalls[Walking][static_cast<uint8>(ECharacterStateHook::Exit)], 1u);
+
+	// Paused stats are kept but no longer grow; the world view is their sum.
+	Character.Machine.SetCollectStats(false);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Idle));
+	EXPECT_EQ(Stats->GetNumTransitions(), 2u);
+
+	FCharacterStateStats Sum;
+	Sum.Accumulate(*Stats);
+	Sum.Accumulate(*Stats);
+	EXPECT_EQ(Sum.Transitions[Idle][Walking], 2u);
+	EXPECT_EQ(Sum.GetNumRejected(), 2u);
+}
+
+// ---- Trace ----
+TEST(CharacterStateTrace, RecordsTransitionsNewestFirst)
+{
+	FCharacterStateTrace::Reset();
+	FCharacterStateTrace::bEnabled = true;
+	FTestCharacter Character;
+	Character.Machine.SetTraceOwnerId(42);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::WallRun));
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	FCharacterStateTrace::bEnabled = false;
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Idle));
+
+	// Refused and untraced transitions leave no record.
+	FCharacterStateTraceRecord Records[4];
+	ASSERT_EQ(FCharacterStateTrace::GetRecent(Records, 4), 2);
+	EXPECT_EQ(Records[0].OwnerId, 42u);
+	EXPECT_EQ(Records[0].From, ECharacterState::Walking);
+	EXPECT_EQ(Records[0].To, ECharacterState::Crouch);
+	EXPECT_EQ(Records[1].From, ECharacterState::Idle);
+	EXPECT_EQ(Records[1].To, ECharacterState::Walking);
+	EXPECT_GE(Records[0].TimeSeconds, Records[1].TimeSeconds);
+}
+
+TEST(CharacterStateTrace, KeepsTheLastCapacityRecords)
+{
+	FCharacterStateTrace::Reset();
+	FCharacterStateTrace::bEnabled = true;
+	FTestCharacter Character;
+	for (int32 Step = 0; Step < FCharacterStateTrace::Capacity + 3; ++Step)
+	{
+		ASSERT_TRUE(Character.Machine.SwitchStateByEnum(Step % 2 == 0 ? ECharacterState::Walking : ECharacterState::Idle));
+	}
+	FCharacterStateTrace::bEnabled = false;
+
+	FCharacterStateTraceRecord Records[FCharacterStateTrace::Capacity + 8];
+	EXPECT_EQ(FCharacterStateTrace::GetNumRecorded(), static_cast<uint64>(FCharacterStateTrace::Capacity + 3));
+	EXPECT_EQ(FCharacterStateTrace::GetRecent(Records, FCharacterStateTrace::Capacity + 8), FCharacterStateTrace::Capacity);
+	EXPECT_EQ(Records[0].To, ECharacterState::Walking);
+	FCharacterStateTrace::Reset();
+}
+
+// ---- Record and replay ----
+TEST(CharacterStateRecording, ReplayMatchesRecording)
+{
+	FTestCharacter Character;
+	FCharacterStateRecorder Recorder(4096);
+	Character.Machine.SetRecorder(&Recorder);
+	for (int32 Frame = 0; Frame < 600; ++Frame)
+	{
+		const int32 Phase = Frame % 90;
+		Character.Environment.bGrounded = Phase < 70 || Phase > 80;
+		Character.Environment.SetSpeed(Phase < 40 ? 800.0 : 200.0);
+		if (Phase == 5)
+		{
+			Character.Machine.SwitchStateByEnum(ECharacterState::Sprinting);
+		}
+		else if (Phase == 50)
+		{
+			Character.Machine.RequestStateVia(ECharacterState::Crouch);
+		}
+		Character.Machine.Tick(FrameTime);
+	}
+	Character.Machine.SetRecorder(nullptr);
+	ASSERT_FALSE(Recorder.HasOverflowed());
+
+	std::vector<uint8> Bytes(static_cast<size_t>(Recorder.GetSerializedSize()));
+	Recorder.Serialize(Bytes.data());
+	FCharacterStateRecordingView View;
+	ASSERT_TRUE(FCharacterStateRecordingView::FromBytes(Bytes.data(), static_cast<int64>(Bytes.size()), View));
+
+	FCharacterStateReplayer Replayer;
+	const FCharacterStateReplayReport Report = Replayer.Replay(View);
+	EXPECT_EQ(Report.NumFrames, 600u);
+	EXPECT_GT(Report.NumTransitions, 0u);
+	EXPECT_EQ(Report.NumDivergences, 0u);
+}
+
+TEST(CharacterStateRecording, OverflowDropsEntriesAndRejectsBadBytes)
+{
+	FTestCharacter Character;
+	FCharacterStateRecorder Recorder(8);
+	Character.Machine.SetRecorder(&Recorder);
+	for (int32 Frame = 0; Frame < 20; ++Frame)
+	{
+		Character.Machine.Tick(FrameTime);
+	}
+	Character.Machine.SetRecorder(nullptr);
+	EXPECT_TRUE(Recorder.HasOverflowed());
+	EXPECT_EQ(Recorder.GetNum(), 8);
+
+	std::vector<uint8> Bytes(static_cast<size_t>(Recorder.GetSerializedSize()));
+	Recorder.Serialize(Bytes.data());
+	FCharacterStateRecordingView View;
+	EXPECT_FALSE(FCharacterStateRecordingView::FromBytes(Bytes.data(), static_cast<int64>(Bytes.size()) - 1, View));
+	Bytes[0] ^= 0xff;
+	EXPECT_FALSE(FCharacterStateRecordingView::FromBytes(Bytes.data(), static_cast<int64>(Bytes.size()), View));
+}
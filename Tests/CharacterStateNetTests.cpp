@@ -0,0 +1,200 @@
+
+#include "Tests/CharacterStateTestEnvironment.h"
+#include "CharacterStateManagement/CharacterStateNet.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	/** Server character: every transition advances the replicated state, as UCharacterStateManagerComponent does on the authority. */
+	class FServerEnvironment final : public FTestCharacterEnvironment
+	{
+	public:
+		virtual void OnStateChanged(ECharacterState PreviousState, ECharacterState NewState) override
+		{
+			FTestCharacterEnvironment::OnStateChanged(PreviousState, NewState);
+			Sync->NotifyAuthorityTransition(NewState);
+		}
+
+		FCharacterStateNetSync* Sync = nullptr;
+	};
+
+	/**
+	 * A server, its owning client and a simulated proxy in one process. Replicate() sends what the component's replicated
+	 * properties carry: the packed state byte and the acked prediction id.
+	 */
+	struct FLoopback
+	{
+		FLoopback()
+			: Server(ServerEnvironment)
+			, ServerSync(Server)
+			, ClientSync(Client.Machine)
+			, ProxySync(Proxy.Machine)
+		{
+			ServerEnvironment.Sync = &ServerSync;
+			Server.Start(CharacterStateRules::Default, FCharacterStateMachineSettings());
+		}
+
+		void Replicate()
+		{
+			const FCharacterStateNetState State = FCharacterStateNetState::Unpack(ServerSync.GetAuthoritativeState().Pack());
+			ClientSync.ReceiveAuthoritativeState(State, ServerSync.GetAckedPredictionId(), false);
+			ProxySync.ReceiveAuthoritativeState(State, 0, true);
+		}
+
+		/** Sends the client's prediction to the server; a rejected local switch sends nothing. */
+		bool Predict(ECharacterState NewState)
+		{
+			const int32 PredictionId = ClientSync.PredictSwitch(NewState);
+			if (PredictionId == INDEX_NONE)
+			{
+				return false;
+			}
+			ServerSync.ServerHandlePrediction(NewState, static_cast<uint8>(PredictionId));
+			return true;
+		}
+
+		FServerEnvironment ServerEnvironment;
+		FCharacterStateMachine Server;
+		FCharacterStateNetSync ServerSync;
+
+		FTestCharacter Client;
+		FCharacterStateNetSync ClientSync;
+
+		FTestCharacter Proxy;
+		FCharacterStateNetSync ProxySync;
+	};
+}
+
+TEST(CharacterStateNet, PackRoundTrips)
+{
+	for (uint8 Sequence = 0; Sequence <= FCharacterStateNetState::SequenceMask; ++Sequence)
+	{
+		for (int32 State = 0; State < NumCharacterStates; ++State)
+		{
+			FCharacterStateNetState NetState;
+			NetState.State = static_cast<ECharacterState>(State);
+			NetState.Sequence = Sequence;
+			EXPECT_EQ(FCharacterStateNetState::Unpack(NetState.Pack()), NetState);
+		}
+	}
+}
+
+TEST(CharacterStateNet, ConfirmedPredictionRunsNoSecondTransition)
+{
+	FLoopback Net;
+	ASSERT_TRUE(Net.Predict(ECharacterState::Crouch));
+	EXPECT_EQ(Net.Server.GetCurrentStateEnum(), ECharacterState::Crouch);
+	Net.Replicate();
+	EXPECT_EQ(Net.Client.GetState(), ECharacterState::Crouch);
+	EXPECT_EQ(Net.Client.Environment.NumStateChanges, 1);
+	EXPECT_EQ(Net.ClientSync.GetNumCorrections(), 0u);
+	EXPECT_EQ(Net.Proxy.GetState(), ECharacterState::Crouch);
+}
+
+TEST(CharacterStateNet, RejectedPredictionCorrectedByAckAlone)
+{
+	FLoopback Net;
+	ASSERT_TRUE(Net.Predict(ECharacterState::Sprinting));
+	Net.Replicate();
+	ASSERT_EQ(Net.Server.GetCurrentStateEnum(), ECharacterState::Sprinting);
+
+	// The client drops to Walking on its own and crouches from there; the server is still Sprinting and refuses the crouch.
+	ASSERT_TRUE(Net.Client.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	const uint8 SequenceBefore = Net.ServerSync.GetAuthoritativeState().Sequence;
+	ASSERT_TRUE(Net.Predict(ECharacterState::Crouch));
+	EXPECT_EQ(Net.Server.GetCurrentStateEnum(), ECharacterState::Sprinting);
+
+	// Only the ack changed: the same state and sequence arrive again, and answer the request at once.
+	EXPECT_EQ(Net.ServerSync.GetAuthoritativeState().Sequence, SequenceBefore);
+	Net.Replicate();
+	EXPECT_EQ(Net.Client.GetState(), ECharacterState::Sprinting);
+	EXPECT_EQ(Net.ClientSync.GetNumCorrections(), 1u);
+}
+
+TEST(CharacterStateNet, UnacknowledgedPredictionHoldsUpdates)
+{
+	FLoopback Net;
+	const int32 PredictionId = Net.ClientSync.PredictSwitch(ECharacterState::Crouch);
+	ASSERT_NE(PredictionId, INDEX_NONE);
+
+	// A server update sent before the request arrived must not undo the prediction, however long it takes.
+	ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Walking));
+	Net.Replicate();
+	Net.ClientSync.Update(1.f);
+	EXPECT_EQ(Net.Client.GetState(), ECharacterState::Crouch);
+
+	Net.ServerSync.ServerHandlePrediction(ECharacterState::Crouch, static_cast<uint8>(PredictionId));
+	Net.Replicate();
+	EXPECT_EQ(Net.Client.GetState(), ECharacterState::Crouch);
+	EXPECT_EQ(Net.ClientSync.GetNumCorrections(), 0u);
+}
+
+TEST(CharacterStateNet, LocalMismatchCorrectedAfterDelay)
+{
+	FLoopback Net;
+	ASSERT_TRUE(Net.Client.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	Net.Replicate();
+	Net.ClientSync.Update(Net.ClientSync.CorrectionDelay * 0.5f);
+	EXPECT_EQ(Net.Client.GetState(), ECharacterState::Walking);
+	Net.ClientSync.Update(Net.ClientSync.CorrectionDelay * 0.6f);
+	EXPECT_EQ(Net.Client.GetState(), ECharacterState::Idle);
+	EXPECT_EQ(Net.ClientSync.GetNumCorrections(), 1u);
+}
+
+TEST(CharacterStateNet, SequenceWraps)
+{
+	FLoopback Net;
+	static const ECharacterState Cycle[] = { ECharacterState::Walking, ECharacterState::Sprinting, ECharacterState::Walking, ECharacterState::Crouch, ECharacterState::Idle };
+
+	// Three laps of the 5-bit sequence, replicated after every transition.
+	for (int32 Step = 0; Step < 3 * (FCharacterStateNetState::SequenceMask + 1); ++Step)
+	{
+		const ECharacterState Target = Cycle[Step % 5];
+		ASSERT_TRUE(Net.Server.SwitchStateByEnum(Target));
+		EXPECT_EQ(Net.ServerSync.GetAuthoritativeState().Sequence, (Step + 1) & FCharacterStateNetState::SequenceMask);
+		Net.Replicate();
+		ASSERT_EQ(Net.Proxy.GetState(), Target) << "step " << Step;
+	}
+}
+
+TEST(CharacterStateNet, IsNewerWindow)
+{
+	EXPECT_TRUE(FCharacterStateNetState::IsNewer(1, 0));
+	EXPECT_TRUE(FCharacterStateNetState::IsNewer(15, 0));
+	EXPECT_FALSE(FCharacterStateNetState::IsNewer(16, 0));
+	EXPECT_FALSE(FCharacterStateNetState::IsNewer(0, 0));
+	EXPECT_TRUE(FCharacterStateNetState::IsNewer(0, 31));
+	EXPECT_TRUE(FCharacterStateNetState::IsNewer(14, 31));
+	EXPECT_FALSE(FCharacterStateNetState::IsNewer(31, 0));
+}
+
+TEST(CharacterStateNet, ProxyMissingSixteenTransitionsWaitsForTheWindow)
+{
+	FLoopback Net;
+	ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Walking));
+	Net.Replicate();
+	ASSERT_EQ(Net.Proxy.GetState(), ECharacterState::Walking);
+
+	// 16 transitions between two updates look like a stale update, so the proxy keeps its state (documented on IsNewer()).
+	for (int32 Step = 0; Step < 8; ++Step)
+	{
+		ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Crouch));
+		ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Walking));
+	}
+	ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Idle));
+	ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Crouch));
+	Net.Replicate();
+	EXPECT_EQ(Net.Proxy.GetState(), ECharacterState::Walking);
+
+	// It only catches up when the sequence comes round again: 32 transitions after the last update it accepted.
+	for (int32 Step = 18; Step < FCharacterStateNetState::SequenceMask; ++Step)
+	{
+		ASSERT_TRUE(Net.Server.SwitchStateByEnum(Step % 2 == 0 ? ECharacterState::Idle : ECharacterState::Crouch));
+		Net.Replicate();
+		EXPECT_NE(Net.Proxy.GetState(), Net.Server.GetCurrentStateEnum()) << "step " << Step;
+	}
+	ASSERT_TRUE(Net.Server.SwitchStateByEnum(ECharacterState::Walking));
+	Net.Replicate();
+	EXPECT_EQ(Net.Proxy.GetState(), ECharacterState::Walking);
+	EXPECT_EQ(Net.Server.GetCurrentStateEnum(), ECharacterState::Walking);
+}
@@ -0,0 +1,159 @@
+
+#include "CharacterStateManagement/CharacterStateRequestChannel.h"
+#include "CharacterStateManagement/CharacterStateTransitionTable.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(CharacterStateRequestChannel, DrainsInPostingOrder)
+{
+	FCharacterStateRequestChannel Channel;
+	EXPECT_TRUE(Channel.IsEmpty());
+	const uint32 First = Channel.Post(ECharacterState::Crouch);
+	const uint32 Second = Channel.Post(ECharacterState::Idle);
+	ASSERT_NE(First, 0u);
+	EXPECT_EQ(Second, First + 1);
+	EXPECT_FALSE(Channel.HasDrained(First));
+
+	ECharacterState Targets[2] = {};
+	uint32 Sequences[2] = {};
+	int32 NumHandled = 0;
+	EXPECT_EQ(Channel.Drain([&](ECharacterState Target, uint32 Sequence)
+	{
+		Targets[NumHandled] = Target;
+		Sequences[NumHandled] = Sequence;
+		++NumHandled;
+	}), 2);
+	EXPECT_EQ(Targets[0], ECharacterState::Crouch);
+	EXPECT_EQ(Targets[1], ECharacterState::Idle);
+	EXPECT_EQ(Sequences[0], First);
+	EXPECT_EQ(Sequences[1], Second);
+	EXPECT_TRUE(Channel.HasDrained(Second));
+	EXPECT_TRUE(Channel.IsEmpty());
+}
+
+TEST(CharacterStateRequestChannel, DrainedOnlyAfterHandled)
+{
+	FCharacterStateRequestChannel Channel;
+	const uint32 First = Channel.Post(ECharacterState::Crouch);
+	const uint32 Second = Channel.Post(ECharacterState::Idle);
+	ASSERT_NE(First, 0u);
+	ASSERT_NE(Second, 0u);
+
+	int32 NumHandled = 0;
+	const int32 NumDrained = Channel.Drain([&](ECharacterState Target, uint32 Sequence)
+	{
+		// Neither the request being handled nor the ones after it may look handled yet.
+		EXPECT_FALSE(Channel.HasDrained(Sequence));
+		EXPECT_FALSE(Channel.HasDrained(Second));
+		EXPECT_EQ(Channel.HasDrained(First), Sequence == Second);
+		++NumHandled;
+	});
+	EXPECT_EQ(NumDrained, 2);
+	EXPECT_EQ(NumHandled, 2);
+	EXPECT_TRUE(Channel.HasDrained(First));
+	EXPECT_TRUE(Channel.HasDrained(Second));
+}
+
+TEST(CharacterStateRequestChannel, FullChannelDropsRequests)
+{
+	FCharacterStateRequestChannel Channel;
+	for (uint32 Index = 0; Index < FCharacterStateRequestChannel::Capacity; ++Index)
+	{
+		ASSERT_NE(Channel.Post(ECharacterState::Walking), 0u);
+	}
+	EXPECT_EQ(Channel.Post(ECharacterState::Walking), 0u);
+	Channel.Drain([](ECharacterState, uint32) {});
+	EXPECT_NE(Channel.Post(ECharacterState::Walking), 0u);
+}
+
+TEST(CharacterStateRequestChannel, DrainCallbackMayPost)
+{
+	// A request handled on the game thread may post a follow-up; it is drained by the same call.
+	FCharacterStateRequestChannel Channel;
+	ASSERT_NE(Channel.Post(ECharacterState::Walking), 0u);
+	int32 NumHandled = 0;
+	EXPECT_EQ(Channel.Drain([&](ECharacterState Target, uint32)
+	{
+		if (Target == ECharacterState::Walking)
+		{
+			EXPECT_NE(Channel.Post(ECharacterState::Sprinting), 0u);
+		}
+		++NumHandled;
+	}), 2);
+	EXPECT_EQ(NumHandled, 2);
+}
+
+TEST(CharacterStateRequestChannel, ManyProducersDrainEveryRequestOnceInOrder)
+{
+	// 16 producer threads retry full posts until each has NumPerProducer requests accepted; one consumer drains meanwhile.
+	// Every accepted sequence number must be drained exactly once, in sequence order, with the target posted under it.
+	constexpr int32 NumProducers = 16;
+	constexpr int32 NumPerProducer = 5000;
+	constexpr uint32 NumRequests = NumProducers * NumPerProducer;
+
+	FCharacterStateRequestChannel Channel;
+	std::vector<ECharacterState> PostedTargets(NumRequests + 1, ECharacterState::Idle);
+	std::vector<int32> NumPosted(NumRequests + 1, 0);
+	std::atomic<int32> NumProducersDone{ 0 };
+
+	std::vector<std::thread> Producers;
+	for (int32 Producer = 0; Producer < NumProducers; ++Producer)
+	{
+		Producers.emplace_back([&, Producer]()
+		{
+			for (int32 Index = 0; Index < NumPerProducer; ++Index)
+			{
+				const ECharacterState Target = static_cast<ECharacterState>((Producer + Index) % NumCharacterStates);
+				uint32 Sequence = 0;
+				while ((Sequence = Channel.Post(Target)) == 0)
+				{
+					std::this_thread::yield();
+				}
+				if (Sequence <= NumRequests)
+				{
+					PostedTargets[Sequence] = Target;
+					++NumPosted[Sequence];
+				}
+			}
+			NumProducersDone.fetch_add(1, std::memory_order_release);
+		});
+	}
+
+	std::vector<uint32> DrainedSequences;
+	std::vector<ECharacterState> DrainedTargets;
+	DrainedSequences.reserve(NumRequests);
+	DrainedTargets.reserve(NumRequests);
+	const auto Drain = [&]()
+	{
+		return Channel.Drain([&](ECharacterState Target, uint32 Sequence)
+		{
+			DrainedSequences.push_back(Sequence);
+			DrainedTargets.push_back(Target);
+		});
+	};
+	while (NumProducersDone.load(std::memory_order_acquire) < NumProducers)
+	{
+		if (Drain() == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	for (std::thread& Producer : Producers)
+	{
+		Producer.join();
+	}
+	Drain();
+
+	EXPECT_TRUE(Channel.IsEmpty());
+	ASSERT_EQ(DrainedSequences.size(), static_cast<size_t>(NumRequests));
+	int32 NumWrong = 0;
+	for (uint32 Index = 0; Index < NumRequests; ++Index)
+	{
+		const uint32 Sequence = DrainedSequences[Index];
+		NumWrong += Sequence == Index + 1 && NumPosted[Sequence] == 1 && DrainedTargets[Index] == PostedTargets[Sequence] ? 0 : 1;
+	}
+	EXPECT_EQ(NumWrong, 0);
+	EXPECT_TRUE(Channel.HasDrained(NumRequests));
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CharacterStateManagement/CharacterStateEnvironment.h"
+#include "CharacterStateManagement/CharacterStateMachine.h"
+#include <string>
+
+/** Plain character for the core tests: movement inputs set by the test, side effects counted. */
+class FTestCharacterEnvironment : public ICharacterStateEnvironment
+{
+public:
+	virtual bool IsGrounded() const override
+	{
+		++NumGroundedQueries;
+		return bGrounded;
+	}
+
+	virtual FCharacterStateVector GetLinearVelocity() const override
+	{
+		++NumVelocityQueries;
+		return Velocity;
+	}
+
+	virtual void SetLinearVelocity(const FCharacterStateVector& InVelocity) override { Velocity = InVelocity; }
+
+	virtual void UpdateCapsuleHalfHeight(float NewHalfHeight, bool) override
+	{
+		CapsuleHalfHeight = NewHalfHeight;
+		++NumCapsuleUpdates;
+	}
+
+	virtual void SetAnimTrigger(const TCHAR* TriggerName) override { ActiveAnimTrigger = TriggerName; }
+
+	virtual void ResetAnimTrigger(const TCHAR* TriggerName) override
+	{
+		if (ActiveAnimTrigger == TriggerName)
+		{
+			ActiveAnimTrigger.clear();
+		}
+	}
+
+	virtual void OnStateChanged(ECharacterState, ECharacterState) override { ++NumStateChanges; }
+	virtual void OnRegionStateChanged(int32, uint8, uint8) override { ++NumRegionStateChanges; }
+	virtual void OnStateResumed(ECharacterState) override { ++NumResumes; }
+	virtual const TCHAR* GetDebugName() const override { return TEXT("Test"); }
+
+	void SetSpeed(double Speed)
+	{
+		Velocity = FCharacterStateVector();
+		Velocity.X = Speed;
+	}
+
+	bool bGrounded = true;
+	FCharacterStateVector Velocity;
+	float CapsuleHalfHeight = 0.f;
+
+	/** The trigger last set and not reset since; empty if none. */
+	std::string ActiveAnimTrigger;
+
+	int32 NumCapsuleUpdates = 0;
+	int32 NumStateChanges = 0;
+	int32 NumRegionStateChanges = 0;
+	int32 NumResumes = 0;
+	mutable int32 NumGroundedQueries = 0;
+	mutable int32 NumVelocityQueries = 0;
+};
+
+/** An environment and a machine on it, started with the default rules and Settings. */
+struct FTestCharacter
+{
+	explicit FTestCharacter(const FCharacterStateMachineSettings& Settings = FCharacterStateMachineSettings())
+		: Machine(Environment)
+	{
+		Machine.Start(CharacterStateRules::Default, Settings);
+	}
+
+	ECharacterState GetState() const { return Machine.GetCurrentStateEnum(); }
+
+	FTestCharacterEnvironment Environment;
+	FCharacterStateMachine Machine;
+};
@@ -0,0 +1,55 @@
+
+#include "CharacterStateManagement/CharacterStateTickLOD.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	float Squared(float Distance)
+	{
+		return Distance * Distance;
+	}
+}
+
+TEST(CharacterStateTickLOD, LevelsFollowDistance)
+{
+	const CharacterStateTickLOD::FSettings Settings;
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(0.f, Settings), 0);
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.HalfRateDistance), Settings), 1);
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.QuarterRateDistance), Settings), 2);
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.EighthRateDistance), Settings), 3);
+}
+
+TEST(CharacterStateTickLOD, BiasLeavesFullRateAlone)
+{
+	const CharacterStateTickLOD::FSettings Settings;
+	for (uint8 Bias = 0; Bias <= CharacterStateTickLOD::MaxLevel; ++Bias)
+	{
+		EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(0.f, Settings, Bias), 0);
+		EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.HalfRateDistance - 1.f), Settings, Bias), 0);
+	}
+}
+
+TEST(CharacterStateTickLOD, BiasIsClampedToMaxLevel)
+{
+	const CharacterStateTickLOD::FSettings Settings;
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.HalfRateDistance), Settings, 1), 2);
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.HalfRateDistance), Settings, 5), CharacterStateTickLOD::MaxLevel);
+	EXPECT_EQ(CharacterStateTickLOD::ComputeLevel(Squared(Settings.EighthRateDistance), Settings, 1), CharacterStateTickLOD::MaxLevel);
+}
+
+TEST(CharacterStateTickLOD, EveryPhaseRunsOncePerInterval)
+{
+	for (uint8 Level = 0; Level <= CharacterStateTickLOD::MaxLevel; ++Level)
+	{
+		const uint32 Interval = 1u << Level;
+		for (uint32 Phase = 0; Phase < 3 * CharacterStateTickLOD::MaxFrameInterval; ++Phase)
+		{
+			uint32 NumTicks = 0;
+			for (uint64 Frame = 0; Frame < Interval; ++Frame)
+			{
+				NumTicks += CharacterStateTickLOD::ShouldTick(Frame, Phase, Level) ? 1 : 0;
+			}
+			EXPECT_EQ(NumTicks, 1u) << "Level " << int32(Level) << ", phase " << Phase;
+		}
+	}
+}
@@ -0,0 +1,253 @@
+
+#include "Tests/CharacterStateTestEnvironment.h"
+#include "CharacterStateManagement/CharacterBaseState.h"
+#include "CharacterStateManagement/CharacterStateLatent.h"
+#include "CharacterStateManagement/CharacterStateTimers.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr float FrameTime = 1.f / 60.f;
+
+	/** Every timer fires exactly once, on the first Advance() that reaches its deadline, unless it was cancelled first. */
+	void CheckWheel(double Resolution, double MaxSeconds, double StepSeconds)
+	{
+		constexpr int32 NumTimers = 2000;
+		std::mt19937 Random(42);
+		std::uniform_real_distribution<double> Seconds(0.0, MaxSeconds);
+
+		FCharacterStateTimerWheel Wheel(Resolution);
+		std::vector<FCharacterStateTimer> Timers(NumTimers);
+		std::vector<int32> NumFired(NumTimers, 0);
+		std::vector<bool> Cancelled(NumTimers, false);
+		for (FCharacterStateTimer& Timer : Timers)
+		{
+			Wheel.Schedule(Timer, Seconds(Random));
+		}
+		for (int32 Index = 0; Index < NumTimers; Index += 7)
+		{
+			Wheel.Cancel(Timers[Index]);
+			Cancelled[Index] = true;
+		}
+
+		for (int32 Step = 0; Wheel.GetNum() > 0; ++Step)
+		{
+			ASSERT_LT(Step, 10000000);
+			const double Before = Wheel.GetTime();
+			Wheel.Advance(StepSeconds * (Step % 97 == 0 ? 37.0 : 1.0));
+			while (FCharacterStateTimer* Timer = Wheel.PopExpired())
+			{
+				EXPECT_LE(Timer->Deadline, Wheel.GetTime());
+				EXPECT_GT(Timer->Deadline, Before - 1e-9);
+				++NumFired[Timer - Timers.data()];
+			}
+		}
+		for (int32 Index = 0; Index < NumTimers; ++Index)
+		{
+			EXPECT_EQ(NumFired[Index], Cancelled[Index] ? 0 : 1) << Index;
+		}
+	}
+
+	/** Grapple that sets its own timeout and handles it. */
+	class FTimedGrappleState final : public FCharacterBaseState
+	{
+	public:
+		explicit FTimedGrappleState(FCharacterStateMachine* InOwner)
+			: FCharacterBaseState(InOwner, ECharacterState::Grapple)
+		{
+		}
+
+		virtual void Enter() override { StateManager->SetStateTimeout(0.3f); }
+		virtual void Timeout() override
+		{
+			++NumTimeouts;
+			StateManager->SwitchStateByEnum(ECharacterState::MidAir);
+		}
+
+		int32 NumTimeouts = 0;
+	};
+}
+
+// ---- Timing wheel ----
+TEST(CharacterStateTimerWheel, FiresAtDeadline)
+{
+	CheckWheel(FCharacterStateTimerWheel::DefaultResolution, 5.0, FrameTime);
+}
+
+TEST(CharacterStateTimerWheel, CascadesAndOverflows)
+{
+	// 64^4 ticks of 1/64 s is about 73 hours: some timers start in the overflow list.
+	CheckWheel(1.0 / 64.0, 400000.0, 60.0);
+}
+
+TEST(CharacterStateTimerWheel, RescheduleAndPopAny)
+{
+	FCharacterStateTimerWheel Wheel;
+	FCharacterStateTimer Timer;
+	Wheel.Schedule(Timer, 1.0);
+	Wheel.Schedule(Timer, 2.0);
+	EXPECT_EQ(Wheel.GetNum(), 1);
+	EXPECT_EQ(Wheel.Advance(1.5), 0);
+	EXPECT_EQ(Wheel.Advance(0.5), 1);
+	EXPECT_EQ(Wheel.PopAny(), &Timer);
+	EXPECT_FALSE(Timer.IsScheduled());
+	EXPECT_EQ(Wheel.PopAny(), nullptr);
+}
+
+// ---- State timeouts ----
+TEST(CharacterStateTimeouts, ExpireInTickWithoutScheduler)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.5f;
+	FTestCharacter Character(Settings);
+	Character.Environment.SetSpeed(300.0);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sliding));
+	EXPECT_TRUE(Character.Machine.HasStateTimeout());
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+	Character.Machine.Tick(0.4f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sliding);
+	Character.Machine.Tick(0.11f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Walking);
+	EXPECT_EQ(Character.Machine.GetNumTimeouts(), 1u);
+	EXPECT_FALSE(Character.Machine.HasStateTimeout());
+}
+
+TEST(CharacterStateTimeouts, ExpireOnSchedulerWithoutTick)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::WallRun)] = 0.5f;
+	FTestCharacter Character(Settings);
+	FCharacterStateLatentScheduler Scheduler;
+	Character.Machine.SetLatentScheduler(&Scheduler);
+
+	Character.Environment.bGrounded = false;
+	Character.Machine.Tick(FrameTime);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::WallRun));
+	EXPECT_FALSE(Character.Machine.NeedsTick());
+
+	Scheduler.Update(0.4f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::WallRun);
+	Scheduler.Update(0.11f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::MidAir);
+	EXPECT_EQ(Scheduler.GetNumTimedOut(), 1u);
+	EXPECT_EQ(Character.Environment.NumResumes, 1);
+}
+
+TEST(CharacterStateTimeouts, CancelledOnExit)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.5f;
+	FTestCharacter Character(Settings);
+	FCharacterStateLatentScheduler Scheduler;
+	Character.Machine.SetLatentScheduler(&Scheduler);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sliding));
+	EXPECT_EQ(Scheduler.GetWheel().GetNum(), 1);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_FALSE(Character.Machine.HasStateTimeout());
+	EXPECT_EQ(Scheduler.GetWheel().GetNum(), 0);
+}
+
+TEST(CharacterStateTimeouts, RegisteredStateHandlesTimeout)
+{
+	FTestCharacter Character;
+	FTimedGrappleState* Grapple = new FTimedGrappleState(&Character.Machine);
+	Character.Machine.RegisterState(Grapple);
+	Character.Environment.bGrounded = false;
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Grapple));
+
+	Character.Machine.Tick(0.2f);
+	EXPECT_EQ(Grapple->NumTimeouts, 0);
+	Character.Machine.Tick(0.2f);
+	EXPECT_EQ(Grapple->NumTimeouts, 1);
+	EXPECT_EQ(Character.GetState(), ECharacterState::MidAir);
+}
+
+TEST(CharacterStateTimeouts, SchedulerDestroyedFallsBackToTick)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.5f;
+	FTestCharacter Character(Settings);
+	{
+		FCharacterStateLatentScheduler Scheduler;
+		Character.Machine.SetLatentScheduler(&Scheduler);
+		ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sliding));
+		Scheduler.Update(0.2f);
+		EXPECT_NEAR(Character.Machine.GetStateTimeoutLeft(), 0.3f, 1e-4f);
+	}
+	EXPECT_EQ(Character.Machine.GetLatentScheduler(), nullptr);
+	EXPECT_TRUE(Character.Machine.NeedsTick());
+	Character.Machine.Tick(0.35f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+}
+
+TEST(CharacterStateTimeouts, SnapshotKeepsTimeLeft)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.MaxTimeInState[static_cast<uint8>(ECharacterState::Sliding)] = 0.5f;
+	FTestCharacter Character(Settings);
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Sliding));
+	Character.Machine.Tick(0.4f);
+
+	FCharacterStateMachineSnapshot Snapshot;
+	Character.Machine.SaveSnapshot(Snapshot);
+	EXPECT_TRUE(Snapshot.bHasStateTimeout);
+	EXPECT_NEAR(Snapshot.StateTimeoutLeft, 0.1f, 1e-4f);
+
+	Character.Machine.Tick(0.2f);
+	ASSERT_EQ(Character.GetState(), ECharacterState::Idle);
+	Character.Machine.RestoreSnapshot(Snapshot);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sliding);
+	Character.Machine.Tick(0.05f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Sliding);
+	Character.Machine.Tick(0.06f);
+	EXPECT_EQ(Character.GetState(), ECharacterState::Idle);
+}
+
+// ---- Cooldowns ----
+TEST(CharacterStateCooldowns, BlockReentry)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.Cooldown[static_cast<uint8>(ECharacterState::Crouch)] = 1.f;
+	FTestCharacter Character(Settings);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Walking));
+	EXPECT_TRUE(Character.Machine.IsCoolingDown(ECharacterState::Crouch));
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+
+	Character.Machine.AdvanceStateTime(0.6f);
+	EXPECT_FALSE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	Character.Machine.AdvanceStateTime(0.5f);
+	EXPECT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+}
+
+TEST(CharacterStateCooldowns, AuthorityIgnoresCooldown)
+{
+	FCharacterStateMachineSettings Settings;
+	Settings.Cooldown[static_cast<uint8>(ECharacterState::Crouch)] = 1.f;
+	FTestCharacter Character(Settings);
+
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Crouch));
+	ASSERT_TRUE(Character.Machine.SwitchStateByEnum(ECharacterState::Idle));
+	EXPECT_TRUE(Character.Machine.SetStateFromAuthority(ECharacterState::Crouch));
+}
+
+// ---- Benchmarks ----
+TEST(CharacterStateTimeoutBenchmark, VariantsAgree)
+{
+	const FCharacterStateTimeoutBenchmarkReport Report = FCharacterStateTimeoutBenchmark::Run(400, 300);
+	EXPECT_EQ(Report.NumMismatches, 0u);
+	EXPECT_GT(Report.NumTimeouts, 0u);
+	EXPECT_LT(Report.NumWheelTicks, Report.NumPollingTicks);
+}
+
+TEST(CharacterStateLatentBenchmark, VariantsAgree)
+{
+	const FCharacterStateLatentBenchmarkReport Report = FCharacterStateLatentBenchmark::Run(400, 300);
+	EXPECT_EQ(Report.NumMismatches, 0u);
+	EXPECT_LT(Report.NumLatentTicks, Report.NumPollingTicks);
+}